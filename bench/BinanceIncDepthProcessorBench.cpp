@@ -0,0 +1,96 @@
+#include "../src/BinanceIncDepthProcessor.h"
+#include "../src/DepthUpdateGenerator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t messages_num = 1024;
+
+std::chrono::milliseconds now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+}
+
+struct Payloads
+{
+    explicit Payloads(const size_t book_depth, const size_t levels_per_update)
+        : generator([&] {
+            binance::DepthUpdateGenerator::Config config;
+            config.book_depth = book_depth;
+            config.levels_per_update = levels_per_update;
+            return config;
+        }())
+    {
+        generator.snapshot(snapshot, now_ms());
+        updates.resize(messages_num);
+        for (auto & u : updates) {
+            generator.next(u, now_ms());
+        }
+    }
+
+    binance::DepthUpdateGenerator generator;
+    std::string snapshot;
+    std::vector<std::string> updates;
+};
+
+}
+
+// args: book depth, levels per message
+static void BM_Process(benchmark::State & state)
+{
+    const Payloads payloads(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)));
+    binance::BinanceIncDepthProcessor processor(true);
+    processor.process(payloads.snapshot);
+    size_t i = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const auto & msg = payloads.updates[i++ % messages_num];
+        bytes += msg.size();
+        benchmark::DoNotOptimize(processor.process(msg));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_Process)->Args({1000, 2})->Args({1000, 10})->Args({1000, 50})->Args({10000, 10});
+
+// args: book depth, levels kept hot
+static void BM_ProcessMaxDepth(benchmark::State & state)
+{
+    const Payloads payloads(static_cast<size_t>(state.range(0)), 10);
+    binance::BinanceIncDepthProcessor processor(true, {static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1))});
+    processor.process(payloads.snapshot);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.process(payloads.updates[i++ % messages_num]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessMaxDepth)->Args({10000, 0})->Args({10000, 100})->Args({10000, 1000});
+
+static void BM_ProcessStatisticsOnly(benchmark::State & state)
+{
+    const Payloads payloads(1000, static_cast<size_t>(state.range(0)));
+    binance::BinanceIncDepthProcessor processor(false);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(processor.process(payloads.updates[i++ % messages_num]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessStatisticsOnly)->Arg(2)->Arg(10)->Arg(50);
+
+static void BM_GetOrderBook(benchmark::State & state)
+{
+    const Payloads payloads(static_cast<size_t>(state.range(0)), 10);
+    binance::BinanceIncDepthProcessor processor(true);
+    processor.process(payloads.snapshot);
+    for (auto _ : state) {
+        auto ob = processor.get_order_book();
+        benchmark::DoNotOptimize(ob);
+    }
+}
+BENCHMARK(BM_GetOrderBook)->RangeMultiplier(10)->Range(100, 100000);
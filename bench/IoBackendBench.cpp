@@ -0,0 +1,92 @@
+#include "../src/BinanceIncDepthProcessor.h"
+#include "../src/BinanceWebSocketConnector.h"
+#include "../src/DepthStubServer.h"
+#include "../src/IoUring.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr auto interval = 200ms;
+
+// Whether the kernel allows a ring, the connector falls back to epoll otherwise
+bool io_uring_available()
+{
+    try {
+        uring::Receiver receiver(1, 4096);
+        return true;
+    } catch (const std::system_error &) {
+        return false;
+    }
+}
+
+}
+
+// args: io backend (0 epoll, 1 io_uring), messages per second of the stub server, burst size.
+// Every iteration is an interval of the stream read on loopback; msgs/s/core is per CPU second
+// of the connector thread, latency is of the processor from the event time of the stub server,
+// which has millisecond resolution for both backends
+static void BM_Receive(benchmark::State & state)
+{
+    const auto backend = state.range(0) == 0 ? IoBackend::Epoll : IoBackend::IoUring;
+    if (backend == IoBackend::IoUring && !io_uring_available()) {
+        state.SkipWithError("io_uring is not available");
+        return;
+    }
+
+    binance::DepthStubServer::Config config;
+    config.listeners.push_back({"127.0.0.1", 0});
+    config.rate = static_cast<double>(state.range(1));
+    config.burst_size = static_cast<size_t>(state.range(2));
+    binance::DepthStubServer server(std::move(config));
+    server.start();
+
+    auto processor = std::make_shared<binance::BinanceIncDepthProcessor>(true);
+    processor->set_silent(true);
+    auto connector = binance::BinanceWebSocketConnector::make_depth_connector("127.0.0.1", server.get_ports().front(), {"btcusdt"}, processor);
+    connector->set_io_backend(backend);
+    connector->start();
+
+    // the first messages pay for the handshake and the snapshot
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (connector->get_transport_statistics().messages < 100) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            connector->stop();
+            state.SkipWithError("no messages from the stub server");
+            return;
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto start_messages = connector->get_transport_statistics().messages;
+    const auto start_cpu = connector->get_cpu_time();
+    for (auto _ : state) {
+        std::this_thread::sleep_for(interval);
+        state.SetIterationTime(std::chrono::duration<double>(interval).count());
+    }
+    const auto messages = connector->get_transport_statistics().messages - start_messages;
+    const auto cpu = std::chrono::duration<double>(connector->get_cpu_time() - start_cpu).count();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const auto summary = processor->get_window_summary(std::chrono::seconds(static_cast<int64_t>(std::ceil(elapsed))));
+    connector->stop();
+    server.stop();
+
+    state.SetItemsProcessed(static_cast<int64_t>(messages));
+    state.counters["msgs/s"] = messages / elapsed;
+    state.counters["msgs/s/core"] = cpu > 0 ? messages / cpu : 0;
+    state.counters["p50_us"] = static_cast<double>(summary.p50_us);
+    state.counters["p99_us"] = static_cast<double>(summary.p99_us);
+}
+BENCHMARK(BM_Receive)
+        ->Args({0, 5000, 1})->Args({1, 5000, 1})
+        ->Args({0, 50000, 10})->Args({1, 50000, 10})
+        ->Iterations(10)->UseManualTime()->Unit(benchmark::kMillisecond);
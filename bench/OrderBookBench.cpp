@@ -0,0 +1,189 @@
+#include "../src/OrderBook.h"
+#include "../src/OrderBookRenderer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr double tick = 0.01;
+constexpr double mid = 50000;
+
+OrderBook make_book(const size_t levels_num)
+{
+    OrderBook ob;
+    for (size_t i = 0; i < levels_num; ++i) {
+        ob.insert_replace(mid - tick * (i + 1), 1 + i % 7, OrderBook::Side::Bid);
+        ob.insert_replace(mid + tick * (i + 1), 1 + i % 7, OrderBook::Side::Ask);
+    }
+    return ob;
+}
+
+// Indices of levels to touch, generated up front so RNG cost is not measured
+std::vector<size_t> make_indices(const size_t levels_num, const size_t count, const bool skew_to_top)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<size_t> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto u = uniform(rng);
+        ret.push_back(static_cast<size_t>((skew_to_top ? u * u * u : u) * levels_num));
+    }
+    return ret;
+}
+
+}
+
+// Volume change and remove/re-insert of the best levels
+static void BM_InsertReplace_TopOfBook(benchmark::State & state)
+{
+    const auto levels_num = static_cast<size_t>(state.range(0));
+    auto ob = make_book(levels_num);
+    const auto indices = make_indices(4, 1024, false);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto idx = indices[i++ & 1023];
+        const auto bid = mid - tick * (idx + 1);
+        const auto ask = mid + tick * (idx + 1);
+        ob.insert_replace(bid, 0, OrderBook::Side::Bid);
+        ob.insert_replace(ask, 0, OrderBook::Side::Ask);
+        ob.insert_replace(bid, 2 + idx, OrderBook::Side::Bid);
+        ob.insert_replace(ask, 2 + idx, OrderBook::Side::Ask);
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_InsertReplace_TopOfBook)->RangeMultiplier(10)->Range(100, 100000);
+
+// Same as above through the side specific entry point, without the runtime side switch
+static void BM_InsertReplace_TopOfBook_StaticSide(benchmark::State & state)
+{
+    const auto levels_num = static_cast<size_t>(state.range(0));
+    auto ob = make_book(levels_num);
+    const auto indices = make_indices(4, 1024, false);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto idx = indices[i++ & 1023];
+        const auto bid = mid - tick * (idx + 1);
+        const auto ask = mid + tick * (idx + 1);
+        ob.insert_replace<OrderBook::Side::Bid>(bid, 0);
+        ob.insert_replace<OrderBook::Side::Ask>(ask, 0);
+        ob.insert_replace<OrderBook::Side::Bid>(bid, 2 + idx);
+        ob.insert_replace<OrderBook::Side::Ask>(ask, 2 + idx);
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_InsertReplace_TopOfBook_StaticSide)->RangeMultiplier(10)->Range(100, 100000);
+
+// Remove/re-insert of the worst levels, i.e. shortest memmove on vector storage
+static void BM_InsertReplace_Deep(benchmark::State & state)
+{
+    const auto levels_num = static_cast<size_t>(state.range(0));
+    auto ob = make_book(levels_num);
+    const auto indices = make_indices(4, 1024, false);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto idx = levels_num - 1 - indices[i++ & 1023];
+        const auto bid = mid - tick * (idx + 1);
+        const auto ask = mid + tick * (idx + 1);
+        ob.insert_replace(bid, 0, OrderBook::Side::Bid);
+        ob.insert_replace(ask, 0, OrderBook::Side::Ask);
+        ob.insert_replace(bid, 2, OrderBook::Side::Bid);
+        ob.insert_replace(ask, 2, OrderBook::Side::Ask);
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_InsertReplace_Deep)->RangeMultiplier(10)->Range(100, 100000);
+
+// Uniformly distributed remove/re-insert over the whole book
+static void BM_InsertReplace_Random(benchmark::State & state)
+{
+    const auto levels_num = static_cast<size_t>(state.range(0));
+    auto ob = make_book(levels_num);
+    const auto indices = make_indices(levels_num, 4096, false);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto idx = indices[i++ & 4095];
+        const auto bid = mid - tick * (idx + 1);
+        const auto ask = mid + tick * (idx + 1);
+        ob.insert_replace(bid, 0, OrderBook::Side::Bid);
+        ob.insert_replace(ask, 0, OrderBook::Side::Ask);
+        ob.insert_replace(bid, 3, OrderBook::Side::Bid);
+        ob.insert_replace(ask, 3, OrderBook::Side::Ask);
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_InsertReplace_Random)->RangeMultiplier(10)->Range(100, 100000);
+
+// Top-skewed volume updates of existing levels, the common case for live feeds
+static void BM_InsertReplace_Skewed(benchmark::State & state)
+{
+    const auto levels_num = static_cast<size_t>(state.range(0));
+    auto ob = make_book(levels_num);
+    const auto indices = make_indices(levels_num, 4096, true);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto idx = indices[i++ & 4095];
+        ob.insert_replace(mid - tick * (idx + 1), 1 + (i & 7), OrderBook::Side::Bid);
+        ob.insert_replace(mid + tick * (idx + 1), 1 + (i & 7), OrderBook::Side::Ask);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_InsertReplace_Skewed)->RangeMultiplier(10)->Range(100, 100000);
+
+static void BM_OrderBookCopy(benchmark::State & state)
+{
+    const auto ob = make_book(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto copy = ob;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_OrderBookCopy)->RangeMultiplier(10)->Range(100, 100000);
+
+// args: book levels, levels to print (-1 prints all of them)
+static void BM_OrderBookPrint(benchmark::State & state)
+{
+    const auto ob = make_book(static_cast<size_t>(state.range(0)));
+    const auto levels_to_show = state.range(1) < 0 ? size_t(-1) : static_cast<size_t>(state.range(1));
+    std::ostringstream oss;
+    for (auto _ : state) {
+        oss.str({});
+        ob.print(oss, levels_to_show);
+        benchmark::DoNotOptimize(oss);
+    }
+}
+BENCHMARK(BM_OrderBookPrint)
+    ->Args({100, 20})->Args({100, -1})
+    ->Args({1000, 20})->Args({1000, -1})
+    ->Args({10000, 20})->Args({10000, -1});
+
+// args: book levels, levels to render; the book changes at the top between reports
+static void BM_OrderBookRenderFull(benchmark::State & state)
+{
+    auto ob = make_book(static_cast<size_t>(state.range(0)));
+    OrderBookRenderer renderer(static_cast<size_t>(state.range(1)));
+    const auto best_bid = ob.get_bids().front().price;
+    double volume = 1;
+    for (auto _ : state) {
+        ob.insert_replace(best_bid, volume += 1, OrderBook::Side::Bid);
+        benchmark::DoNotOptimize(renderer.render_full(ob));
+    }
+}
+BENCHMARK(BM_OrderBookRenderFull)->Args({1000, 20})->Args({10000, 20})->Args({10000, 1000});
+
+static void BM_OrderBookRenderDiff(benchmark::State & state)
+{
+    auto ob = make_book(static_cast<size_t>(state.range(0)));
+    OrderBookRenderer renderer(static_cast<size_t>(state.range(1)));
+    const auto best_bid = ob.get_bids().front().price;
+    double volume = 1;
+    for (auto _ : state) {
+        ob.insert_replace(best_bid, volume += 1, OrderBook::Side::Bid);
+        benchmark::DoNotOptimize(renderer.render(ob));
+    }
+}
+BENCHMARK(BM_OrderBookRenderDiff)->Args({1000, 20})->Args({10000, 20})->Args({10000, 1000});
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Local arrival times of order book update ids on one stream of one
+// endpoint. Diff depth, partial depth and bookTicker streams of a symbol
+// share the update id sequence, so their logs tell which stream delivers
+// a book change first and by how much. The feed thread adds the last id
+// of every message, readers look up when an id was first covered. Only
+// the newest capacity messages are kept.
+class ArrivalLog
+{
+public:
+    static constexpr size_t capacity = 1 << 16;
+
+    // Ids not above the last one are ignored, e.g. of a repeated snapshot
+    void add(const uint64_t last_id, const uint64_t ticks)
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_arrivals.empty() && last_id <= m_arrivals.back().first) {
+            return;
+        }
+        if (m_arrivals.size() == capacity) {
+            m_arrivals.pop_front();
+        }
+        m_arrivals.emplace_back(last_id, ticks);
+    }
+
+    // Ticks of the first message with last id not below id, 0 if it has not
+    // come yet or the id is not newer than the oldest logged message, which
+    // covers everything before the log started
+    uint64_t covered_at(const uint64_t id) const
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_arrivals.empty() || id <= m_arrivals.front().first || id > m_arrivals.back().first) {
+            return 0;
+        }
+        const auto it = std::lower_bound(m_arrivals.begin(), m_arrivals.end(), id, [] (const auto & a, const uint64_t v) {
+            return a.first < v;
+        });
+        return it->second;
+    }
+
+    // The last logged id, 0 if there is none
+    uint64_t frontier() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_arrivals.empty() ? 0 : m_arrivals.back().first;
+    }
+
+    // Appends logged ids in (from, to]
+    void collect_ids(const uint64_t from, const uint64_t to, std::vector<uint64_t> & out) const
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto & [id, ticks] : m_arrivals) {
+            if (id > from && id <= to) {
+                out.push_back(id);
+            }
+        }
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::deque<std::pair<uint64_t, uint64_t>> m_arrivals; // last id, tsc ticks
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Tells which listener delivered an update first. Listeners of the same
+// stream call arrive() with the update id, the first caller for an id wins.
+// Ids are hashed into a fixed ring of the newest ids seen per slot, so a
+// listener lagging by more than the ring size simply loses.
+class ArrivalRace
+{
+public:
+    static constexpr size_t slots_num = 1 << 14;
+
+    ArrivalRace()
+        : m_slots(std::make_unique<std::atomic<uint64_t>[]>(slots_num))
+    { }
+
+    bool arrive(const uint64_t update_id)
+    {
+        auto & slot = m_slots[update_id & (slots_num - 1)];
+        auto seen = slot.load(std::memory_order_relaxed);
+        while (seen < update_id) {
+            if (slot.compare_exchange_weak(seen, update_id, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> m_slots;
+};
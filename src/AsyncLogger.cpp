@@ -0,0 +1,202 @@
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+namespace logging {
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+}
+
+AsyncLogger::AsyncLogger(const size_t slots_num, std::FILE * out)
+    : m_slots_num(slots_num)
+    , m_max_record_slots(slots_num / 8)
+    , m_file(out)
+    , m_slots(slots_num)
+{
+    assert(slots_num >= 8 && (slots_num & (slots_num - 1)) == 0);
+    for (uint64_t i = 0; i < m_slots_num; ++i) {
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    m_out.reserve(1 << 20);
+    m_thread = std::thread([this] { run(); });
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void AsyncLogger::push(const char * file, const int line, const char * data, const size_t size)
+{
+    const RecordHeader header{std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(),
+                              file, line, static_cast<uint32_t>(size)};
+    const auto slots = (sizeof(header) + size + payload_size - 1) / payload_size;
+    if (slots > m_max_record_slots) {
+        write_sync(header, data);
+        return;
+    }
+
+    uint64_t pos = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+        // Consumer frees slots in order, so if the last one is free all are
+        const auto last = pos + slots - 1;
+        const auto seq = slot(last).seq.load(std::memory_order_acquire);
+        if (seq == last) {
+            if (m_head.compare_exchange_weak(pos, pos + slots, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (seq < last) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    char record_start[payload_size];
+    std::memcpy(record_start, &header, sizeof(header));
+    const auto first_chunk = std::min(size, payload_size - sizeof(header));
+    std::memcpy(record_start + sizeof(header), data, first_chunk);
+    size_t written = first_chunk;
+    for (uint64_t i = 1; i < slots; ++i) {
+        auto & s = slot(pos + i);
+        const auto chunk = std::min(size - written, payload_size);
+        std::memcpy(s.data, data + written, chunk);
+        written += chunk;
+        s.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    // header is published last, consumer does not need to wait for the tail
+    auto & first = slot(pos);
+    std::memcpy(first.data, record_start, payload_size);
+    first.seq.store(pos + 1, std::memory_order_release);
+}
+
+void AsyncLogger::flush()
+{
+    const auto head = m_head.load(std::memory_order_acquire);
+    while (m_written.load(std::memory_order_acquire) < head) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void AsyncLogger::run()
+{
+    for (;;) {
+        const bool running = m_running.load(std::memory_order_acquire);
+        bool consumed = false;
+        while (pop()) {
+            consumed = true;
+            if (m_out.size() > (1 << 16)) {
+                write_out();
+            }
+        }
+        if (const auto dropped = m_dropped.load(std::memory_order_relaxed); dropped != m_reported_dropped) {
+            m_out += "log ring is full, dropped records: " + std::to_string(dropped - m_reported_dropped) + "\n";
+            m_reported_dropped = dropped;
+            consumed = true;
+        }
+        if (consumed || !m_out.empty()) {
+            write_out();
+            continue;
+        }
+        if (!running) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool AsyncLogger::pop()
+{
+    auto & first = slot(m_tail);
+    if (first.seq.load(std::memory_order_acquire) != m_tail + 1) {
+        return false;
+    }
+    RecordHeader header;
+    std::memcpy(&header, first.data, sizeof(header));
+    const auto slots = (sizeof(header) + header.length + payload_size - 1) / payload_size;
+    for (uint64_t i = 1; i < slots; ++i) {
+        // producer publishes the header last, so the rest is already there
+        if (slot(m_tail + i).seq.load(std::memory_order_acquire) != m_tail + i + 1) {
+            return false;
+        }
+    }
+
+    append_prefix(header);
+    const auto first_chunk = std::min<size_t>(header.length, payload_size - sizeof(header));
+    m_out.append(first.data + sizeof(header), first_chunk);
+    size_t read = first_chunk;
+    for (uint64_t i = 1; i < slots; ++i) {
+        const auto chunk = std::min<size_t>(header.length - read, payload_size);
+        m_out.append(slot(m_tail + i).data, chunk);
+        read += chunk;
+    }
+    m_out += '\n';
+
+    for (uint64_t i = 0; i < slots; ++i) {
+        slot(m_tail + i).seq.store(m_tail + i + m_slots_num, std::memory_order_release);
+    }
+    m_tail += slots;
+    return true;
+}
+
+// Formatting of the date is done once per second
+void AsyncLogger::append_prefix(const RecordHeader & header)
+{
+    const auto seconds = header.ts / 1000000000;
+    if (seconds != m_cached_seconds) {
+        const time_t time = seconds;
+        tm tm;
+        localtime_r(&time, &tm);
+        m_cached_time_len = std::strftime(m_cached_time, sizeof(m_cached_time), "%F %T", &tm);
+        m_cached_seconds = seconds;
+    }
+    m_out.append(m_cached_time, m_cached_time_len);
+    m_out += ": ";
+    m_out += header.file;
+    m_out += '(';
+    char line[16];
+    m_out.append(line, std::to_chars(line, line + sizeof(line), header.line).ptr);
+    m_out += "): ";
+}
+
+void AsyncLogger::write_out()
+{
+    {
+        std::lock_guard lock(m_write_mutex);
+        std::fwrite(m_out.data(), 1, m_out.size(), m_file);
+        std::fflush(m_file);
+    }
+    m_out.clear();
+    m_written.store(m_tail, std::memory_order_release);
+}
+
+// Too long for the ring (e.g. full order book dumps), keeps order with what was logged before
+void AsyncLogger::write_sync(const RecordHeader & header, const char * data)
+{
+    flush();
+    const time_t time = header.ts / 1000000000;
+    tm tm;
+    localtime_r(&time, &tm);
+    char prefix[64];
+    const auto len = std::strftime(prefix, sizeof(prefix), "%F %T", &tm);
+    std::lock_guard lock(m_write_mutex);
+    std::fwrite(prefix, 1, len, m_file);
+    std::fprintf(m_file, ": %s(%d): ", header.file, header.line);
+    std::fwrite(data, 1, header.length, m_file);
+    std::fputc('\n', m_file);
+    std::fflush(m_file);
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+// Bounded MPSC ring of fixed size slots (Vyukov style sequence per slot).
+// A record takes one or more consecutive slots: header and payload bytes.
+// Producers claim all slots of a record with one CAS or drop the record when
+// the ring is full, they never wait for the consumer.
+class AsyncLogger
+{
+    struct RecordHeader
+    {
+        int64_t ts;
+        const char * file;
+        int32_t line;
+        uint32_t length;
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> seq;
+        char data[120];
+    };
+
+public:
+    static constexpr size_t payload_size = sizeof(Slot::data);
+    static constexpr size_t default_slots_num = 1 << 15;
+
+    // slots_num must be a power of two, records longer than an eighth of the
+    // ring are written synchronously
+    explicit AsyncLogger(size_t slots_num = default_slots_num, std::FILE * out = stdout);
+    ~AsyncLogger();
+
+    void push(const char * file, int line, const char * data, size_t size);
+
+    // Blocks until everything pushed so far is written
+    void flush();
+
+private:
+    void run();
+    bool pop();
+    void append_prefix(const RecordHeader & header);
+    void write_out();
+    void write_sync(const RecordHeader & header, const char * data);
+
+    Slot & slot(const uint64_t pos) { return m_slots[pos & (m_slots_num - 1)]; }
+
+private:
+    const uint64_t m_slots_num;
+    const uint64_t m_max_record_slots;
+    std::FILE * const m_file;
+    std::vector<Slot> m_slots;
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    alignas(64) std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<bool> m_running{true};
+
+    // consumer thread only
+    alignas(64) uint64_t m_tail = 0;
+    uint64_t m_reported_dropped = 0;
+    std::string m_out;
+    int64_t m_cached_seconds = -1;
+    char m_cached_time[32];
+    size_t m_cached_time_len = 0;
+
+    std::mutex m_write_mutex;
+    std::thread m_thread;
+};
+
+}
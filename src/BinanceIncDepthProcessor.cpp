@@ -1,105 +1,135 @@
 #include "BinanceIncDepthProcessor.h"
 
+#include "EventLatency.h"
 #include "Log.h"
+#include "ParseArena.h"
+#include "Tsc.h"
 
-#include <rapidjson/document.h>
+#include <cassert>
+#include <mutex>
 
 namespace binance {
 
-BinanceIncDepthProcessor::BinanceIncDepthProcessor(bool build_order_book)
-        : m_build_order_book(build_order_book)
+BinanceIncDepthProcessor::BinanceIncDepthProcessor(bool build_order_book, const OrderBookConfig & book_config, const std::vector<std::string> & symbols)
+        : BinanceStreamProcessor("BinanceIncDepthProcessor", build_order_book, book_config, symbols)
 { }
 
-bool BinanceIncDepthProcessor::process(const std::string_view data)
+BinanceIncDepthProcessor::~BinanceIncDepthProcessor() = default;
+
+void BinanceIncDepthProcessor::process(const std::string_view data, PipelineTrace & trace, const uint64_t arrival_ticks,
+                                       const std::chrono::system_clock::time_point now, std::unique_lock<std::shared_mutex> & lock)
 {
     LOG_LINE("BinanceIncDepthProcessor::process()");
 
-    try {
-        rapidjson::Document d;
-        d.Parse(data.data(), data.size());
-        assert(d.IsObject());
-
-        assert(d.HasMember("E"));
-        const auto ts = d["E"].GetInt64();
-        const std::chrono::milliseconds ms_ts(ts);
-
-        // Our delay cannot be more than seconds, therefore we do not need to convert
-        // timezones, just need to remove alignement to 15 minutes difference between
-        //  us and binance server
-
-        using namespace std::chrono_literals;
-
-        const std::chrono::system_clock::time_point event_ts(ms_ts);
-        const auto now = std::chrono::system_clock::now();
-        const auto diff = now - event_ts;
-        const auto abs_diff = diff > 0us ? diff : -diff;
-
-	    constexpr auto minimal_timezone_diff = 15min; // some timezones have 45 mins alignmenent, so 15 minutes here
-
-        const auto minutes_alignment = std::chrono::duration_cast<std::chrono::minutes>(abs_diff) / minimal_timezone_diff;
-        const auto minutes_diff = minutes_alignment * minimal_timezone_diff;
-
-        const auto latency = abs_diff - minutes_diff;
-
-        std::unique_lock lock(m_mutex);
+    m_arena->clear();
+    auto doc = m_arena->make_document();
+    doc.Parse(data.data(), data.size());
+    assert(doc.IsObject());
+    // combined streams wrap the event into {"stream":...,"data":{...}}
+    const ParseArena::Value & d = doc.HasMember("data") ? doc["data"] : doc;
+    if (!d.HasMember("E")) { // e.g. {"result":null,"id":1} reply to a subscription
+        LOG_LINE("BinanceIncDepthProcessor: skipping message without event time");
+        return;
+    }
+    const std::chrono::milliseconds ms_ts(d["E"].GetInt64());
+    const auto latency = event_latency(ms_ts, now);
+    m_metrics.on_message(data.size(), latency);
+
+    const auto symbol = d.HasMember("s") ? std::string_view(d["s"].GetString(), d["s"].GetStringLength()) : std::string_view();
+    const auto book_id = m_books.route(symbol);
+    const bool primary = book_id == 0;
+    const bool has_ids = d.HasMember("U") && d.HasMember("u");
+    const auto first_id = has_ids ? d["U"].GetUint64() : 0;
+    const auto last_id = has_ids ? d["u"].GetUint64() : 0;
+    // update ids of different symbols are unrelated, only the primary one races
+    const bool won = primary && has_ids && m_arrival_race && m_arrival_race->arrive(last_id);
+    if (primary && has_ids && m_arrival_log) {
+        m_arrival_log->add(last_id, arrival_ticks);
+    }
 
-        // TODO: add timer for timout of no updates, mark OrderBook as stale
-        m_stat.add_update(std::chrono::duration_cast<std::chrono::microseconds>(latency));
-        if (!m_build_order_book) {
-            return true;
+    trace.lap(Stage::Parse);
+    if (!lock.owns_lock()) {
+        lock.lock();
+    }
+    trace.lap(Stage::Lock);
+
+    m_stat.add_update(latency);
+    m_windowed_stat.add(now, latency, won);
+    if (book_id == BookManager::npos) {
+        LOG_LINE("BinanceIncDepthProcessor: skipping update of not subscribed symbol " << symbol);
+        m_pipeline_stat.add(trace);
+        return;
+    }
+    auto & entry = m_books[book_id];
+    std::unique_lock book_lock(entry.mutex);
+    if (has_ids) {
+        if (entry.last_update_id != 0 && first_id != entry.last_update_id + 1) {
+            ALWAYS_LOG("BinanceIncDepthProcessor: update ids gap of " << symbol << ", expected " << entry.last_update_id + 1
+                    << ", got " << first_id << ", order book is stale");
+            m_metrics.on_gap();
+            entry.consistent = false;
+            if (m_event_handler) {
+                m_event_handler(*this, FeedEvent::Gap);
+            }
+        }
+        entry.last_update_id = last_id;
+    }
+    if (!m_build_order_book) {
+        m_pipeline_stat.add(trace);
+        return;
+    }
+    auto & book = entry.book;
+    const bool collect_changes = primary && !m_publishers.empty();
+    const auto reallocations = book.get_reallocations();
+    const auto book_update_start = tsc::now();
+    if (d.HasMember("b")) {
+        const auto bids = d["b"].GetArray();
+        LOG_LINE("Bids size: " << bids.Size());
+        for (const auto & b : bids) {
+            const auto price_volume = b.GetArray();
+            assert(b.Size() == 2);
+            LOG_LINE("Price volume size: " << price_volume.Size());
+            LOG_LINE("Level: " << price_volume[1].GetString() << "@" << price_volume[0].GetString());
+            const auto price = to_double(price_volume[0]);
+            const auto volume = to_double(price_volume[1]);
+            trace.lap(Stage::Convert);
+            book.insert_replace<OrderBook::Side::Bid>(price, volume);
+            if (collect_changes) {
+                m_changes.push_back({OrderBook::Side::Bid, price, volume});
+            }
+            trace.lap(Stage::Book);
         }
-        if (d.HasMember("b")) {
-            const auto bids = d["b"].GetArray();
-            LOG_LINE("Bids size: " << bids.Size());
-            for (const auto & b : bids) {
-                const auto price_volume = b.GetArray();
-                assert(b.Size() == 2);
-                LOG_LINE("Price volume size: " << price_volume.Size());
-                const auto price_str = price_volume[0].GetString();
-                const auto volume_str = price_volume[1].GetString();
-                LOG_LINE("Level: " << volume_str << "@" << price_str);
-                m_order_book.insert_replace(std::stod(price_str), std::stod(volume_str), OrderBook::Side::Bid);
+    }
+    if (d.HasMember("a")) {
+        const auto asks = d["a"].GetArray();
+        LOG_LINE("Asks size: " << asks.Size());
+        for (const auto & a : asks) {
+            const auto price_volume = a.GetArray();
+            assert(a.Size() == 2);
+            LOG_LINE("Price volume size: " << price_volume.Size());
+            LOG_LINE("Level: " << price_volume[1].GetString() << "@" << price_volume[0].GetString());
+            const auto price = to_double(price_volume[0]);
+            const auto volume = to_double(price_volume[1]);
+            trace.lap(Stage::Convert);
+            book.insert_replace<OrderBook::Side::Ask>(price, volume);
+            if (collect_changes) {
+                m_changes.push_back({OrderBook::Side::Ask, price, volume});
             }
+            trace.lap(Stage::Book);
         }
-        if (d.HasMember("a")) {
-            const auto asks = d["a"].GetArray();
-            LOG_LINE("Asks size: " << asks.Size());
-            for (const auto & a : asks) {
-                const auto price_volume = a.GetArray();
-                assert(a.Size() == 2);
-                LOG_LINE("Price volume size: " << price_volume.Size());
-                const auto price_str = price_volume[0].GetString();
-                const auto volume_str = price_volume[1].GetString();
-                LOG_LINE("Level: " << volume_str << "@" << price_str);
-                m_order_book.insert_replace(std::stod(price_str), std::stod(volume_str), OrderBook::Side::Ask);
+    }
+    m_metrics.on_book_update(tsc::now() - book_update_start, book.get_reallocations() - reallocations);
+    if (primary) {
+        m_metrics.set_book_depth(book.get_bids_depth(), book.get_asks_depth());
+        if (entry.consistent && !m_publishers.empty()) {
+            const BookUpdate update{entry.last_update_id, ms_ts, book, m_changes};
+            for (const auto & publisher : m_publishers) {
+                publisher->publish(this, update);
             }
         }
-    } catch (const std::exception & e) {
-        failure(e.what());
+        m_changes.clear();
     }
-    return true;
-}
-
-void BinanceIncDepthProcessor::failure(const std::string_view reason)
-{
-    ALWAYS_LOG("BinanceIncDepthProcessor::failure(), reason: " << reason << ", building OB will be disabled");
-
-    std::unique_lock lock(m_mutex);
-    m_stat.clear();
-    m_order_book.clear();
-    m_build_order_book = false;
-}
-
-Statistics BinanceIncDepthProcessor::get_statistics() const
-{
-    std::shared_lock lock(m_mutex);
-    return m_stat;
-}
-
-OrderBook BinanceIncDepthProcessor::get_order_book() const
-{
-    std::shared_lock lock(m_mutex);
-    return m_order_book;
+    m_pipeline_stat.add(trace);
 }
 
 }
@@ -1,30 +1,34 @@
 #pragma once
 
-#include "OrderBook.h"
-#include "IJsonDataListener.h"
+#include "BinanceStreamProcessor.h"
+#include "FeedEvent.h"
 
-#include <shared_mutex>
+#include <string>
+#include <vector>
 
 namespace binance {
 
 class BinanceIncDepthProcessor final
-    : public IDepthDataListener
+    : public BinanceStreamProcessor
 {
 public:
-    BinanceIncDepthProcessor(bool build_order_book);
+    // Without symbols messages of any symbol go to a single book, otherwise
+    // to the book of their symbol, the first one is the primary book that
+    // is published and measured in metrics
+    BinanceIncDepthProcessor(bool build_order_book, const OrderBookConfig & book_config = OrderBookConfig(),
+                             const std::vector<std::string> & symbols = {});
+    ~BinanceIncDepthProcessor() final;
 
-    bool process(std::string_view data) final;
-    void failure(std::string_view reason) final;
+    void set_event_handler(FeedEventHandler handler) { m_event_handler = std::move(handler); }
 
-    Statistics get_statistics() const final;
-    OrderBook get_order_book() const final;
+    using BinanceStreamProcessor::process;
 
 private:
-    mutable std::shared_mutex m_mutex;
+    void process(std::string_view data, PipelineTrace & trace, uint64_t arrival_ticks, std::chrono::system_clock::time_point now,
+                 std::unique_lock<std::shared_mutex> & lock) final;
 
-    bool m_build_order_book;
-    OrderBook m_order_book;
-    Statistics m_stat;
+private:
+    FeedEventHandler m_event_handler;
 };
 
 }
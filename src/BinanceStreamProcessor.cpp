@@ -0,0 +1,94 @@
+#include "BinanceStreamProcessor.h"
+
+#include "Log.h"
+#include "ParseArena.h"
+#include "Tsc.h"
+
+#include <mutex>
+
+namespace binance {
+
+BinanceStreamProcessor::BinanceStreamProcessor(const char * name, const bool build_order_book, const OrderBookConfig & book_config,
+                                               const std::vector<std::string> & symbols)
+        : m_name(name)
+        , m_arena(std::make_unique<ParseArena>())
+        , m_build_order_book(build_order_book)
+        , m_books(symbols, book_config)
+{ }
+
+BinanceStreamProcessor::~BinanceStreamProcessor() = default;
+
+bool BinanceStreamProcessor::process(const std::string_view data, PipelineTrace & trace)
+{
+    const std::string_view batch[] = {data};
+    return process_batch(batch, trace);
+}
+
+bool BinanceStreamProcessor::process_batch(const std::span<const std::string_view> batch, PipelineTrace & trace)
+{
+    // messages of a batch arrived together, they share the arrival time and one lock of m_mutex
+    const auto arrival_ticks = tsc::now();
+    const auto now = std::chrono::system_clock::now();
+    std::unique_lock lock(m_mutex, std::defer_lock);
+    for (const auto data : batch) {
+        try {
+            process(data, trace, arrival_ticks, now, lock);
+        } catch (const std::exception & e) {
+            if (lock.owns_lock()) {
+                lock.unlock();
+            }
+            failure(e.what());
+        }
+        trace = PipelineTrace(); // the reading is traced with the first message only
+    }
+    return true;
+}
+
+void BinanceStreamProcessor::failure(const std::string_view reason)
+{
+    ALWAYS_LOG(m_name << "::failure(), reason: " << reason << ", building OB will be disabled");
+
+    m_metrics.on_failure();
+
+    std::unique_lock lock(m_mutex);
+    m_stat.clear();
+    m_windowed_stat.clear();
+    m_pipeline_stat.clear();
+    m_books.clear();
+    m_changes.clear();
+    m_build_order_book = false;
+}
+
+void BinanceStreamProcessor::session_lost(const std::string_view reason)
+{
+    ALWAYS_LOG(m_name << "::session_lost(), reason: " << reason << ", the book is built again from the next session");
+
+    std::unique_lock lock(m_mutex);
+    m_books.clear();
+    m_changes.clear();
+    m_metrics.on_session_lost();
+    m_metrics.set_book_depth(0, 0);
+    for (const auto & publisher : m_publishers) {
+        publisher->reset(this);
+    }
+}
+
+Statistics BinanceStreamProcessor::get_statistics() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_stat;
+}
+
+WindowSummary BinanceStreamProcessor::get_window_summary(const std::chrono::seconds window) const
+{
+    std::shared_lock lock(m_mutex);
+    return m_windowed_stat.summary(window);
+}
+
+PipelineStatistics BinanceStreamProcessor::get_pipeline_statistics() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_pipeline_stat;
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ArrivalLog.h"
+#include "ArrivalRace.h"
+#include "BookManager.h"
+#include "BookPublisher.h"
+#include "IJsonDataListener.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace binance {
+
+class ParseArena;
+
+// State and listener plumbing shared by the processors of Binance streams:
+// batching under one lock, statistics, books, publishers and the handling
+// of dropped sessions and failures. A processor parses one message in
+// process(data, trace, arrival_ticks, now, lock).
+class BinanceStreamProcessor
+    : public IDepthDataListener
+{
+public:
+    // Must be called before the connector is started
+    void add_publisher(std::shared_ptr<BookPublisher> publisher) { m_publishers.push_back(std::move(publisher)); }
+    // Shared by listeners of the same stream to count who delivered each update first
+    void set_arrival_race(std::shared_ptr<ArrivalRace> race) { m_arrival_race = std::move(race); }
+    // Gets update ids of the primary symbol with their arrival, see StreamComparison
+    void set_arrival_log(std::shared_ptr<ArrivalLog> log) { m_arrival_log = std::move(log); }
+
+    using IJsonDataListener::process;
+
+    bool process(std::string_view data, PipelineTrace & trace) final;
+    bool process_batch(std::span<const std::string_view> batch, PipelineTrace & trace) final;
+    void failure(std::string_view reason) final;
+    void session_lost(std::string_view reason) final;
+
+    Statistics get_statistics() const final;
+    WindowSummary get_window_summary(std::chrono::seconds window) const final;
+    PipelineStatistics get_pipeline_statistics() const final;
+    const ListenerMetrics & get_metrics() const final { return m_metrics; }
+    void set_silent(const bool silent) final { m_metrics.set_silent(silent); }
+    const BookManager & get_books() const final { return m_books; }
+
+protected:
+    // name prefixes the log lines of the processor
+    BinanceStreamProcessor(const char * name, bool build_order_book, const OrderBookConfig & book_config, const std::vector<std::string> & symbols);
+    ~BinanceStreamProcessor() override;
+
+    // lock of m_mutex is taken on the first message of a batch and kept
+    virtual void process(std::string_view data, PipelineTrace & trace, uint64_t arrival_ticks, std::chrono::system_clock::time_point now,
+                         std::unique_lock<std::shared_mutex> & lock) = 0;
+
+protected:
+    const char * const m_name;
+    std::unique_ptr<ParseArena> m_arena; // used by the feed thread only, before taking m_mutex
+
+    mutable std::shared_mutex m_mutex; // statistics, a book has its own lock in m_books
+
+    bool m_build_order_book;
+    BookManager m_books;
+    Statistics m_stat;
+    WindowedStatistics m_windowed_stat;
+    PipelineStatistics m_pipeline_stat;
+    ListenerMetrics m_metrics;
+    std::vector<std::shared_ptr<BookPublisher>> m_publishers;
+    std::vector<LevelChange> m_changes; // of the current message, collected for publishers only
+    std::shared_ptr<ArrivalRace> m_arrival_race;
+    std::shared_ptr<ArrivalLog> m_arrival_log;
+};
+
+}
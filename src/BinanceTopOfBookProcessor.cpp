@@ -0,0 +1,178 @@
+#include "BinanceTopOfBookProcessor.h"
+
+#include "EventLatency.h"
+#include "Log.h"
+#include "ParseArena.h"
+#include "Tsc.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <mutex>
+
+namespace binance {
+
+BinanceTopOfBookProcessor::BinanceTopOfBookProcessor(const StreamType stream, const bool build_order_book, const OrderBookConfig & book_config,
+                                                     const std::vector<std::string> & symbols)
+        : BinanceStreamProcessor("BinanceTopOfBookProcessor", build_order_book && has_book(stream), book_config, symbols)
+        , m_stream(stream)
+{
+    if (stream == StreamType::Depth) {
+        throw std::invalid_argument("depth stream is processed by BinanceIncDepthProcessor");
+    }
+}
+
+BinanceTopOfBookProcessor::~BinanceTopOfBookProcessor() = default;
+
+template <OrderBook::Side S>
+void BinanceTopOfBookProcessor::replace_best(OrderBook & book, const double price, const double volume, const bool collect_changes)
+{
+    const auto & levels = S == OrderBook::Side::Bid ? book.get_bids() : book.get_asks();
+    if (!levels.empty() && levels.front().price != price) {
+        const auto previous = levels.front().price;
+        book.insert_replace<S>(previous, 0);
+        if (collect_changes) {
+            m_changes.push_back({S, previous, 0});
+        }
+    }
+    book.insert_replace<S>(price, volume);
+    if (collect_changes) {
+        m_changes.push_back({S, price, volume});
+    }
+}
+
+template <OrderBook::Side S, class Levels>
+void BinanceTopOfBookProcessor::add_levels(OrderBook & book, const Levels & levels, const bool collect_changes)
+{
+    for (const auto & l : levels) {
+        const auto price_volume = l.GetArray();
+        const auto price = to_double(price_volume[0]);
+        const auto volume = to_double(price_volume[1]);
+        book.insert_replace<S>(price, volume);
+        if (collect_changes) {
+            m_changes.push_back({S, price, volume});
+        }
+    }
+}
+
+void BinanceTopOfBookProcessor::process(const std::string_view data, PipelineTrace & trace, const uint64_t arrival_ticks,
+                                        const std::chrono::system_clock::time_point now, std::unique_lock<std::shared_mutex> & lock)
+{
+    LOG_LINE("BinanceTopOfBookProcessor::process()");
+
+    m_arena->clear();
+    auto doc = m_arena->make_document();
+    doc.Parse(data.data(), data.size());
+    assert(doc.IsObject());
+    // combined streams wrap the event into {"stream":...,"data":{...}}
+    const bool combined = doc.HasMember("data");
+    const ParseArena::Value & d = combined ? doc["data"] : doc;
+    const char * id_field = nullptr;
+    switch (m_stream) {
+    case StreamType::PartialDepth: id_field = "lastUpdateId"; break;
+    case StreamType::BookTicker: id_field = "u"; break;
+    case StreamType::Trade: id_field = "t"; break;
+    default: id_field = "a"; break;
+    }
+    if (!d.HasMember(id_field)) { // e.g. {"result":null,"id":1} reply to a subscription
+        LOG_LINE("BinanceTopOfBookProcessor: skipping message without " << id_field);
+        return;
+    }
+    const auto time_field = d.HasMember("E") ? "E" : d.HasMember("T") ? "T" : nullptr;
+    const std::chrono::milliseconds ms_ts(time_field ? d[time_field].GetInt64() : 0);
+    const auto latency = event_latency(ms_ts, now);
+    if (time_field) {
+        m_metrics.on_message(data.size(), latency);
+    } else {
+        m_metrics.on_message(data.size());
+    }
+
+    // partial depth names its symbol in the stream name of a combined stream only
+    char symbol_buffer[SymbolTable::max_length];
+    std::string_view symbol;
+    if (d.HasMember("s")) {
+        symbol = std::string_view(d["s"].GetString(), d["s"].GetStringLength());
+    } else if (combined && doc.HasMember("stream")) {
+        const std::string_view stream(doc["stream"].GetString(), doc["stream"].GetStringLength());
+        const auto size = std::min(stream.find('@'), sizeof(symbol_buffer));
+        std::transform(stream.begin(), stream.begin() + size, symbol_buffer, [] (const unsigned char c) { return std::toupper(c); });
+        symbol = std::string_view(symbol_buffer, size);
+    }
+    const auto book_id = symbol.empty() ? 0 : m_books.route(symbol);
+    const bool primary = book_id == 0;
+    const auto update_id = d[id_field].GetUint64();
+    // ids of different symbols are unrelated, only the primary one races
+    const bool won = primary && m_arrival_race && m_arrival_race->arrive(update_id);
+    if (primary && m_arrival_log) {
+        m_arrival_log->add(update_id, arrival_ticks);
+    }
+
+    trace.lap(Stage::Parse);
+    if (!lock.owns_lock()) {
+        lock.lock();
+    }
+    trace.lap(Stage::Lock);
+
+    if (time_field) {
+        m_stat.add_update(latency);
+        m_windowed_stat.add(now, latency, won);
+    } else {
+        m_windowed_stat.add(now, won);
+    }
+    if (book_id == BookManager::npos) {
+        LOG_LINE("BinanceTopOfBookProcessor: skipping update of not subscribed symbol " << symbol);
+        m_pipeline_stat.add(trace);
+        return;
+    }
+    if (!m_build_order_book) {
+        m_pipeline_stat.add(trace);
+        return;
+    }
+
+    auto & entry = m_books[book_id];
+    std::unique_lock book_lock(entry.mutex);
+    // bookTicker and partial depth skip ids of updates not changing what they show, there are no gaps to detect
+    entry.last_update_id = update_id;
+    auto & book = entry.book;
+    const bool collect_changes = primary && !m_publishers.empty();
+    const auto reallocations = book.get_reallocations();
+    const auto book_update_start = tsc::now();
+    if (m_stream == StreamType::BookTicker) {
+        // {"u":400900217,"s":"BNBUSDT","b":"25.35190000","B":"31.21000000","a":"25.36520000","A":"40.66000000"}
+        const auto bid_price = to_double(d["b"]);
+        const auto bid_volume = to_double(d["B"]);
+        const auto ask_price = to_double(d["a"]);
+        const auto ask_volume = to_double(d["A"]);
+        trace.lap(Stage::Convert);
+        replace_best<OrderBook::Side::Bid>(book, bid_price, bid_volume, collect_changes);
+        replace_best<OrderBook::Side::Ask>(book, ask_price, ask_volume, collect_changes);
+    } else {
+        // {"lastUpdateId":160,"bids":[["0.0024","10"]],"asks":[["0.0026","100"]]} replaces the whole book
+        if (collect_changes) {
+            for (const auto & l : book.get_bids()) {
+                m_changes.push_back({OrderBook::Side::Bid, l.price, 0});
+            }
+            for (const auto & l : book.get_asks()) {
+                m_changes.push_back({OrderBook::Side::Ask, l.price, 0});
+            }
+        }
+        book.clear();
+        add_levels<OrderBook::Side::Bid>(book, d["bids"].GetArray(), collect_changes);
+        add_levels<OrderBook::Side::Ask>(book, d["asks"].GetArray(), collect_changes);
+    }
+    m_metrics.on_book_update(tsc::now() - book_update_start, book.get_reallocations() - reallocations);
+    trace.lap(Stage::Book);
+    if (primary) {
+        m_metrics.set_book_depth(book.get_bids_depth(), book.get_asks_depth());
+        if (!m_publishers.empty()) {
+            const BookUpdate update{entry.last_update_id, ms_ts, book, m_changes};
+            for (const auto & publisher : m_publishers) {
+                publisher->publish(this, update);
+            }
+        }
+        m_changes.clear();
+    }
+    m_pipeline_stat.add(trace);
+}
+
+}
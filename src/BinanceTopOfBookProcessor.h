@@ -0,0 +1,50 @@
+#pragma once
+
+#include "BinanceStreamProcessor.h"
+#include "StreamType.h"
+
+#include <string>
+#include <vector>
+
+namespace binance {
+
+// Listener of partial depth, bookTicker, trade and aggTrade streams. These
+// are lighter than depth diffs and come earlier for a top of book change,
+// so they measure an endpoint closer to what a top of book strategy sees.
+//
+// Latency is taken from the event time "E", or the trade or transaction
+// time "T" when there is no event time. Spot partial depth and bookTicker
+// carry neither, their updates only count for the win rate, which races
+// on "lastUpdateId" and "u". Trades race on the trade id "t", aggregated
+// trades on "a".
+//
+// For bookTicker the book of a symbol keeps the best bid and ask only,
+// every message replaces them, so there is no depth to maintain. Partial
+// depth replaces the whole book by its levels. Trade streams leave the
+// books empty.
+class BinanceTopOfBookProcessor final
+    : public BinanceStreamProcessor
+{
+public:
+    // Throws std::invalid_argument for StreamType::Depth, which BinanceIncDepthProcessor handles
+    BinanceTopOfBookProcessor(StreamType stream, bool build_order_book, const OrderBookConfig & book_config = OrderBookConfig(),
+                              const std::vector<std::string> & symbols = {});
+    ~BinanceTopOfBookProcessor() final;
+
+    StreamType get_stream() const { return m_stream; }
+
+    using BinanceStreamProcessor::process;
+
+private:
+    void process(std::string_view data, PipelineTrace & trace, uint64_t arrival_ticks, std::chrono::system_clock::time_point now,
+                 std::unique_lock<std::shared_mutex> & lock) final;
+    template <OrderBook::Side S>
+    void replace_best(OrderBook & book, double price, double volume, bool collect_changes);
+    template <OrderBook::Side S, class Levels>
+    void add_levels(OrderBook & book, const Levels & levels, bool collect_changes);
+
+private:
+    const StreamType m_stream;
+};
+
+}
@@ -1,12 +1,23 @@
 #include "BinanceWebSocketConnector.h"
 
+#include "FrameDrainingStream.h"
+#include "KernelTlsStream.h"
 #include "Log.h"
+#include "TimestampingStream.h"
+#include "Tsc.h"
+#include "UringStream.h"
 
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 
+#include <pthread.h>
+#include <time.h>
+
+#include <optional>
+#include <stop_token>
+#include <system_error>
 #include <thread>
 #include <utility>
 
@@ -15,34 +26,9 @@ namespace binance {
 namespace asio = boost::asio;
 namespace beast = boost::beast;
 
-#define _LOG(msg) LOG_LINE("[" << m_endpoint.address() << ":" << m_endpoint.port() << "]: " << msg)
-#define _LOG_ALWAYS(msg) ALWAYS_LOG("[" << m_endpoint.address() << ":" << m_endpoint.port() << "]: " << msg)
-#define report_error(ec) \
-    do { \
-        if (m_running.load(std::memory_order_acquire)) \
-        { \
-            _LOG("ERROR: " << ec.value() << ", " << ec.message()); \
-            if (m_data_listener) { \
-                m_data_listener->failure(ec.message()); \
-            } \
-            m_failure_reason = ec.message(); \
-            m_running.store(false, std::memory_order_release); \
-        } \
-    } while (0)
-
-#define report_str_error(err) \
-    do { \
-        if (m_running.load(std::memory_order_acquire)) \
-        { \
-            _LOG("ERROR: " << err); \
-            if (m_data_listener) { \
-                m_data_listener->failure(err); \
-            } \
-            m_failure_reason = err; \
-            m_running.store(false, std::memory_order_release); \
-        } \
-    } while(0)
-
+// endpoints print as ip:port, IPv6 ones as [ip]:port
+#define _LOG(msg) LOG_LINE("[" << m_endpoint << "]: " << msg)
+#define _LOG_ALWAYS(msg) ALWAYS_LOG("[" << m_endpoint << "]: " << msg)
 namespace {
 std::string to_lower(std::string str)
 {
@@ -55,14 +41,31 @@ std::string to_lower(std::string str)
 
 class BinanceWebSocketConnector::Impl
 {
+    using SocketStream = UringStream<asio::ip::tcp::socket>;
+    using SslStream = asio::ssl::stream<TracedStream<SocketStream>>;
+    using TlsStream = KernelTlsStream<SslStream>;
+    using WebSocket = beast::websocket::stream<FrameDrainingStream<TracedStream<TlsStream>>>;
+    // Enough for a 1000 levels depth update, the buffer grows for bigger ones and stays so
+    static constexpr std::size_t read_buffer_size = 64 * 1024;
+    // Messages read in one wakeup, the rest of a burst goes to the next batch
+    static constexpr std::size_t max_batch_size = 64;
+    static constexpr auto ping_period = std::chrono::seconds(1);
+    static constexpr auto max_reconnect_backoff = std::chrono::seconds(30);
+    // Receive buffers of io_uring, each a TLS record at most; taken ones go back as soon as they are copied
+    static constexpr unsigned ring_buffers_num = 32;
+    static constexpr std::size_t ring_buffer_size = 16 * 1024;
 public:
-    Impl(const IPAddress & ip, const Port & port, std::string request, JsonDataListenerPtr listener)
+    Impl(const IPAddress & ip, const Port & port, std::string request, JsonDataListenerPtr listener, std::string subscription)
         : m_request(std::move(request))
-        , m_endpoint(asio::ip::make_address_v4(ip), port)
+        , m_subscription(std::move(subscription))
+        , m_endpoint(asio::ip::make_address(ip), port)
         , m_ssl_context(boost::asio::ssl::context::sslv23_client)
-        , m_ws(m_io_context, m_ssl_context)
+        , m_ping_timer(m_io_context)
+        , m_retry_timer(m_io_context)
         , m_data_listener(std::move(listener))
     {
+        m_batch_ends.reserve(max_batch_size);
+        m_batch.reserve(max_batch_size);
         _LOG("ctor: " << m_request);
     }
 
@@ -72,42 +75,69 @@ public:
         stop();
     }
 
-    void start()
+    void set_reconnect_attempts(const size_t attempts)
     {
-        auto ep = asio::ip::tcp::resolver::results_type::create(m_endpoint, m_endpoint.address().to_string(), std::to_string(m_endpoint.port()));
-        asio::async_connect(m_ws.next_layer().next_layer(), ep, [this] (const auto ec, const auto & it) {
-            _LOG("connection successful");
-            if (ec) {
-                report_error(ec);
-            } else {
-                setup_keep_alive();
-                ssl_handshake();
-            }
-        });
+        m_reconnect_attempts = attempts;
+    }
+
+    void set_kernel_tls(const bool enable)
+    {
+        m_kernel_tls = enable;
+        if (enable) {
+            ktls::capture_secrets(m_ssl_context.native_handle());
+        }
+    }
+
+    void set_io_backend(const IoBackend backend)
+    {
+        m_io_backend = backend;
+    }
+
+    void set_cpu_pool(std::shared_ptr<affinity::CpuPool> pool)
+    {
+        m_cpu_pool = std::move(pool);
+    }
 
+    void set_compression(const bool enable)
+    {
+        m_compression = enable;
+    }
+
+    void start()
+    {
         m_running.store(true, std::memory_order_release);
-        m_thread = std::thread([this] {
+        m_thread = std::jthread([this] (const std::stop_token stop) {
             _LOG("executing thread");
-            do {
-                boost::system::error_code ec;
-                m_io_context.run_for(std::chrono::seconds(1));
-                setup_ping();
-            } while (m_running.load(std::memory_order_acquire));
+            if (m_cpu_pool) {
+                m_cpu = m_cpu_pool->acquire();
+                pin(m_cpu);
+            }
+            // allocated by the pinned thread, pages come from its NUMA node
+            m_buffer.reserve(read_buffer_size);
+            asio::co_spawn(m_io_context, run(stop), asio::detached);
+            // runs right away if the stop was requested already
+            const std::stop_callback on_stop(stop, [this] {
+                asio::post(m_io_context, [this] { close(); });
+            });
+            m_io_context.run();
             if (!m_failure_reason.empty()) {
                 _LOG_ALWAYS("stopped because of [" << m_failure_reason << "]");
             }
+            if (m_cpu_pool) {
+                m_cpu_pool->release(m_cpu);
+            }
         });
+        m_has_cpu_clock = pthread_getcpuclockid(m_thread.native_handle(), &m_cpu_clock) == 0;
     }
 
     void stop()
     {
-        m_running.store(false, std::memory_order_release);
-        if (!m_io_context.stopped()) {
-            m_io_context.stop();
-        }
         if (m_thread.joinable()) {
+            get_cpu_time();
+            m_thread.request_stop();
             m_thread.join();
         }
+        m_running.store(false, std::memory_order_release);
     }
 
     auto get_host() const
@@ -120,20 +150,205 @@ public:
         return m_running.load(std::memory_order_acquire);
     }
 
+    // The clock is gone with the thread, the last reading stays then
+    std::chrono::nanoseconds get_cpu_time() const
+    {
+        timespec ts;
+        if (m_has_cpu_clock && m_thread.joinable() && clock_gettime(m_cpu_clock, &ts) == 0) {
+            m_cpu_time_ns.store(ts.tv_sec * 1000000000LL + ts.tv_nsec, std::memory_order_relaxed);
+        }
+        return std::chrono::nanoseconds(m_cpu_time_ns.load(std::memory_order_relaxed));
+    }
+
+    TransportStatistics get_transport_statistics() const
+    {
+        TransportStatistics ret;
+        ret.messages = m_messages.load(std::memory_order_relaxed);
+        ret.payload_bytes = m_payload_bytes.load(std::memory_order_relaxed);
+        ret.wire_bytes = m_wire_bytes.load(std::memory_order_relaxed);
+        ret.decode_time = std::chrono::nanoseconds(tsc::to_ns(m_decode_ticks.load(std::memory_order_relaxed)));
+        ret.compressed = m_compressed.load(std::memory_order_relaxed);
+        ret.kernel_tls = m_kernel_rx.load(std::memory_order_relaxed);
+        return ret;
+    }
+
 private:
+    // The Host header takes IPv6 addresses in brackets
+    std::string host_header() const
+    {
+        const auto address = m_endpoint.address().to_string();
+        return m_endpoint.address().is_v6() ? '[' + address + ']' : address;
+    }
+
+    TlsStream & tls_stream() { return untraced(m_ws->next_layer().next_layer()); }
+    SslStream & ssl_stream() { return tls_stream().next_layer(); }
+    SocketStream & socket_stream() { return untraced(ssl_stream().next_layer()); }
+    asio::ip::tcp::socket & tcp_socket() { return socket_stream().next_layer(); }
+
+    // Sessions one after another while they fail no more than allowed in a row
+    asio::awaitable<void> run(const std::stop_token stop)
+    {
+        size_t failures = 0;
+        while (!stop.stop_requested()) {
+            std::string reason;
+            try {
+                co_await session();
+            } catch (const boost::system::system_error & e) {
+                reason = e.code().message();
+            } catch (const std::exception & e) {
+                reason = e.what();
+            }
+            // the keep alive coroutine may still hold the stream, the next session replaces it
+            m_ping_timer.cancel();
+            while (m_keep_alive_running) {
+                co_await asio::post(m_io_context, asio::use_awaitable);
+            }
+            if (stop.stop_requested()) {
+                break;
+            }
+            if (!m_session_failure.empty()) {
+                reason = std::move(m_session_failure);
+            }
+            failures = m_ready ? 1 : failures + 1;
+            if (failures > m_reconnect_attempts) {
+                report_failure(reason);
+                break;
+            }
+            report_session_lost(reason);
+            const auto backoff = std::min<std::chrono::seconds>(std::chrono::seconds(1 << std::min<size_t>(failures - 1, 5)), max_reconnect_backoff);
+            _LOG_ALWAYS("reconnecting in " << backoff.count() << "s, attempt " << failures << " of " << m_reconnect_attempts);
+            m_retry_timer.expires_after(backoff);
+            boost::system::error_code ec;
+            co_await m_retry_timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        }
+        m_running.store(false, std::memory_order_release);
+    }
+
+    asio::awaitable<void> session()
+    {
+        m_ready.store(false, std::memory_order_release);
+        m_ping_sent = false;
+        m_buffer.clear();
+        m_batch_ends.clear();
+        m_batch.clear();
+        m_ws.emplace(m_io_context, m_ssl_context);
+        m_compressed.store(false, std::memory_order_relaxed);
+        m_kernel_rx.store(false, std::memory_order_relaxed);
+        if (m_compression) {
+            // the stream keeps one inflate state for the whole connection, the
+            // window is taken over from message to message
+            beast::websocket::permessage_deflate deflate;
+            deflate.client_enable = true;
+            m_ws->set_option(deflate);
+        }
+        if (m_io_backend == IoBackend::IoUring) {
+            try {
+                socket_stream().set_receiver(std::make_unique<uring::Receiver>(ring_buffers_num, ring_buffer_size));
+            } catch (const std::system_error & e) {
+                _LOG_ALWAYS("io_uring is not available: " << e.what() << ", epoll is used");
+                m_io_backend = IoBackend::Epoll;
+            }
+        }
+
+        auto ep = asio::ip::tcp::resolver::results_type::create(m_endpoint, m_endpoint.address().to_string(), std::to_string(m_endpoint.port()));
+        co_await asio::async_connect(tcp_socket(), ep, asio::use_awaitable);
+        _LOG("connection successful");
+        setup_keep_alive();
+
+        co_await ssl_stream().async_handshake(asio::ssl::stream_base::client, asio::use_awaitable);
+        _LOG("ssl_handshake successful");
+        if (m_cpu_pool && m_cpu_pool->follows_interrupts()) {
+            follow_interrupts();
+        }
+        if (m_kernel_tls && socket_stream().is_uring()) {
+            // the receive armed in the ring would take records the kernel has decrypted
+            _LOG_ALWAYS("kernel TLS is not used with io_uring, OpenSSL decrypts");
+        } else if (m_kernel_tls) {
+            const auto reason = ktls::enable_rx(ssl_stream().native_handle(), tcp_socket().native_handle());
+            if (reason.empty()) {
+                tls_stream().set_kernel_rx();
+                m_kernel_rx.store(true, std::memory_order_relaxed);
+                _LOG_ALWAYS("kernel TLS decrypts received records");
+            } else {
+                _LOG_ALWAYS("kernel TLS is not available: " << reason << ", OpenSSL decrypts");
+            }
+        }
+
+        beast::websocket::response_type response;
+        co_await m_ws->async_handshake(response, host_header(), m_request, asio::use_awaitable);
+        if (m_compression) {
+            const auto extensions = response[beast::http::field::sec_websocket_extensions];
+            const bool compressed = extensions.find("permessage-deflate") != beast::string_view::npos;
+            m_compressed.store(compressed, std::memory_order_relaxed);
+            _LOG_ALWAYS((compressed ? "permessage-deflate is negotiated" : "server declined permessage-deflate, messages come uncompressed"));
+        }
+        _LOG("start reading");
+        m_ready.store(true, std::memory_order_release);
+        m_failure_reason.clear(); // recovered
+
+        if (!m_subscription.empty()) {
+            _LOG("subscribe: " << m_subscription);
+            co_await m_ws->async_write(asio::buffer(m_subscription), asio::use_awaitable);
+        }
+
+        m_keep_alive_running = true;
+        asio::co_spawn(m_io_context, keep_alive(), [this] (const std::exception_ptr e) {
+            m_keep_alive_running = false;
+            if (!e) {
+                return;
+            }
+            try {
+                std::rethrow_exception(e);
+            } catch (const boost::system::system_error & ex) {
+                if (ex.code() != asio::error::operation_aborted) {
+                    fail_session(ex.code().message());
+                }
+            } catch (const std::exception & ex) {
+                fail_session(ex.what());
+            }
+        });
+
+        for (;;) {
+            co_await m_ws->async_read(m_buffer, asio::use_awaitable);
+            m_batch_ends.push_back(m_buffer.size());
+            // messages which came along are already here, no need to go through the io_context for them
+            while (m_batch_ends.size() < max_batch_size && m_ws->next_layer().message_ready()) {
+                m_ws->read(m_buffer);
+                m_batch_ends.push_back(m_buffer.size());
+            }
+            count_transport();
+            read_batch();
+            m_last_batch_end = tsc::now();
+        }
+    }
+
+    // Runs next to the read loop, a ping without pong till the next one fails the session
+    asio::awaitable<void> keep_alive()
+    {
+        for (;;) {
+            m_ping_timer.expires_after(ping_period);
+            co_await m_ping_timer.async_wait(asio::use_awaitable);
+            if (m_ping_sent.exchange(true)) {
+                throw std::runtime_error("Previous ping was not ponged");
+            }
+            co_await m_ws->async_ping(beast::websocket::ping_data{}, asio::use_awaitable);
+            _LOG("ping sent");
+        }
+    }
+
     void setup_keep_alive()
     {
         _LOG("setup_keep_alive()");
-        m_ws.control_callback(
+        m_ws->control_callback(
             [this] ([[maybe_unused]] const beast::websocket::frame_type kind, [[maybe_unused]] const beast::string_view payload) mutable {
                 _LOG("kind: " << (int)kind << ", payload: " << payload);
                 switch (kind) {
                     case beast::websocket::frame_type::ping:
                     {
-                        m_ws.async_pong(beast::websocket::ping_data{}, [this](const auto ec) {
+                        m_ws->async_pong(beast::websocket::ping_data{}, [this](const auto ec) {
                             _LOG("async_pong(): " << ec);
-                            if (ec) {
-                                report_error(ec);
+                            if (ec && ec != asio::error::operation_aborted) {
+                                fail_session(ec.message());
                             }
                         });
                         break;
@@ -151,121 +366,190 @@ private:
         );
     }
 
-    void setup_ping()
+    // Websocket work on the batch runs from the wakeup which brought its bytes,
+    // or from the end of the previous batch if they were buffered already
+    void count_transport()
     {
-        m_ws.async_ping(beast::websocket::ping_data{}, [this] (const auto ec) {
-            _LOG("async_ping(): " << ec);
-            if (m_ready.load(std::memory_order_acquire)) {
-                if (ec) {
-                    report_error(ec);
-                } else {
-                    const auto prev = m_ping_sent.exchange(true);
-                    if (prev) {
-                        report_str_error("Previous ping was not ponged");
-                    }
-                }
-            }
-        });
+        auto & frames = m_ws->next_layer();
+        const auto now = tsc::now();
+        const auto start = std::max(frames.last_fill_ticks(), m_last_batch_end);
+        const auto add = [] (std::atomic<uint64_t> & counter, const uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        };
+        add(m_decode_ticks, now > start ? now - start : 0);
+        add(m_wire_bytes, frames.take_frame_bytes());
+        add(m_messages, m_batch_ends.size());
+        add(m_payload_bytes, m_buffer.size());
     }
 
-    void ssl_handshake()
+    void read_batch()
     {
-        _LOG("ssl_handshake()");
-        m_ws.next_layer().async_handshake(asio::ssl::stream_base::client,
-            [this] (const auto ec) mutable {
-                _LOG("ssl_handshake successful");
-                if (ec) {
-                    report_error(ec);
-                } else {
-                    setup_reader();
-                }
+        PipelineTrace trace;
+        const auto tls_ticks = last_read_ticks(m_ws->next_layer().next_layer());
+        // reads of kernel TLS skip the socket layer under OpenSSL, decryption is not seen then
+        trace.start(tls_stream().is_kernel_rx() ? tls_ticks : last_read_ticks(ssl_stream().next_layer()));
+        trace.lap(Stage::Tls, tls_ticks);
+        trace.lap(Stage::WebSocket);
+
+        // flat_buffer keeps the messages contiguous, one after another, they are parsed in place
+        const auto * data = static_cast<const char *>(m_buffer.cdata().data());
+        std::size_t begin = 0;
+        for (const auto end : m_batch_ends) {
+            m_batch.emplace_back(data + begin, end - begin);
+            _LOG("read json buffer: " << m_batch.back());
+            begin = end;
+        }
+        trace.lap(Stage::Copy);
+
+        if (m_data_listener) {
+            if (!m_data_listener->process_batch(m_batch, trace)) {
+                throw std::runtime_error("could not update depth");
             }
-        );
+        }
+        m_batch.clear();
+        m_batch_ends.clear();
+        m_buffer.consume(m_buffer.size());
     }
 
-    void setup_reader()
+    void pin(const affinity::Cpu & cpu)
     {
-        _LOG("setup_reader()");
-        m_ws.async_handshake(
-            m_endpoint.address().to_string(), m_request, [this](const auto ec) mutable {
-                _LOG("start reading");
-                if (ec) {
-                    report_error(ec);
-                } else {
-                    m_ready.store(true, std::memory_order_release);
-                    setup_next_read();
-                }
-            }
-        );
+        if (const auto reason = affinity::pin_thread(cpu.id); !reason.empty()) {
+            _LOG_ALWAYS("could not pin to CPU " << cpu.id << ": " << reason);
+        } else {
+            _LOG_ALWAYS("pinned to CPU " << cpu.id << ", NUMA node " << cpu.node);
+        }
     }
 
-    void setup_next_read()
+    // The handshake has received packets, the socket knows the CPU which processed them
+    void follow_interrupts()
     {
-        _LOG("setup_read()");
-        m_ws.async_read(
-            m_buffer,
-            [this] (const auto ec, const std::size_t size) mutable
-            {
-                _LOG("reading buffer");
-                if (ec) {
-                    report_error(ec);
-                } else {
-                    read(size);
-                }
-            }
-        );
+        const auto rx_cpu = affinity::incoming_cpu(tcp_socket().native_handle());
+        if (rx_cpu < 0) {
+            return;
+        }
+        const auto cpu = m_cpu_pool->move_near(m_cpu, {rx_cpu, affinity::numa_node(rx_cpu)});
+        if (cpu.id != m_cpu.id) {
+            _LOG_ALWAYS("packets are received on CPU " << rx_cpu << ", moving from CPU " << m_cpu.id);
+            m_cpu = cpu;
+            pin(m_cpu);
+        }
     }
 
-    void read(const std::size_t sz)
+    // Ends the session from outside of its read loop, which then fails with operation_aborted
+    void fail_session(std::string reason)
     {
-        const auto size = m_buffer.size();
-
-        if (size != sz) {
-            report_str_error("Internal error read buffer != provided size");
-            return;
+        if (m_session_failure.empty()) {
+            m_session_failure = std::move(reason);
         }
-        m_json_buffer.clear();
-        for (const auto & b : m_buffer.data()) {
-            m_json_buffer.append((const char *) b.data(), b.size());
+        if (m_ws) {
+            boost::system::error_code ec;
+            socket_stream().close(ec);
         }
-        _LOG("read json buffer: " << m_json_buffer);
+    }
 
+    void report_failure(const std::string & reason)
+    {
+        _LOG("ERROR: " << reason);
         if (m_data_listener) {
-            if (!m_data_listener->process(m_json_buffer)) {
-                report_str_error("could not update depth");
-                return;
-            }
+            m_data_listener->failure(reason);
+        }
+        m_failure_reason = reason;
+    }
+
+    void report_session_lost(const std::string & reason)
+    {
+        _LOG("ERROR: " << reason);
+        if (m_data_listener) {
+            m_data_listener->session_lost(reason);
         }
-        m_buffer.consume(size);
+        m_failure_reason = reason;
+    }
 
-        setup_next_read();
+    // Cancels whatever is pending, coroutines see the stop and return
+    void close()
+    {
+        m_ping_timer.cancel();
+        m_retry_timer.cancel();
+        if (m_ws) {
+            boost::system::error_code ec;
+            socket_stream().close(ec);
+        }
     }
 
 private:
-    std::atomic<bool> m_running = false;
-    std::thread m_thread;
+    std::atomic<bool> m_running = false; // connected or reconnecting
+    std::jthread m_thread;
+    clockid_t m_cpu_clock{};
+    bool m_has_cpu_clock = false;
+    mutable std::atomic<int64_t> m_cpu_time_ns{0};
     std::atomic<bool> m_ready {false};
     std::atomic<bool> m_ping_sent {false};
+    bool m_keep_alive_running = false;
+    size_t m_reconnect_attempts = 0;
+    bool m_kernel_tls = false;
+    IoBackend m_io_backend = IoBackend::Epoll;
+    bool m_compression = false;
+    std::shared_ptr<affinity::CpuPool> m_cpu_pool;
+    affinity::Cpu m_cpu; // taken from the pool
+    std::string m_session_failure; // set outside of the read loop, e.g. by keep alive
     std::string m_failure_reason;
 
     std::string m_request;
+    std::string m_subscription;
     asio::ip::tcp::endpoint m_endpoint;
 
     asio::io_context m_io_context;
     asio::ssl::context m_ssl_context;
-    beast::websocket::stream<asio::ssl::stream<asio::ip::tcp::socket>> m_ws;
-    boost::beast::multi_buffer m_buffer;
-    std::string m_json_buffer;
+    asio::steady_timer m_ping_timer;
+    asio::steady_timer m_retry_timer;
+    std::optional<WebSocket> m_ws; // a new one for every session
+    beast::flat_buffer m_buffer;
+    std::vector<std::size_t> m_batch_ends; // of messages read into m_buffer
+    std::vector<std::string_view> m_batch;
+    uint64_t m_last_batch_end = 0; // tsc ticks
+
+    // written by the connector thread only
+    std::atomic<uint64_t> m_messages{0};
+    std::atomic<uint64_t> m_payload_bytes{0};
+    std::atomic<uint64_t> m_wire_bytes{0};
+    std::atomic<uint64_t> m_decode_ticks{0};
+    std::atomic<bool> m_compressed{false};
+    std::atomic<bool> m_kernel_rx{false};
 
     JsonDataListenerPtr m_data_listener;
 };
 
-BinanceWebSocketConnector::BinanceWebSocketConnector(const IPAddress & ip, const Port & port, std::string request, JsonDataListenerPtr listener)
-    : m_impl(std::make_unique<BinanceWebSocketConnector::Impl>(ip, port, std::move(request), std::move(listener)))
+BinanceWebSocketConnector::BinanceWebSocketConnector(const IPAddress & ip, const Port & port, std::string request, JsonDataListenerPtr listener, std::string subscription)
+    : m_impl(std::make_unique<BinanceWebSocketConnector::Impl>(ip, port, std::move(request), std::move(listener), std::move(subscription)))
 { }
 
 BinanceWebSocketConnector::~BinanceWebSocketConnector() = default;
 
+void BinanceWebSocketConnector::set_reconnect_attempts(const size_t attempts)
+{
+    return m_impl->set_reconnect_attempts(attempts);
+}
+
+void BinanceWebSocketConnector::set_kernel_tls(const bool enable)
+{
+    return m_impl->set_kernel_tls(enable);
+}
+
+void BinanceWebSocketConnector::set_io_backend(const IoBackend backend)
+{
+    return m_impl->set_io_backend(backend);
+}
+
+void BinanceWebSocketConnector::set_cpu_pool(std::shared_ptr<affinity::CpuPool> pool)
+{
+    return m_impl->set_cpu_pool(std::move(pool));
+}
+
+void BinanceWebSocketConnector::set_compression(const bool enable)
+{
+    return m_impl->set_compression(enable);
+}
+
 void BinanceWebSocketConnector::start()
 {
     return m_impl->start();
@@ -286,14 +570,48 @@ IPAddress BinanceWebSocketConnector::get_host() const
     return m_impl->get_host();
 }
 
+std::chrono::nanoseconds BinanceWebSocketConnector::get_cpu_time() const
+{
+    return m_impl->get_cpu_time();
+}
+
+TransportStatistics BinanceWebSocketConnector::get_transport_statistics() const
+{
+    return m_impl->get_transport_statistics();
+}
+
+std::unique_ptr<BinanceWebSocketConnector> BinanceWebSocketConnector::make_connector(
+    const IPAddress & ip,
+    const Port & port,
+    const std::vector<std::string> & tickers,
+    const StreamVariant & stream,
+    JsonDataListenerPtr listener)
+{
+    // which variant is faster is measured by --compare-streams
+    const auto stream_suffix = '@' + stream.name();
+    if (tickers.size() == 1) {
+        return std::make_unique<BinanceWebSocketConnector>(ip, port, "/ws/" + to_lower(tickers.front()) + stream_suffix, std::move(listener));
+    }
+    // combined stream, events come wrapped into {"stream":...,"data":{...}}; streams are
+    // subscribed by a message rather than in the target, which would get too long
+    std::string subscription = R"({"method":"SUBSCRIBE","params":[)";
+    for (const auto & ticker : tickers) {
+        if (&ticker != &tickers.front()) {
+            subscription += ',';
+        }
+        subscription += '"' + to_lower(ticker) + stream_suffix + '"';
+    }
+    subscription += R"(],"id":1})";
+    return std::make_unique<BinanceWebSocketConnector>(ip, port, "/stream", std::move(listener), std::move(subscription));
+}
+
 std::unique_ptr<BinanceWebSocketConnector> BinanceWebSocketConnector::make_depth_connector(
     const IPAddress & ip,
     const Port & port,
-    std::string ticker,
+    const std::vector<std::string> & tickers,
     JsonDataListenerPtr listener)
 {
-    constexpr auto updatetime = ""; //"@100ms"; // Seems that without @100ms flow is faster (need to check)
-    return std::make_unique<BinanceWebSocketConnector>(ip, port, "/ws/" + to_lower(std::move(ticker)) + "@depth" + updatetime, std::move(listener));
+    return make_connector(ip, port, tickers, StreamType::Depth, std::move(listener));
 }
 
-}
\ No newline at end of file
+}
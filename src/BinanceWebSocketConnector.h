@@ -1,10 +1,15 @@
 #pragma once
 
+#include "CpuAffinity.h"
 #include "IJsonDataListener.h"
 #include "IConnector.h"
+#include "IoBackend.h"
 #include "IPAddress.h"
+#include "StreamType.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace binance {
 
@@ -13,17 +18,39 @@ class BinanceWebSocketConnector final
 {
     class Impl;
 public:
-    explicit BinanceWebSocketConnector(const IPAddress &, const Port &, std::string request, JsonDataListenerPtr listener = {});
+    // subscription is sent as a text message right after the handshake, e.g. a SUBSCRIBE request
+    explicit BinanceWebSocketConnector(const IPAddress &, const Port &, std::string request, JsonDataListenerPtr listener = {}, std::string subscription = {});
     ~BinanceWebSocketConnector() final;
 
+    // Failed sessions in a row to retry with a doubling backoff before giving up, 0 by default;
+    // must be called before start()
+    void set_reconnect_attempts(size_t attempts);
+    // Hands decryption of received TLS 1.3 records to the kernel after every handshake,
+    // OpenSSL keeps it if kernel TLS is not available; must be called before start()
+    void set_kernel_tls(bool enable);
+    // Epoll by default; io_uring falls back to it if the kernel does not allow a ring,
+    // kernel TLS is not used with it; must be called before start()
+    void set_io_backend(IoBackend backend);
+    // Pins the connector thread to the least used CPU of the pool, and next to the CPU
+    // receiving its packets after every handshake if the pool follows interrupts;
+    // must be called before start()
+    void set_cpu_pool(std::shared_ptr<affinity::CpuPool> pool);
+    // Offers permessage-deflate in every handshake, messages are inflated if the server
+    // takes it; must be called before start()
+    void set_compression(bool enable);
+
     void start() final;
     void stop() final;
 
     bool is_running() const final;
 
     IPAddress get_host() const final;
+    std::chrono::nanoseconds get_cpu_time() const final;
+    TransportStatistics get_transport_statistics() const final;
 
-    static std::unique_ptr<BinanceWebSocketConnector> make_depth_connector(const IPAddress &, const Port &, std::string ticker, JsonDataListenerPtr listener = {});
+    // One raw stream for a single ticker, a combined stream for several
+    static std::unique_ptr<BinanceWebSocketConnector> make_connector(const IPAddress &, const Port &, const std::vector<std::string> & tickers, const StreamVariant & stream, JsonDataListenerPtr listener = {});
+    static std::unique_ptr<BinanceWebSocketConnector> make_depth_connector(const IPAddress &, const Port &, const std::vector<std::string> & tickers, JsonDataListenerPtr listener = {});
 
 private:
     std::unique_ptr<Impl> m_impl;
@@ -0,0 +1,237 @@
+#include "BookDelta.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace book_delta {
+
+namespace {
+
+uint64_t zigzag(const int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+int64_t unzigzag(const uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+void put_varint(std::string & out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void put_double(std::string & out, const double v)
+{
+    char buf[sizeof(v)];
+    std::memcpy(buf, &v, sizeof(v));
+    out.append(buf, sizeof(v));
+}
+
+class Reader
+{
+public:
+    explicit Reader(const std::string_view data)
+        : m_data(data)
+    { }
+
+    // Returns false if data ends in the middle of the varint
+    bool try_varint(uint64_t & v)
+    {
+        v = 0;
+        for (size_t shift = 0, pos = m_pos; pos < m_data.size() && shift < 64; shift += 7, ++pos) {
+            const auto byte = static_cast<uint8_t>(m_data[pos]);
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                m_pos = pos + 1;
+                return true;
+            }
+        }
+        if (m_data.size() - m_pos >= 10) {
+            throw std::runtime_error("book delta: varint is too long");
+        }
+        return false;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t v;
+        if (!try_varint(v)) {
+            throw std::runtime_error("book delta: truncated frame");
+        }
+        return v;
+    }
+
+    int64_t zigzag_varint() { return unzigzag(varint()); }
+
+    double f64()
+    {
+        double v;
+        std::memcpy(&v, take(sizeof(v)).data(), sizeof(v));
+        return v;
+    }
+
+    char byte() { return take(1)[0]; }
+
+    std::string_view take(const size_t n)
+    {
+        if (m_data.size() - m_pos < n) {
+            throw std::runtime_error("book delta: truncated frame");
+        }
+        const auto ret = m_data.substr(m_pos, n);
+        m_pos += n;
+        return ret;
+    }
+
+    size_t position() const { return m_pos; }
+    bool at_end() const { return m_pos == m_data.size(); }
+
+private:
+    std::string_view m_data;
+    size_t m_pos = 0;
+};
+
+}
+
+Encoder::Encoder(const EncoderConfig config)
+    : m_config(config)
+    , m_deltas_since_keyframe(config.keyframe_interval) // the stream starts with a keyframe
+{ }
+
+void Encoder::begin(const char type, const uint64_t update_id, const int64_t event_time_ms)
+{
+    m_body.clear();
+    m_body.push_back(type);
+    put_varint(m_body, zigzag(static_cast<int64_t>(update_id - m_update_id)));
+    put_varint(m_body, zigzag(event_time_ms - m_event_time_ms));
+    m_update_id = update_id;
+    m_event_time_ms = event_time_ms;
+}
+
+template <class Levels>
+void Encoder::encode_side(const Levels & lvls, int64_t & anchor)
+{
+    put_varint(m_body, lvls.size());
+    auto prev = anchor;
+    for (const auto & lvl : lvls) {
+        const auto ticks = std::llround(lvl.price / m_config.tick_size);
+        put_varint(m_body, zigzag(ticks - prev));
+        put_varint(m_body, static_cast<uint64_t>(std::llround(std::max(lvl.volume, 0.0) / m_config.qty_step)));
+        if (&lvl == &lvls.front()) {
+            anchor = ticks;
+        }
+        prev = ticks;
+    }
+}
+
+void Encoder::finish(std::string & out)
+{
+    put_varint(out, m_body.size());
+    out += m_body;
+}
+
+void Encoder::encode_keyframe(const OrderBook & ob, const uint64_t update_id, const int64_t event_time_ms, std::string & out)
+{
+    m_update_id = 0;
+    m_event_time_ms = 0;
+    m_bid_anchor = 0;
+    m_ask_anchor = 0;
+    begin('K', update_id, event_time_ms);
+    put_double(m_body, m_config.tick_size);
+    put_double(m_body, m_config.qty_step);
+    // get_bids()/get_asks() see the hot levels only, deltas of cold ones are published too
+    const auto full = ob.copy_top(-1);
+    encode_side(full.get_bids(), m_bid_anchor);
+    encode_side(full.get_asks(), m_ask_anchor);
+    finish(out);
+    m_deltas_since_keyframe = 0;
+}
+
+void Encoder::encode_delta(const std::vector<LevelChange> & changes, const uint64_t update_id, const int64_t event_time_ms, std::string & out)
+{
+    m_bids.clear();
+    m_asks.clear();
+    for (const auto & c : changes) {
+        (c.side == OrderBook::Side::Bid ? m_bids : m_asks).push_back(c);
+    }
+    begin('D', update_id, event_time_ms);
+    encode_side(m_bids, m_bid_anchor);
+    encode_side(m_asks, m_ask_anchor);
+    finish(out);
+    ++m_deltas_since_keyframe;
+}
+
+size_t Decoder::feed(const std::string_view data)
+{
+    m_pending.append(data);
+    Reader reader(m_pending);
+    size_t applied = 0;
+    size_t consumed = 0;
+    uint64_t len;
+    while (reader.try_varint(len)) {
+        if (m_pending.size() - reader.position() < len) {
+            break;
+        }
+        const auto body = reader.take(len);
+        consumed = reader.position();
+        if (body.empty()) {
+            throw std::runtime_error("book delta: empty frame");
+        }
+        if (body[0] == 'K' || m_synced) {
+            apply(body);
+            ++applied;
+        }
+    }
+    m_pending.erase(0, consumed);
+    return applied;
+}
+
+void Decoder::apply(const std::string_view body)
+{
+    Reader reader(body);
+    const auto type = reader.byte();
+    if (type != 'K' && type != 'D') {
+        throw std::runtime_error("book delta: unknown frame type");
+    }
+    if (type == 'K') {
+        m_update_id = 0;
+        m_event_time_ms = 0;
+        m_bid_anchor = 0;
+        m_ask_anchor = 0;
+    }
+    m_update_id += static_cast<uint64_t>(reader.zigzag_varint());
+    m_event_time_ms += reader.zigzag_varint();
+    if (type == 'K') {
+        m_tick_size = reader.f64();
+        m_qty_step = reader.f64();
+        m_order_book.clear();
+        m_synced = true;
+    }
+
+    const auto decode_side = [&] (const OrderBook::Side side, int64_t & anchor) {
+        const auto num = reader.varint();
+        auto prev = anchor;
+        for (uint64_t i = 0; i < num; ++i) {
+            const auto ticks = prev + reader.zigzag_varint();
+            const auto qty = reader.varint();
+            if (i == 0) {
+                anchor = ticks;
+            }
+            prev = ticks;
+            m_order_book.insert_replace(static_cast<double>(ticks) * m_tick_size, static_cast<double>(qty) * m_qty_step, side);
+        }
+    };
+    decode_side(OrderBook::Side::Bid, m_bid_anchor);
+    decode_side(OrderBook::Side::Ask, m_ask_anchor);
+    if (!reader.at_end()) {
+        throw std::runtime_error("book delta: trailing bytes in frame");
+    }
+}
+
+}
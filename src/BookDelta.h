@@ -0,0 +1,94 @@
+#pragma once
+
+// Compact binary stream of order book changes. Every frame is
+//
+//     frame := varint(body length) body
+//     body  := type ('K' keyframe | 'D' delta)
+//              zigzag(update id - previous update id)
+//              zigzag(event time ms - previous event time ms)
+//              [keyframe only: tick size f64, quantity step f64]
+//              side(bids) side(asks)
+//     side  := varint(levels num) levels num * (zigzag(price ticks - previous price ticks) varint(quantity units))
+//
+// Prices are integer ticks and quantities integer steps, quantity 0 removes
+// a level. The previous price starts from the first price of the same side
+// in the previous frame, so a typical change near the top of the book takes
+// two or three bytes. A keyframe carries the whole book and resets all
+// references, a consumer may start decoding at any keyframe.
+
+#include "BookPublisher.h"
+#include "OrderBook.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace book_delta {
+
+struct EncoderConfig
+{
+    double tick_size = 1e-8;
+    double qty_step = 1e-8;
+    size_t keyframe_interval = 1000; // delta frames between keyframes
+};
+
+class Encoder
+{
+public:
+    explicit Encoder(EncoderConfig config = {});
+
+    // Both append one frame to out, a keyframe carries the cold levels of a depth limited book too
+    void encode_keyframe(const OrderBook & ob, uint64_t update_id, int64_t event_time_ms, std::string & out);
+    void encode_delta(const std::vector<LevelChange> & changes, uint64_t update_id, int64_t event_time_ms, std::string & out);
+
+    bool keyframe_due() const { return m_deltas_since_keyframe >= m_config.keyframe_interval; }
+    void force_keyframe() { m_deltas_since_keyframe = m_config.keyframe_interval; }
+
+private:
+    void begin(char type, uint64_t update_id, int64_t event_time_ms);
+    template <class Levels>
+    void encode_side(const Levels & lvls, int64_t & anchor);
+    void finish(std::string & out);
+
+private:
+    EncoderConfig m_config;
+    size_t m_deltas_since_keyframe;
+    uint64_t m_update_id = 0;
+    int64_t m_event_time_ms = 0;
+    int64_t m_bid_anchor = 0;
+    int64_t m_ask_anchor = 0;
+    std::string m_body;
+    std::vector<LevelChange> m_bids;
+    std::vector<LevelChange> m_asks;
+};
+
+class Decoder
+{
+public:
+    // Applies all complete frames in data and keeps the tail for the next
+    // call. Delta frames before the first keyframe are skipped. Returns the
+    // number of applied frames, throws std::runtime_error on malformed input.
+    size_t feed(std::string_view data);
+
+    bool synced() const { return m_synced; }
+    uint64_t get_update_id() const { return m_update_id; }
+    int64_t get_event_time_ms() const { return m_event_time_ms; }
+    const OrderBook & get_order_book() const { return m_order_book; }
+
+private:
+    void apply(std::string_view body);
+
+private:
+    std::string m_pending;
+    bool m_synced = false;
+    double m_tick_size = 0;
+    double m_qty_step = 0;
+    uint64_t m_update_id = 0;
+    int64_t m_event_time_ms = 0;
+    int64_t m_bid_anchor = 0;
+    int64_t m_ask_anchor = 0;
+    OrderBook m_order_book;
+};
+
+}
@@ -0,0 +1,81 @@
+#include "BookDeltaPublisher.h"
+
+#include "Log.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+BookDeltaPublisher::BookDeltaPublisher(const std::string & path, const book_delta::EncoderConfig config)
+    : BookDeltaPublisher(open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC, 0644), config)
+{
+    ALWAYS_LOG("writing order book deltas to " << path);
+}
+
+BookDeltaPublisher::BookDeltaPublisher(const int fd, const book_delta::EncoderConfig config)
+    : m_fd(fd)
+    , m_encoder(config)
+{
+    if (m_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "book delta output");
+    }
+    const auto flags = fcntl(m_fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+BookDeltaPublisher::~BookDeltaPublisher()
+{
+    if (m_dropped_frames) {
+        ALWAYS_LOG("book delta output dropped " << m_dropped_frames << " frames");
+    }
+    close(m_fd);
+}
+
+void BookDeltaPublisher::on_source_changed(std::string_view)
+{
+    m_encoder.force_keyframe();
+}
+
+void BookDeltaPublisher::on_reset()
+{
+    m_encoder.force_keyframe();
+}
+
+void BookDeltaPublisher::write(const BookUpdate & update)
+{
+    if (!flush()) {
+        ++m_dropped_frames;
+        m_encoder.force_keyframe();
+        return;
+    }
+    m_out.clear();
+    m_out_offset = 0;
+    if (m_encoder.keyframe_due()) {
+        m_encoder.encode_keyframe(update.book, update.update_id, update.event_time.count(), m_out);
+    } else {
+        m_encoder.encode_delta(update.changes, update.update_id, update.event_time.count(), m_out);
+    }
+    flush();
+}
+
+bool BookDeltaPublisher::flush()
+{
+    while (m_out_offset < m_out.size()) {
+        const auto written = ::write(m_fd, m_out.data() + m_out_offset, m_out.size() - m_out_offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_LINE("book delta write failed: " << std::generic_category().message(errno));
+            }
+            return false;
+        }
+        m_out_offset += static_cast<size_t>(written);
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "BookDelta.h"
+#include "BookPublisher.h"
+
+#include <string>
+
+// Writes the book_delta stream of the selected source listener to a file
+// descriptor: a file, a FIFO or a connected socket. The descriptor is
+// written without blocking from the feed thread, a frame that does not fit
+// is dropped and the stream continues from a keyframe once the consumer
+// caught up. Switching the source listener or a reset of its book also
+// starts with a keyframe.
+class BookDeltaPublisher final
+    : public BookPublisher
+{
+public:
+    BookDeltaPublisher(const std::string & path, book_delta::EncoderConfig config = {});
+    // Takes ownership of fd
+    BookDeltaPublisher(int fd, book_delta::EncoderConfig config = {});
+    ~BookDeltaPublisher() final;
+
+    BookDeltaPublisher(const BookDeltaPublisher &) = delete;
+    BookDeltaPublisher & operator=(const BookDeltaPublisher &) = delete;
+
+    uint64_t get_dropped_frames() const { return m_dropped_frames; }
+
+private:
+    void on_source_changed(std::string_view source_name) final;
+    void on_reset() final;
+    void write(const BookUpdate & update) final;
+
+    // Returns true if nothing is left unsent
+    bool flush();
+
+private:
+    int m_fd;
+    book_delta::Encoder m_encoder;
+    std::string m_out;       // unsent bytes, always whole frames or a tail of one
+    size_t m_out_offset = 0;
+    uint64_t m_dropped_frames = 0;
+};
@@ -0,0 +1,51 @@
+#include "BookManager.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+BookManager::BookManager(const std::vector<std::string> & symbols, const OrderBookConfig & config)
+{
+    for (const auto & s : symbols) {
+        m_symbols.intern(s);
+    }
+    m_size = std::max<size_t>(1, m_symbols.size());
+    m_entries = std::allocator<Entry>().allocate(m_size);
+    for (size_t i = 0; i < m_size; ++i) {
+        new (m_entries + i) Entry();
+        m_entries[i].book.configure(config);
+    }
+}
+
+BookManager::~BookManager()
+{
+    for (size_t i = 0; i < m_size; ++i) {
+        m_entries[i].~Entry();
+    }
+    std::allocator<Entry>().deallocate(m_entries, m_size);
+}
+
+void BookManager::clear()
+{
+    for (size_t i = 0; i < m_size; ++i) {
+        auto & e = m_entries[i];
+        std::unique_lock lock(e.mutex);
+        e.book.clear();
+        e.last_update_id = 0;
+        e.consistent = true;
+    }
+}
+
+OrderBook BookManager::copy_top(const Id id, const size_t levels_num) const
+{
+    const auto & e = m_entries[id];
+    std::shared_lock lock(e.mutex);
+    return e.book.copy_top(levels_num);
+}
+
+BookAnalytics BookManager::get_analytics(const Id id) const
+{
+    const auto & e = m_entries[id];
+    std::shared_lock lock(e.mutex);
+    return e.book.get_analytics();
+}
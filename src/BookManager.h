@@ -0,0 +1,69 @@
+#pragma once
+
+#include "OrderBook.h"
+#include "SymbolTable.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Order books of all symbols of one feed in a flat table indexed by the
+// dense id of SymbolTable. Each entry is aligned to its own cache lines, so
+// the feed thread updating one book does not invalidate lines readers of
+// a neighbour book are spinning on. Each book draws its levels from a pool
+// of its own, whose chunks come from the heap separately, so levels of
+// different books do not share cache lines either. Only the feed thread
+// allocates from the pools.
+//
+// Without symbols the manager keeps a single book, which takes messages
+// of any symbol.
+class BookManager
+{
+public:
+    using Id = SymbolTable::Id;
+    static constexpr Id npos = SymbolTable::npos;
+
+    struct alignas(64) Entry
+    {
+        Entry()
+            : resource(std::pmr::pool_options{0, 1 << 20})
+            , book(&resource)
+        { }
+
+        mutable std::shared_mutex mutex; // guards everything below
+        std::pmr::unsynchronized_pool_resource resource; // level storage of this book only
+        OrderBook book;
+        uint64_t last_update_id = 0;
+        bool consistent = true; // no snapshot resync yet, a gap spoils the book till the next session
+    };
+
+    explicit BookManager(const std::vector<std::string> & symbols = {}, const OrderBookConfig & config = OrderBookConfig());
+    ~BookManager();
+
+    BookManager(const BookManager &) = delete;
+    BookManager & operator=(const BookManager &) = delete;
+
+    // npos if the symbol is not managed
+    Id route(std::string_view symbol) const { return m_symbols.empty() ? 0 : m_symbols.find(symbol); }
+
+    size_t size() const { return m_size; }
+    // Empty for the single book without symbols
+    std::string_view get_symbol(Id id) const { return m_symbols.empty() ? std::string_view() : m_symbols.name(id); }
+
+    // Feed thread side, the caller takes the entry's lock
+    Entry & operator[](Id id) { return m_entries[id]; }
+    // Empties every book and forgets its update ids, as before the first message
+    void clear();
+
+    // Reader side, under the entry's shared lock
+    OrderBook copy_top(Id id, size_t levels_num) const;
+    BookAnalytics get_analytics(Id id) const;
+
+private:
+    SymbolTable m_symbols;
+    size_t m_size;
+    Entry * m_entries;
+};
@@ -0,0 +1,48 @@
+#include "BookPublisher.h"
+
+#include <thread>
+
+void BookPublisher::lock()
+{
+    while (m_writer.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void BookPublisher::set_source(const IJsonDataListener * source, const std::string_view source_name)
+{
+    if (is_source(source)) {
+        return;
+    }
+    lock();
+    on_source_changed(source_name);
+    m_source.store(source, std::memory_order_release);
+    unlock();
+}
+
+bool BookPublisher::publish(const IJsonDataListener * source, const BookUpdate & update)
+{
+    if (!is_source(source)) {
+        return false;
+    }
+    lock();
+    if (!is_source(source)) { // source was switched while waiting
+        unlock();
+        return false;
+    }
+    write(update);
+    unlock();
+    return true;
+}
+
+void BookPublisher::reset(const IJsonDataListener * source)
+{
+    if (!is_source(source)) {
+        return;
+    }
+    lock();
+    if (is_source(source)) {
+        on_reset();
+    }
+    unlock();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "OrderBook.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class IJsonDataListener;
+
+struct LevelChange
+{
+    OrderBook::Side side;
+    double price;
+    double volume; // 0 removes the level
+};
+
+struct BookUpdate
+{
+    uint64_t update_id;
+    std::chrono::milliseconds event_time;
+    const OrderBook & book;                  // after the changes are applied
+    const std::vector<LevelChange> & changes;
+};
+
+// Forwards order book updates of one selected source listener out of the
+// process. Every listener may call publish(), only the one set with
+// set_source() gets through, so the output follows the best listener.
+// A writer spinlock keeps two listeners from interleaving while the source
+// is switched.
+class BookPublisher
+{
+public:
+    virtual ~BookPublisher() = default;
+
+    void set_source(const IJsonDataListener * source, std::string_view source_name);
+    bool is_source(const IJsonDataListener * source) const { return m_source.load(std::memory_order_acquire) == source; }
+
+    bool publish(const IJsonDataListener * source, const BookUpdate & update);
+    // The book of source was cleared, its next update must not be applied
+    // on top of what was published before
+    void reset(const IJsonDataListener * source);
+
+protected:
+    // All three are called under the writer lock
+    virtual void on_source_changed(std::string_view source_name) = 0;
+    virtual void on_reset() = 0;
+    virtual void write(const BookUpdate & update) = 0;
+
+private:
+    void lock();
+    void unlock() { m_writer.clear(std::memory_order_release); }
+
+private:
+    std::atomic<const IJsonDataListener *> m_source{nullptr};
+    std::atomic_flag m_writer = ATOMIC_FLAG_INIT;
+};
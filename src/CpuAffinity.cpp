@@ -0,0 +1,192 @@
+#include "CpuAffinity.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace affinity {
+
+namespace {
+
+int parse_cpu(const std::string_view s, const std::string_view list)
+{
+    if (s.empty() || s.size() > 5 || !std::all_of(s.begin(), s.end(), [] (const char c) { return c >= '0' && c <= '9'; })) {
+        throw std::invalid_argument("malformed CPU list: " + std::string(list));
+    }
+    return std::stoi(std::string(s));
+}
+
+}
+
+std::vector<int> parse_cpu_list(const std::string_view list)
+{
+    std::vector<int> ret;
+    std::size_t begin = 0;
+    while (begin < list.size()) {
+        auto end = list.find(',', begin);
+        if (end == std::string_view::npos) {
+            end = list.size();
+        }
+        const auto range = list.substr(begin, end - begin);
+        const auto dash = range.find('-');
+        const auto first = parse_cpu(range.substr(0, dash), list);
+        const auto last = dash == std::string_view::npos ? first : parse_cpu(range.substr(dash + 1), list);
+        if (last < first) {
+            throw std::invalid_argument("malformed CPU list: " + std::string(list));
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            ret.push_back(cpu);
+        }
+        begin = end + 1;
+    }
+    std::sort(ret.begin(), ret.end());
+    ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+    return ret;
+}
+
+int numa_node(const int cpu)
+{
+    // the CPU's directory has a node<N> link to its node
+    std::error_code ec;
+    const auto path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (std::filesystem::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+        const auto name = it->path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 && std::isdigit(static_cast<unsigned char>(name[4]))) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return 0;
+}
+
+std::vector<int> isolated_cpus()
+{
+    std::ifstream in("/sys/devices/system/cpu/isolated");
+    std::string line;
+    if (!std::getline(in, line) || line.empty()) {
+        return {};
+    }
+    try {
+        return parse_cpu_list(line);
+    } catch (const std::invalid_argument &) {
+        return {};
+    }
+}
+
+std::vector<int> allowed_cpus()
+{
+    std::vector<int> ret;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                ret.push_back(cpu);
+            }
+        }
+    }
+    return ret;
+}
+
+std::vector<Cpu> make_cpus(const std::vector<int> & ids)
+{
+    std::vector<Cpu> ret;
+    ret.reserve(ids.size());
+    for (const auto id : ids) {
+        ret.push_back({id, numa_node(id)});
+    }
+    return ret;
+}
+
+std::string pin_thread(const int cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return "no such CPU";
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    const auto ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    return ret == 0 ? std::string() : std::strerror(ret);
+}
+
+int incoming_cpu(const int fd)
+{
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t size = sizeof(cpu);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &size) == 0) {
+        return cpu;
+    }
+#endif
+    return -1;
+}
+
+CpuPool::CpuPool(std::vector<Cpu> cpus, const bool follow_interrupts)
+    : m_cpus(std::move(cpus))
+    , m_follow_interrupts(follow_interrupts)
+    , m_users(m_cpus.size(), 0)
+{
+    if (m_cpus.empty()) {
+        throw std::invalid_argument("no CPUs to place connectors on");
+    }
+}
+
+Cpu CpuPool::acquire()
+{
+    std::lock_guard lock(m_mutex);
+    const auto i = std::min_element(m_users.begin(), m_users.end()) - m_users.begin();
+    ++m_users[i];
+    return m_cpus[i];
+}
+
+void CpuPool::release(const Cpu & cpu)
+{
+    std::lock_guard lock(m_mutex);
+    for (std::size_t i = 0; i < m_cpus.size(); ++i) {
+        if (m_cpus[i].id == cpu.id && m_users[i] > 0) {
+            --m_users[i];
+            return;
+        }
+    }
+}
+
+Cpu CpuPool::move_near(const Cpu & current, const Cpu & rx_cpu)
+{
+    std::lock_guard lock(m_mutex);
+    const auto index_of = [this] (const int id) {
+        return std::find_if(m_cpus.begin(), m_cpus.end(), [id] (const Cpu & cpu) { return cpu.id == id; }) - m_cpus.begin();
+    };
+    const std::ptrdiff_t none = m_cpus.size();
+    // the receiving CPU itself, otherwise the least used one of its node
+    auto target = index_of(rx_cpu.id);
+    if (target == none) {
+        if (current.node == rx_cpu.node) {
+            return current;
+        }
+        for (std::ptrdiff_t i = 0; i < none; ++i) {
+            if (m_cpus[i].node == rx_cpu.node && (target == none || m_users[i] < m_users[target])) {
+                target = i;
+            }
+        }
+        if (target == none) {
+            return current;
+        }
+    }
+    if (m_cpus[target].id == current.id) {
+        return current;
+    }
+    if (const auto from = index_of(current.id); from != none && m_users[from] > 0) {
+        --m_users[from];
+    }
+    ++m_users[target];
+    return m_cpus[target];
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Placement of connector threads on CPUs. A thread pinned to one core
+// keeps its caches and its NUMA node, so latency differences between IPs
+// are not scheduler noise; memory it touches first, its buffers and the
+// pages of its books, comes from the node of that core.
+namespace affinity {
+
+struct Cpu
+{
+    int id = -1;
+    int node = 0; // NUMA node
+};
+
+// CPUs of a list as in sysfs and taskset -c, e.g. "2-5,8"; throws
+// std::invalid_argument if it is malformed
+std::vector<int> parse_cpu_list(std::string_view list);
+
+// NUMA node of a CPU from sysfs, 0 if it is not known
+int numa_node(int cpu);
+
+// Cores taken out of the scheduler by isolcpus, empty if there are none
+std::vector<int> isolated_cpus();
+
+// CPUs this process may run on
+std::vector<int> allowed_cpus();
+
+std::vector<Cpu> make_cpus(const std::vector<int> & ids);
+
+// Pins the calling thread to cpu, returns why it is not possible or an empty string
+std::string pin_thread(int cpu);
+
+// CPU which processed the last packet received on the socket, where the
+// NIC interrupt or RPS put its receive queue; -1 if it is not known yet
+int incoming_cpu(int fd);
+
+// CPUs shared by connectors, every connector takes the least used one.
+// Following interrupts, a connector moves next to the CPU its packets
+// are received on: onto that CPU if it is in the pool, otherwise onto
+// the least used one of the same NUMA node.
+class CpuPool
+{
+public:
+    CpuPool(std::vector<Cpu> cpus, bool follow_interrupts);
+
+    bool follows_interrupts() const { return m_follow_interrupts; }
+    const std::vector<Cpu> & cpus() const { return m_cpus; }
+
+    Cpu acquire();
+    void release(const Cpu & cpu);
+
+    // CPU to move current to for packets received on rx_cpu, current itself
+    // if there is nothing closer; usage is moved along
+    Cpu move_near(const Cpu & current, const Cpu & rx_cpu);
+
+private:
+    std::vector<Cpu> m_cpus;
+    const bool m_follow_interrupts;
+    std::mutex m_mutex;
+    std::vector<unsigned> m_users; // per CPU of m_cpus
+};
+
+}
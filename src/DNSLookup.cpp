@@ -39,43 +39,48 @@ class DNSResolver
 #include <resolv.h>
 #include <arpa/inet.h>
 
-#ifndef C_ANY
-#define C_ANY 255
-#endif
-
 class DNSResolver
     : public IDNSLookup
 {
     std::vector<IPAddress> resolve(const std::string & domain) final  // Can be replaced with boost asio resolve
+    {
+        // servers answer ANY queries minimally (RFC 8482), so both families are asked for one by one
+        std::vector<IPAddress> ret;
+        query(domain, ns_t_a, ret);
+        query(domain, ns_t_aaaa, ret);
+        return ret;
+    }
+
+    static void query(const std::string & domain, const ns_type type, std::vector<IPAddress> & ret)
     {
         u_char res[NS_MAXDNAME];
-        const auto len = res_query(domain.c_str(), C_ANY, C_ANY, res, sizeof(res));
-        LOG_LINE("ret res_query(): " << len);
+        const auto len = res_query(domain.c_str(), ns_c_in, type, res, sizeof(res));
+        LOG_LINE("ret res_query(" << type << "): " << len);
         if (len > 0) {
             ns_msg handle;
             if (const auto err = ns_initparse(res, len, &handle); err < 0) {
                 LOG_LINE("err ns_initparse(): " << err);
-                return {};
+                return;
             }
             ns_rr rr;
             ns_sect section = ns_s_an;
             const auto count = ns_msg_count(handle, section);
-            std::vector<IPAddress> ret;
-            ret.reserve(count);
+            ret.reserve(ret.size() + count);
             for (size_t rrnum = 0; rrnum < count; rrnum++) {
                 if (const auto err = ns_parserr(&handle, ns_s_an, rrnum, &rr); err < 0) {
                     LOG_LINE("err ns_parserr(): " << err);
-                    return {};
+                    return;
                 }
-                if (ns_rr_type(rr) == ns_t_a) {
-                    const auto rr_data = ns_rr_rdata(rr);
-                    const auto addr = (in_addr *)(rr_data);
-                    ret.emplace_back(inet_ntoa(*addr));
+                // CNAMEs come along in the answer section
+                if (ns_rr_type(rr) == ns_t_a || ns_rr_type(rr) == ns_t_aaaa) {
+                    char addr[INET6_ADDRSTRLEN];
+                    const auto family = ns_rr_type(rr) == ns_t_a ? AF_INET : AF_INET6;
+                    if (inet_ntop(family, ns_rr_rdata(rr), addr, sizeof(addr)) != nullptr) {
+                        ret.emplace_back(addr);
+                    }
                 }
             }
-            return ret;
         }
-        return {};
     }
 };
 #endif
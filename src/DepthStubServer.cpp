@@ -0,0 +1,407 @@
+#include "DepthStubServer.h"
+
+#include "Log.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace binance {
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+
+namespace {
+
+using Batch = std::vector<std::string>;
+using BatchPtr = std::shared_ptr<const Batch>;
+using Clock = std::chrono::steady_clock;
+
+// Connector does not verify certificates, so a throwaway one is enough
+void use_self_signed_certificate(asio::ssl::context & ctx)
+{
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> pctx(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free);
+    EVP_PKEY * raw_key = nullptr;
+    if (!pctx || EVP_PKEY_keygen_init(pctx.get()) <= 0
+            || EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx.get(), NID_X9_62_prime256v1) <= 0
+            || EVP_PKEY_keygen(pctx.get(), &raw_key) <= 0) {
+        throw std::runtime_error("could not generate private key");
+    }
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(raw_key, EVP_PKEY_free);
+
+    std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 365 * 24 * 3600L);
+    X509_set_pubkey(cert.get(), key.get());
+    const auto name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+    if (!X509_sign(cert.get(), key.get(), EVP_sha256())) {
+        throw std::runtime_error("could not sign certificate");
+    }
+    if (SSL_CTX_use_certificate(ctx.native_handle(), cert.get()) != 1
+            || SSL_CTX_use_PrivateKey(ctx.native_handle(), key.get()) != 1) {
+        throw std::runtime_error("could not use generated certificate");
+    }
+}
+
+class Session
+    : public std::enable_shared_from_this<Session>
+{
+public:
+    Session(asio::ip::tcp::socket socket, asio::ssl::context & ctx, const std::chrono::microseconds delay, const size_t max_queued, const bool compression, std::atomic<size_t> & sent)
+        : m_ws(std::move(socket), ctx)
+        , m_timer(m_ws.get_executor())
+        , m_delay(delay)
+        , m_max_queued(max_queued)
+        , m_sent(sent)
+    {
+        if (compression) {
+            beast::websocket::permessage_deflate deflate;
+            deflate.server_enable = true;
+            m_ws.set_option(deflate);
+        }
+    }
+
+    template <class OnReady>
+    void run(OnReady on_ready)
+    {
+        m_ws.next_layer().async_handshake(asio::ssl::stream_base::server,
+            [self = shared_from_this(), on_ready = std::move(on_ready)] (const auto ec) mutable {
+                if (ec) {
+                    LOG_LINE("stub session TLS handshake failed: " << ec.message());
+                    return;
+                }
+                self->m_ws.text(true);
+                self->m_ws.async_accept([self, on_ready = std::move(on_ready)] (const auto ec) mutable {
+                    if (ec) {
+                        LOG_LINE("stub session websocket accept failed: " << ec.message());
+                        return;
+                    }
+                    self->read_next();
+                    on_ready(self);
+                });
+            }
+        );
+    }
+
+    // May be called from any thread
+    void enqueue(BatchPtr batch, const Clock::time_point generated)
+    {
+        asio::post(m_ws.get_executor(), [self = shared_from_this(), batch = std::move(batch), due = generated + m_delay] () mutable {
+            if (self->m_closed) {
+                return;
+            }
+            self->m_queued += batch->size();
+            if (self->m_queued > self->m_max_queued) {
+                ALWAYS_LOG("stub session is too slow, " << self->m_queued << " messages queued, closing");
+                self->close();
+                return;
+            }
+            self->m_queue.push_back({due, std::move(batch)});
+            if (!self->m_writing && !self->m_waiting) {
+                self->schedule();
+            }
+        });
+    }
+
+    bool is_closed() const { return m_closed.load(std::memory_order_acquire); }
+
+private:
+    struct Pending
+    {
+        Clock::time_point due;
+        BatchPtr batch;
+    };
+
+    // Reading is needed to answer pings and to notice client disconnects
+    void read_next()
+    {
+        m_ws.async_read(m_read_buffer, [self = shared_from_this()] (const auto ec, std::size_t) {
+            if (ec) {
+                LOG_LINE("stub session read finished: " << ec.message());
+                self->m_closed = true;
+                return;
+            }
+            self->m_read_buffer.clear();
+            self->read_next();
+        });
+    }
+
+    void schedule()
+    {
+        if (m_queue.empty() || m_closed) {
+            return;
+        }
+        const auto due = m_queue.front().due;
+        if (due <= Clock::now()) {
+            write_next();
+            return;
+        }
+        m_waiting = true;
+        m_timer.expires_at(due);
+        m_timer.async_wait([self = shared_from_this()] (const auto ec) {
+            self->m_waiting = false;
+            if (!ec) {
+                self->schedule();
+            }
+        });
+    }
+
+    void write_next()
+    {
+        m_writing = true;
+        const auto & msg = (*m_queue.front().batch)[m_batch_idx];
+        m_ws.async_write(asio::buffer(msg), [self = shared_from_this()] (const auto ec, std::size_t) {
+            self->m_writing = false;
+            if (ec || self->m_closed) {
+                if (ec) {
+                    LOG_LINE("stub session write failed: " << ec.message());
+                }
+                self->m_closed = true;
+                // the batch written from is not needed anymore
+                self->m_queue.clear();
+                return;
+            }
+            self->m_sent.fetch_add(1, std::memory_order_relaxed);
+            --self->m_queued;
+            if (++self->m_batch_idx == self->m_queue.front().batch->size()) {
+                self->m_batch_idx = 0;
+                self->m_queue.pop_front();
+            }
+            self->schedule();
+        });
+    }
+
+    void close()
+    {
+        m_closed = true;
+        // a write in flight still reads the front batch, its handler drops it;
+        // a wait for the due time holds no batch and is cancelled below
+        if (m_writing && !m_queue.empty()) {
+            m_queue.erase(std::next(m_queue.begin()), m_queue.end());
+        } else {
+            m_queue.clear();
+        }
+        m_timer.cancel();
+        beast::get_lowest_layer(m_ws).close();
+    }
+
+private:
+    beast::websocket::stream<asio::ssl::stream<asio::ip::tcp::socket>> m_ws;
+    asio::steady_timer m_timer;
+    beast::flat_buffer m_read_buffer;
+
+    const std::chrono::microseconds m_delay;
+    const size_t m_max_queued;
+    std::atomic<size_t> & m_sent;
+
+    std::deque<Pending> m_queue;
+    size_t m_batch_idx = 0;
+    size_t m_queued = 0;
+    bool m_writing = false; // async_write in flight
+    bool m_waiting = false; // for the due time of the front batch
+    std::atomic<bool> m_closed = false;
+};
+
+}
+
+class DepthStubServer::Impl
+{
+public:
+    explicit Impl(Config config)
+        : m_config(std::move(config))
+        , m_ssl_context(asio::ssl::context::tls_server)
+        , m_feed_strand(asio::make_strand(m_io_context))
+        , m_feed_timer(m_feed_strand)
+        , m_period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_config.burst_size / m_config.rate)))
+    {
+        use_self_signed_certificate(m_ssl_context);
+        if (m_config.symbols.empty()) {
+            m_config.symbols.push_back(m_config.generator.symbol);
+        }
+        for (const auto & symbol : m_config.symbols) {
+            auto config = m_config.generator;
+            config.symbol = symbol;
+            config.seed += static_cast<uint32_t>(m_generators.size());
+            m_generators.emplace_back(std::move(config));
+        }
+    }
+
+    ~Impl()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        for (const auto & l : m_config.listeners) {
+            const asio::ip::tcp::endpoint endpoint(asio::ip::make_address(l.ip), l.port);
+            auto & acceptor = m_acceptors.emplace_back(asio::make_strand(m_io_context));
+            acceptor.open(endpoint.protocol());
+            acceptor.set_option(asio::socket_base::reuse_address(true));
+            acceptor.bind(endpoint);
+            acceptor.listen();
+            m_ports.push_back(acceptor.local_endpoint().port());
+            ALWAYS_LOG("stub server listening on " << acceptor.local_endpoint() << " with injected delay " << l.delay.count() << "us");
+            accept_next(acceptor, l.delay);
+        }
+
+        m_next_emit = Clock::now();
+        asio::post(m_feed_strand, [this] { emit(); });
+
+        m_work.emplace(m_io_context.get_executor());
+        for (size_t i = 0; i < std::max<size_t>(1, m_config.threads); ++i) {
+            m_threads.emplace_back([this] { m_io_context.run(); });
+        }
+    }
+
+    void stop()
+    {
+        m_work.reset();
+        if (!m_io_context.stopped()) {
+            m_io_context.stop();
+        }
+        for (auto & t : m_threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        m_threads.clear();
+    }
+
+    size_t get_sent_messages() const { return m_sent.load(std::memory_order_relaxed); }
+    const std::vector<Port> & get_ports() const { return m_ports; }
+
+    size_t get_connections() const
+    {
+        std::lock_guard lock(m_sessions_mutex);
+        return std::count_if(m_sessions.begin(), m_sessions.end(), [] (const auto & s) {
+            const auto session = s.lock();
+            return session && !session->is_closed();
+        });
+    }
+
+private:
+    void accept_next(asio::ip::tcp::acceptor & acceptor, const std::chrono::microseconds delay)
+    {
+        acceptor.async_accept(asio::make_strand(m_io_context), [this, &acceptor, delay] (const auto ec, asio::ip::tcp::socket socket) {
+            if (ec) {
+                ALWAYS_LOG("stub server accept failed: " << ec.message());
+                return;
+            }
+            socket.set_option(asio::ip::tcp::no_delay(true));
+            LOG_LINE("stub server accepted " << socket.remote_endpoint());
+            std::make_shared<Session>(std::move(socket), m_ssl_context, delay, m_config.max_queued_messages, m_config.compression, m_sent)->run([this] (std::shared_ptr<Session> session) {
+                std::lock_guard lock(m_sessions_mutex);
+                m_sessions.push_back(std::move(session));
+            });
+            accept_next(acceptor, delay);
+        });
+    }
+
+    // Generates every burst that is due and hands the batch to all sessions at once
+    void emit()
+    {
+        using namespace std::chrono_literals;
+
+        const auto now = Clock::now();
+        auto batch = std::make_shared<Batch>();
+        const auto event_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+        while (m_next_emit <= now) {
+            for (size_t i = 0; i < m_config.burst_size; ++i) {
+                m_generators[m_next_generator].next(batch->emplace_back(), event_time);
+                m_next_generator = (m_next_generator + 1) % m_generators.size();
+            }
+            m_next_emit += m_period;
+        }
+        if (now - m_next_emit > 1s) { // cannot keep up, do not try to catch up the backlog
+            m_next_emit = now + m_period;
+        }
+        if (!batch->empty()) {
+            std::lock_guard lock(m_sessions_mutex);
+            BatchPtr shared_batch = std::move(batch);
+            m_sessions.erase(std::remove_if(m_sessions.begin(), m_sessions.end(), [&] (const auto & s) {
+                const auto session = s.lock();
+                if (!session || session->is_closed()) {
+                    return true;
+                }
+                session->enqueue(shared_batch, now);
+                return false;
+            }), m_sessions.end());
+        }
+        m_feed_timer.expires_at(m_next_emit);
+        m_feed_timer.async_wait([this] (const auto ec) {
+            if (!ec) {
+                emit();
+            }
+        });
+    }
+
+private:
+    Config m_config;
+
+    asio::io_context m_io_context;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> m_work;
+    std::vector<std::thread> m_threads;
+    asio::ssl::context m_ssl_context;
+    std::deque<asio::ip::tcp::acceptor> m_acceptors;
+    std::vector<Port> m_ports;
+
+    asio::strand<asio::io_context::executor_type> m_feed_strand;
+    asio::steady_timer m_feed_timer;
+    std::vector<DepthUpdateGenerator> m_generators;
+    size_t m_next_generator = 0;
+    const Clock::duration m_period;
+    Clock::time_point m_next_emit;
+
+    mutable std::mutex m_sessions_mutex;
+    std::vector<std::weak_ptr<Session>> m_sessions;
+    std::atomic<size_t> m_sent = 0;
+};
+
+DepthStubServer::DepthStubServer(Config config)
+    : m_impl(std::make_unique<DepthStubServer::Impl>(std::move(config)))
+{ }
+
+DepthStubServer::~DepthStubServer() = default;
+
+void DepthStubServer::start()
+{
+    return m_impl->start();
+}
+
+void DepthStubServer::stop()
+{
+    return m_impl->stop();
+}
+
+size_t DepthStubServer::get_sent_messages() const
+{
+    return m_impl->get_sent_messages();
+}
+
+size_t DepthStubServer::get_connections() const
+{
+    return m_impl->get_connections();
+}
+
+std::vector<Port> DepthStubServer::get_ports() const
+{
+    return m_impl->get_ports();
+}
+
+}
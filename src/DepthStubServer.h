@@ -0,0 +1,57 @@
+#pragma once
+
+#include "DepthUpdateGenerator.h"
+#include "IPAddress.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace binance {
+
+// Local TLS websocket server emitting Binance-format depthUpdate messages,
+// or messages of another stream type set in the generator config.
+// Every accepted connection receives the same generated stream, delayed by
+// the injected delay of the listener it came through, so several loopback
+// addresses with different delays emulate endpoints with different latency.
+class DepthStubServer
+{
+    class Impl;
+public:
+    struct Listener
+    {
+        IPAddress ip;
+        Port port;
+        std::chrono::microseconds delay{0};
+    };
+
+    struct Config
+    {
+        std::vector<Listener> listeners;
+        double rate = 1000; // messages per second
+        size_t burst_size = 1; // messages sent back-to-back, bursts are spaced to keep the rate
+        size_t threads = 1;
+        size_t max_queued_messages = 1000000; // per connection, slower clients are dropped
+        bool compression = false; // takes permessage-deflate if a client offers it
+        DepthUpdateGenerator::Config generator;
+        // Messages cycle through the symbols, each one has its own generated book; empty means generator.symbol only
+        std::vector<std::string> symbols;
+    };
+
+    explicit DepthStubServer(Config config);
+    ~DepthStubServer();
+
+    void start();
+    void stop();
+
+    size_t get_sent_messages() const;
+    size_t get_connections() const;
+    // Bound ports in the order of the listeners, port 0 of a listener gets a free one; after start()
+    std::vector<Port> get_ports() const;
+
+private:
+    std::unique_ptr<Impl> m_impl;
+};
+
+}
@@ -0,0 +1,214 @@
+#include "DepthUpdateGenerator.h"
+
+#include <charconv>
+
+namespace binance {
+
+namespace {
+constexpr int64_t units_per_one = 100000000; // Binance sends 8 decimals
+
+void append_int(std::string & out, const uint64_t v)
+{
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, res.ptr);
+}
+
+void append_decimal(std::string & out, const int64_t units)
+{
+    append_int(out, units / units_per_one);
+    out += '.';
+    char buf[8];
+    auto frac = units % units_per_one;
+    for (int i = 7; i >= 0; --i) {
+        buf[i] = '0' + frac % 10;
+        frac /= 10;
+    }
+    out.append(buf, sizeof(buf));
+}
+}
+
+DepthUpdateGenerator::DepthUpdateGenerator(Config config)
+    : m_config(std::move(config))
+    , m_rng(m_config.seed)
+{ }
+
+void DepthUpdateGenerator::append_header(std::string & out, const std::chrono::milliseconds event_time, const uint64_t first_id, const uint64_t last_id) const
+{
+    out += R"({"e":"depthUpdate","E":)";
+    append_int(out, event_time.count());
+    out += R"(,"s":")";
+    out += m_config.symbol;
+    out += R"(","U":)";
+    append_int(out, first_id);
+    out += R"(,"u":)";
+    append_int(out, last_id);
+}
+
+void DepthUpdateGenerator::append_level(std::string & out, const int64_t price_ticks, const int64_t quantity) const
+{
+    out += "[\"";
+    append_decimal(out, price_ticks * m_config.tick_size);
+    out += "\",\"";
+    append_decimal(out, quantity);
+    out += "\"]";
+}
+
+size_t DepthUpdateGenerator::pick_level()
+{
+    // cubic skew: half of the updates hit the top ~12% of the book
+    const auto u = m_uniform(m_rng);
+    return static_cast<size_t>(u * u * u * m_config.book_depth);
+}
+
+int64_t DepthUpdateGenerator::pick_quantity()
+{
+    if (m_uniform(m_rng) < m_config.remove_ratio) {
+        return 0;
+    }
+    return 1 + static_cast<int64_t>(m_uniform(m_rng) * 5 * units_per_one);
+}
+
+void DepthUpdateGenerator::snapshot(std::string & out, const std::chrono::milliseconds event_time)
+{
+    out.clear();
+    const auto first_id = m_update_id;
+    m_update_id += 2 * m_config.book_depth;
+    append_header(out, event_time, first_id, m_update_id - 1);
+    out += R"(,"b":[)";
+    for (size_t i = 0; i < m_config.book_depth; ++i) {
+        if (i) {
+            out += ',';
+        }
+        append_level(out, m_config.mid_price_ticks - 1 - static_cast<int64_t>(i), 1 + (i + 1) * units_per_one / 100);
+    }
+    out += R"(],"a":[)";
+    for (size_t i = 0; i < m_config.book_depth; ++i) {
+        if (i) {
+            out += ',';
+        }
+        append_level(out, m_config.mid_price_ticks + 1 + static_cast<int64_t>(i), 1 + (i + 1) * units_per_one / 100);
+    }
+    out += "]}";
+}
+
+void DepthUpdateGenerator::next(std::string & out, const std::chrono::milliseconds event_time)
+{
+    out.clear();
+    switch (m_config.stream) {
+    case StreamType::Depth:
+        return next_depth(out, event_time);
+    case StreamType::PartialDepth:
+        return next_partial_depth(out);
+    case StreamType::BookTicker:
+        return next_book_ticker(out);
+    case StreamType::Trade:
+    case StreamType::AggTrade:
+        return next_trade(out, event_time);
+    }
+}
+
+void DepthUpdateGenerator::next_depth(std::string & out, const std::chrono::milliseconds event_time)
+{
+    const auto first_id = m_update_id;
+    m_update_id += m_config.levels_per_update;
+    append_header(out, event_time, first_id, m_update_id - 1);
+
+    const auto bids_num = m_config.levels_per_update / 2;
+    out += R"(,"b":[)";
+    for (size_t i = 0; i < bids_num; ++i) {
+        if (i) {
+            out += ',';
+        }
+        append_level(out, m_config.mid_price_ticks - 1 - static_cast<int64_t>(pick_level()), pick_quantity());
+    }
+    out += R"(],"a":[)";
+    for (size_t i = bids_num; i < m_config.levels_per_update; ++i) {
+        if (i != bids_num) {
+            out += ',';
+        }
+        append_level(out, m_config.mid_price_ticks + 1 + static_cast<int64_t>(pick_level()), pick_quantity());
+    }
+    out += "]}";
+}
+
+void DepthUpdateGenerator::next_partial_depth(std::string & out)
+{
+    // spot partial depth has no event time and no symbol
+    m_update_id += m_config.levels_per_update;
+    out += R"({"lastUpdateId":)";
+    append_int(out, m_update_id - 1);
+    out += R"(,"bids":[)";
+    for (size_t i = 0; i < m_config.partial_levels; ++i) {
+        if (i) {
+            out += ',';
+        }
+        append_level(out, m_config.mid_price_ticks - 1 - static_cast<int64_t>(i), pick_quantity() + 1);
+    }
+    out += R"(],"asks":[)";
+    for (size_t i = 0; i < m_config.partial_levels; ++i) {
+        if (i) {
+            out += ',';
+        }
+        append_level(out, m_config.mid_price_ticks + 1 + static_cast<int64_t>(i), pick_quantity() + 1);
+    }
+    out += "]}";
+}
+
+void DepthUpdateGenerator::next_book_ticker(std::string & out)
+{
+    // spot bookTicker has no event time; the spread is one to three ticks
+    const auto bid = m_config.mid_price_ticks - 1 - static_cast<int64_t>(m_uniform(m_rng) * 2);
+    const auto ask = m_config.mid_price_ticks + 1 + static_cast<int64_t>(m_uniform(m_rng) * 2);
+    out += R"({"u":)";
+    append_int(out, m_update_id++);
+    out += R"(,"s":")";
+    out += m_config.symbol;
+    out += R"(","b":")";
+    append_decimal(out, bid * m_config.tick_size);
+    out += R"(","B":")";
+    append_decimal(out, 1 + static_cast<int64_t>(m_uniform(m_rng) * 5 * units_per_one));
+    out += R"(","a":")";
+    append_decimal(out, ask * m_config.tick_size);
+    out += R"(","A":")";
+    append_decimal(out, 1 + static_cast<int64_t>(m_uniform(m_rng) * 5 * units_per_one));
+    out += R"("})";
+}
+
+void DepthUpdateGenerator::next_trade(std::string & out, const std::chrono::milliseconds event_time)
+{
+    const bool buyer_maker = m_uniform(m_rng) < 0.5;
+    const auto price = buyer_maker ? m_config.mid_price_ticks - 1 : m_config.mid_price_ticks + 1;
+    const bool aggregated = m_config.stream == StreamType::AggTrade;
+    out += aggregated ? R"({"e":"aggTrade","E":)" : R"({"e":"trade","E":)";
+    append_int(out, event_time.count());
+    out += R"(,"s":")";
+    out += m_config.symbol;
+    out += aggregated ? R"(","a":)" : R"(","t":)";
+    append_int(out, m_update_id);
+    out += R"(,"p":")";
+    append_decimal(out, price * m_config.tick_size);
+    out += R"(","q":")";
+    append_decimal(out, pick_quantity() + 1);
+    if (aggregated) {
+        out += R"(","f":)";
+        append_int(out, m_update_id);
+        out += R"(,"l":)";
+        append_int(out, m_update_id);
+        out += R"(,"T":)";
+    } else {
+        out += R"(","T":)";
+    }
+    ++m_update_id;
+    append_int(out, event_time.count());
+    out += buyer_maker ? R"(,"m":true,"M":true})" : R"(,"m":false,"M":true})";
+}
+
+std::string DepthUpdateGenerator::next(const std::chrono::milliseconds event_time)
+{
+    std::string ret;
+    next(ret, event_time);
+    return ret;
+}
+
+}
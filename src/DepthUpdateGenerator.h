@@ -0,0 +1,63 @@
+#pragma once
+
+#include "StreamType.h"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace binance {
+
+// Produces Binance-format depthUpdate messages for a synthetic book.
+// Levels live on a fixed tick grid around the mid price, updates are
+// skewed towards the top of the book, and a share of them remove levels,
+// so a consumer's book stays around `book_depth` levels per side.
+// With another stream type next() produces partial depth, bookTicker,
+// trade or aggTrade messages around the same mid price instead.
+class DepthUpdateGenerator
+{
+public:
+    struct Config
+    {
+        std::string symbol = "BTCUSDT";
+        StreamType stream = StreamType::Depth;
+        size_t partial_levels = 20; // of StreamType::PartialDepth
+        int64_t mid_price_ticks = 5000000; // 50000.00 with tick 0.01
+        int64_t tick_size = 1000000; // in 1e-8 units, i.e. 0.01
+        size_t book_depth = 1000;
+        size_t levels_per_update = 10;
+        double remove_ratio = 0.2;
+        uint32_t seed = 42;
+    };
+
+    explicit DepthUpdateGenerator(Config config);
+
+    // Message with every level of both sides, useful to prefill a book
+    void snapshot(std::string & out, std::chrono::milliseconds event_time);
+
+    void next(std::string & out, std::chrono::milliseconds event_time);
+    std::string next(std::chrono::milliseconds event_time);
+
+    // Of the last generated message, 0 before the first one
+    uint64_t last_update_id() const { return m_update_id - 1; }
+    const Config & get_config() const { return m_config; }
+
+private:
+    void next_depth(std::string & out, std::chrono::milliseconds event_time);
+    void next_partial_depth(std::string & out);
+    void next_book_ticker(std::string & out);
+    void next_trade(std::string & out, std::chrono::milliseconds event_time);
+    void append_header(std::string & out, std::chrono::milliseconds event_time, uint64_t first_id, uint64_t last_id) const;
+    void append_level(std::string & out, int64_t price_ticks, int64_t quantity) const;
+    size_t pick_level();
+    int64_t pick_quantity();
+
+private:
+    Config m_config;
+    std::mt19937 m_rng;
+    std::uniform_real_distribution<double> m_uniform{0.0, 1.0};
+    uint64_t m_update_id = 1;
+};
+
+}
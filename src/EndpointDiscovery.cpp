@@ -0,0 +1,71 @@
+#include "EndpointDiscovery.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+HostPort parse_host_port(const std::string_view str)
+{
+    const auto malformed = [str] { return std::invalid_argument("endpoint must be host:port or [ipv6]:port, got [" + std::string(str) + "]"); };
+    const auto host_end = str.starts_with('[') ? str.find(']') : str.rfind(':');
+    if (host_end == std::string_view::npos) {
+        throw malformed();
+    }
+    const auto port_pos = str.starts_with('[') ? host_end + 1 : host_end;
+    if (port_pos >= str.size() || str[port_pos] != ':') {
+        throw malformed();
+    }
+    const auto port = str.substr(port_pos + 1);
+    if (port.empty() || port.size() > 5 || !std::all_of(port.begin(), port.end(), [] (const char c) { return c >= '0' && c <= '9'; })) {
+        throw malformed();
+    }
+    const auto value = std::stoul(std::string(port));
+    HostPort ret;
+    ret.host = str.starts_with('[') ? str.substr(1, host_end - 1) : str.substr(0, host_end);
+    if (ret.host.empty() || value == 0 || value > 65535) {
+        throw malformed();
+    }
+    ret.port = static_cast<Port>(value);
+    return ret;
+}
+
+std::string StreamEndpoint::name() const
+{
+    const auto port_str = std::to_string(port);
+    return family_of(ip) == IpFamily::V6 ? '[' + ip + "]:" + port_str : ip + ':' + port_str;
+}
+
+std::string StreamEndpoint::joined_hosts() const
+{
+    std::string ret;
+    for (const auto & host : hosts) {
+        if (!ret.empty()) {
+            ret += ',';
+        }
+        ret += host;
+    }
+    return ret;
+}
+
+std::vector<StreamEndpoint> discover_endpoints(IDNSLookup & resolver, const std::vector<HostPort> & hosts, const IpFamily family)
+{
+    std::vector<StreamEndpoint> ret;
+    for (const auto & host : hosts) {
+        const auto ips = resolver.resolve(host.host);
+        LOG_LINE("Resolved " << host.host << " [" << ips.size() << "]");
+        for (const auto & ip : ips) {
+            if (!matches(family, ip)) {
+                continue;
+            }
+            auto it = std::find_if(ret.begin(), ret.end(), [&] (const StreamEndpoint & e) { return e.ip == ip && e.port == host.port; });
+            if (it == ret.end()) {
+                it = ret.insert(ret.end(), StreamEndpoint{ip, host.port, {}});
+            }
+            if (std::find(it->hosts.begin(), it->hosts.end(), host.host) == it->hosts.end()) {
+                it->hosts.push_back(host.host);
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "DNSLookup.h"
+#include "IPAddress.h"
+#include "IpFamily.h"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binance serves the same streams from several hostnames and ports, e.g.
+// stream.binance.com:9443 and :443 or data-stream.binance.vision:443.
+// All of them are resolved into one list of IP and port pairs to rank
+// together; an IP several hosts resolve to is measured once per port.
+struct HostPort
+{
+    std::string host;
+    Port port = 0;
+
+    friend std::ostream & operator<< (std::ostream & strm, const HostPort & h) { return strm << h.host << ':' << h.port; }
+};
+
+// host:port, IPv6 literals in brackets; throws std::invalid_argument if it is malformed
+HostPort parse_host_port(std::string_view str);
+
+struct StreamEndpoint
+{
+    IPAddress ip;
+    Port port = 0;
+    std::vector<std::string> hosts; // resolved to the ip, in the order of configuration
+
+    // ip:port, [ip]:port for IPv6
+    std::string name() const;
+    std::string joined_hosts() const;
+    // name with the hosts, e.g. 1.2.3.4:443 (stream.binance.com,data-stream.binance.vision)
+    std::string label() const { return name() + " (" + joined_hosts() + ")"; }
+
+    friend std::ostream & operator<< (std::ostream & strm, const StreamEndpoint & e) { return strm << e.label(); }
+};
+
+// Endpoints of every host in the order they are resolved, of the given family only
+std::vector<StreamEndpoint> discover_endpoints(IDNSLookup & resolver, const std::vector<HostPort> & hosts, IpFamily family);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+
+// Delay of a message from the exchange's event time to now. Our delay
+// cannot be more than seconds, therefore we do not need to convert
+// timezones, just need to remove alignment to 15 minutes difference
+// between us and binance server.
+inline std::chrono::microseconds event_latency(const std::chrono::milliseconds event_time, const std::chrono::system_clock::time_point now)
+{
+    using namespace std::chrono_literals;
+
+    const std::chrono::system_clock::time_point event_ts(event_time);
+    const auto diff = now - event_ts;
+    const auto abs_diff = diff > 0us ? diff : -diff;
+
+    constexpr auto minimal_timezone_diff = 15min; // some timezones have 45 mins alignmenent, so 15 minutes here
+
+    const auto minutes_alignment = std::chrono::duration_cast<std::chrono::minutes>(abs_diff) / minimal_timezone_diff;
+    const auto minutes_diff = minutes_alignment * minimal_timezone_diff;
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(abs_diff - minutes_diff);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+
+class IJsonDataListener;
+
+enum class FeedEvent
+{
+    Stale,      // no messages for longer than the watchdog timeout
+    Recovered,  // messages are coming again after Stale
+    Gap,        // update ids are not continuous, the order book is not trusted any more
+};
+
+inline const char * to_string(const FeedEvent e)
+{
+    switch (e) {
+    case FeedEvent::Stale: return "stale";
+    case FeedEvent::Recovered: return "recovered";
+    case FeedEvent::Gap: return "gap";
+    }
+    return "unknown";
+}
+
+inline std::ostream & operator<< (std::ostream & strm, const FeedEvent e) { return strm << to_string(e); }
+
+// Called from feed and watchdog threads, must be thread safe. Feed threads
+// call it under the listener's lock, so it must not call the listener back.
+using FeedEventHandler = std::function<void(const IJsonDataListener &, FeedEvent)>;
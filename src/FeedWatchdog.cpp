@@ -0,0 +1,165 @@
+#include "FeedWatchdog.h"
+
+#include "Log.h"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace asio = boost::asio;
+
+class FeedWatchdog::Impl
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        Entry(JsonDataListenerPtr l, FeedEventHandler h)
+            : listener(std::move(l))
+            , handler(std::move(h))
+        { }
+
+        JsonDataListenerPtr listener;
+        FeedEventHandler handler;
+        Clock::time_point silent_since;
+        bool silent = false;
+    };
+
+public:
+    Impl(const std::chrono::milliseconds timeout, const std::chrono::milliseconds tick)
+        : m_timeout(timeout)
+        , m_tick(std::max(tick, std::chrono::milliseconds(1)))
+        // every deadline is at most timeout + tick ahead, so one revolution is enough
+        , m_slots(m_timeout / m_tick + 2)
+        , m_timer(m_io_context)
+    { }
+
+    ~Impl()
+    {
+        stop();
+    }
+
+    void add_listener(JsonDataListenerPtr listener, FeedEventHandler handler)
+    {
+        m_entries.emplace_back(std::move(listener), std::move(handler));
+    }
+
+    void start()
+    {
+        m_tick_time = Clock::now();
+        m_started = m_tick_time;
+        for (size_t idx = 0; idx < m_entries.size(); ++idx) {
+            schedule(idx, m_started + m_timeout);
+        }
+        arm();
+        m_thread = std::thread([this] { m_io_context.run(); });
+    }
+
+    void stop()
+    {
+        if (!m_io_context.stopped()) {
+            m_io_context.stop();
+        }
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+private:
+    void arm()
+    {
+        m_timer.expires_at(m_tick_time + m_tick);
+        m_timer.async_wait([this] (const auto ec) {
+            if (ec) {
+                return;
+            }
+            m_tick_time += m_tick;
+            m_cursor = (m_cursor + 1) % m_slots.size();
+            std::swap(m_due, m_slots[m_cursor]);
+            for (const auto idx : m_due) {
+                check(idx);
+            }
+            m_due.clear();
+            arm();
+        });
+    }
+
+    void schedule(const size_t idx, const Clock::time_point deadline)
+    {
+        const auto ahead = (deadline - m_tick_time + m_tick - Clock::duration(1)) / m_tick;
+        const auto ticks = std::clamp<Clock::rep>(ahead, 1, m_slots.size() - 1);
+        m_slots[(m_cursor + ticks) % m_slots.size()].push_back(idx);
+    }
+
+    void check(const size_t idx)
+    {
+        auto & e = m_entries[idx];
+        auto & metrics = e.listener->get_metrics();
+        const auto last = std::max(metrics.last_message_time(), m_started);
+        const auto now = Clock::now();
+
+        if (e.silent) {
+            if (last > e.silent_since) {
+                e.silent = false;
+                e.listener->set_silent(false);
+                raise(e, FeedEvent::Recovered);
+                schedule(idx, last + m_timeout);
+            } else {
+                schedule(idx, now + m_tick);
+            }
+        } else if (now - last >= m_timeout) {
+            e.silent = true;
+            e.silent_since = last;
+            e.listener->set_silent(true);
+            raise(e, FeedEvent::Stale);
+            schedule(idx, now + m_tick);
+        } else {
+            schedule(idx, last + m_timeout);
+        }
+    }
+
+    static void raise(const Entry & e, const FeedEvent event)
+    {
+        if (e.handler) {
+            e.handler(*e.listener, event);
+        }
+    }
+
+private:
+    const Clock::duration m_timeout;
+    const Clock::duration m_tick;
+    std::vector<std::vector<size_t>> m_slots;
+    std::vector<size_t> m_due;
+    size_t m_cursor = 0;
+    Clock::time_point m_tick_time;
+    Clock::time_point m_started;
+
+    std::vector<Entry> m_entries;
+
+    asio::io_context m_io_context;
+    asio::steady_timer m_timer;
+    std::thread m_thread;
+};
+
+FeedWatchdog::FeedWatchdog(const std::chrono::milliseconds timeout, const std::chrono::milliseconds tick)
+    : m_impl(std::make_unique<FeedWatchdog::Impl>(timeout, tick))
+{ }
+
+FeedWatchdog::~FeedWatchdog() = default;
+
+void FeedWatchdog::add_listener(JsonDataListenerPtr listener, FeedEventHandler handler)
+{
+    return m_impl->add_listener(std::move(listener), std::move(handler));
+}
+
+void FeedWatchdog::start()
+{
+    return m_impl->start();
+}
+
+void FeedWatchdog::stop()
+{
+    return m_impl->stop();
+}
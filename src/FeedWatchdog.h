@@ -0,0 +1,30 @@
+#pragma once
+
+#include "FeedEvent.h"
+#include "IJsonDataListener.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+// Marks listeners stale when no messages came for longer than timeout and
+// back when they resume. All listeners are checked from one thread by a
+// hashed timer wheel driven by a single timer, a tick only visits the
+// listeners whose deadline falls into it, so the cost does not grow with
+// the number of quiet or healthy feeds.
+class FeedWatchdog
+{
+    class Impl;
+public:
+    FeedWatchdog(std::chrono::milliseconds timeout, std::chrono::milliseconds tick = std::chrono::milliseconds(100));
+    ~FeedWatchdog();
+
+    // Must be called before start()
+    void add_listener(JsonDataListenerPtr listener, FeedEventHandler handler = {});
+
+    void start();
+    void stop();
+
+private:
+    std::unique_ptr<Impl> m_impl;
+};
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "Tsc.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Stream layer under websocket which, once woken up by a read, drains
+// everything the next layer has without blocking: decrypted TLS records
+// and bytes waiting in the socket. Websocket gets bytes up to the end of
+// the current frame only, so after a message is read nothing of the next
+// one hides in its buffer and message_ready() tells whether the next
+// message is complete here, to be read synchronously in the same wakeup.
+// The HTTP upgrade response is handed up to its end only, the same way.
+// The lowest layer is switched to non-blocking mode for draining.
+// Bytes of frames and the time of the last wakeup are kept for the
+// owner to account the work websocket does on them.
+template <class NextLayer>
+class FrameDrainingStream
+{
+    // TLS record size, what one read of the next layer gives at most
+    static constexpr std::size_t read_size = 16 * 1024;
+    // Bounds a drain under a flood, the rest waits for the next wakeup
+    static constexpr std::size_t max_drain_size = 1024 * 1024;
+
+public:
+    using next_layer_type = std::remove_reference_t<NextLayer>;
+    using lowest_layer_type = typename next_layer_type::lowest_layer_type;
+    using executor_type = typename next_layer_type::executor_type;
+
+    template <class... Args>
+    explicit FrameDrainingStream(Args &&... args)
+        : m_next(std::forward<Args>(args)...)
+    { }
+
+    executor_type get_executor() noexcept { return m_next.get_executor(); }
+
+    next_layer_type & next_layer() { return m_next; }
+    const next_layer_type & next_layer() const { return m_next; }
+    lowest_layer_type & lowest_layer() { return m_next.lowest_layer(); }
+    const lowest_layer_type & lowest_layer() const { return m_next.lowest_layer(); }
+
+    // Whether a whole data message is buffered and no control frame comes
+    // before it, reading it then takes no I/O. Valid between messages only.
+    bool message_ready() const
+    {
+        if (!m_upgraded || m_frame_left != 0) {
+            return false;
+        }
+        const auto data = m_input.cdata();
+        const auto * p = static_cast<const uint8_t *>(data.data());
+        std::size_t offset = 0;
+        for (;;) {
+            const auto size = frame_size(p + offset, data.size() - offset);
+            if (size == 0 || size > data.size() - offset || (p[offset] & 0x08) != 0) { // incomplete or control frame
+                return false;
+            }
+            if ((p[offset] & 0x80) != 0) { // fin
+                return true;
+            }
+            offset += size;
+        }
+    }
+
+    // Bytes of frames given to websocket since the previous call, compressed ones as they came
+    uint64_t take_frame_bytes() { return std::exchange(m_frame_bytes, 0); }
+
+    // When the last wakeup brought bytes, after they were drained
+    uint64_t last_fill_ticks() const { return m_last_fill; }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        ec = {};
+        while (available() == 0) {
+            if (m_error) {
+                ec = std::exchange(m_error, {});
+                return 0;
+            }
+            const auto size = m_next.read_some(m_input.prepare(read_size), ec);
+            if (ec) {
+                return 0;
+            }
+            m_input.commit(size);
+        }
+        return hand(buffers);
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers)
+    {
+        boost::system::error_code ec;
+        const auto ret = read_some(buffers, ec);
+        if (ec) {
+            throw boost::system::system_error(ec);
+        }
+        return ret;
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        return m_next.write_some(buffers, ec);
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers)
+    {
+        return m_next.write_some(buffers);
+    }
+
+    template <class MutableBufferSequence, class ReadToken>
+    auto async_read_some(const MutableBufferSequence & buffers, ReadToken && token)
+    {
+        enum class State { Start, Posted, Reading };
+        return boost::asio::async_compose<ReadToken, void(boost::system::error_code, std::size_t)>(
+            [this, buffers, state = State::Start] (auto & self, boost::system::error_code ec = {}, const std::size_t size = 0) mutable {
+                if (state == State::Reading) {
+                    if (ec) {
+                        return self.complete(ec, 0);
+                    }
+                    m_input.commit(size);
+                    drain();
+                    m_last_fill = tsc::now();
+                } else if (state == State::Start && (available() != 0 || m_error)) {
+                    // must not complete inside the initiating function
+                    state = State::Posted;
+                    return boost::asio::post(m_next.get_executor(), std::move(self));
+                }
+                if (available() != 0) {
+                    const auto n = hand(buffers);
+                    return self.complete({}, n);
+                }
+                if (m_error) {
+                    return self.complete(std::exchange(m_error, {}), 0);
+                }
+                state = State::Reading;
+                m_next.async_read_some(m_input.prepare(read_size), std::move(self));
+            }, token, m_next);
+    }
+
+    template <class ConstBufferSequence, class WriteToken>
+    auto async_write_some(const ConstBufferSequence & buffers, WriteToken && token)
+    {
+        return m_next.async_write_some(buffers, std::forward<WriteToken>(token));
+    }
+
+private:
+    // Header and payload size of a websocket frame, 0 if the header is not complete
+    static std::size_t frame_size(const uint8_t * p, const std::size_t size)
+    {
+        if (size < 2) {
+            return 0;
+        }
+        const std::size_t mask_size = (p[1] & 0x80) != 0 ? 4 : 0;
+        std::size_t header_size = 2;
+        uint64_t payload_size = p[1] & 0x7f;
+        if (payload_size == 126 || payload_size == 127) {
+            const std::size_t length_size = payload_size == 126 ? 2 : 8;
+            if (size < 2 + length_size) {
+                return 0;
+            }
+            payload_size = 0;
+            for (std::size_t i = 0; i < length_size; ++i) {
+                payload_size = payload_size << 8 | p[2 + i];
+            }
+            header_size += length_size;
+        }
+        header_size += mask_size;
+        return size < header_size ? 0 : header_size + payload_size;
+    }
+
+    // Size of the upgrade response with its empty line, 0 if it is not complete
+    std::size_t upgrade_response_size() const
+    {
+        const auto data = m_input.cdata();
+        const std::string_view input(static_cast<const char *>(data.data()), data.size());
+        const auto end = input.find("\r\n\r\n");
+        return end == std::string_view::npos ? 0 : end + 4;
+    }
+
+    // Buffered bytes of the current frame, none until its header is complete
+    std::size_t available()
+    {
+        if (m_frame_left == 0) {
+            const auto * p = static_cast<const uint8_t *>(m_input.cdata().data());
+            m_frame_left = m_upgraded ? frame_size(p, m_input.size()) : upgrade_response_size();
+        }
+        if (m_frame_left == 0 && !m_upgraded) {
+            // the response goes on, all but a possible start of its empty line
+            return m_input.size() > 3 ? m_input.size() - 3 : 0;
+        }
+        return std::min<std::size_t>(m_frame_left, m_input.size());
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t hand(const MutableBufferSequence & buffers)
+    {
+        const auto n = boost::asio::buffer_copy(buffers, m_input.cdata(), available());
+        m_input.consume(n);
+        if (m_upgraded) {
+            m_frame_bytes += n;
+        }
+        if (m_frame_left != 0) {
+            m_frame_left -= n;
+            m_upgraded = m_upgraded || m_frame_left == 0;
+        }
+        return n;
+    }
+
+    // Reads whatever the next layer has without waiting, an error other
+    // than would_block is reported after the bytes read before it
+    void drain()
+    {
+        boost::system::error_code ec;
+        if (!lowest_layer().non_blocking()) {
+            lowest_layer().non_blocking(true, ec);
+            if (ec) {
+                return;
+            }
+        }
+        while (m_input.size() < max_drain_size) {
+            const auto size = m_next.read_some(m_input.prepare(read_size), ec);
+            if (ec) {
+                if (ec != boost::asio::error::would_block) {
+                    m_error = ec;
+                }
+                return;
+            }
+            m_input.commit(size);
+        }
+    }
+
+private:
+    NextLayer m_next;
+    boost::beast::flat_buffer m_input;
+    uint64_t m_frame_left = 0; // bytes of the current frame not given to websocket yet
+    bool m_upgraded = false;   // the upgrade response is given, frames follow
+    uint64_t m_frame_bytes = 0;
+    uint64_t m_last_fill = 0;  // tsc ticks
+    boost::system::error_code m_error;
+};
+
+template <class NextLayer>
+void teardown(const boost::beast::role_type role, FrameDrainingStream<NextLayer> & stream, boost::system::error_code & ec)
+{
+    using boost::beast::websocket::teardown;
+    teardown(role, stream.next_layer(), ec);
+}
+
+template <class NextLayer, class TeardownHandler>
+void async_teardown(const boost::beast::role_type role, FrameDrainingStream<NextLayer> & stream, TeardownHandler && handler)
+{
+    using boost::beast::websocket::async_teardown;
+    async_teardown(role, stream.next_layer(), std::forward<TeardownHandler>(handler));
+}
@@ -2,6 +2,46 @@
 
 #include "IPAddress.h"
 
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+// Work of the websocket layer since the connector started
+struct TransportStatistics
+{
+    uint64_t messages = 0;
+    uint64_t payload_bytes = 0; // of messages as handed to the listener
+    uint64_t wire_bytes = 0;    // of websocket frames as received, deflated ones if compression is negotiated
+    std::chrono::nanoseconds decode_time{0}; // websocket framing, and inflating with compression
+    bool compressed = false;    // compression is negotiated for the current connection
+    bool kernel_tls = false;    // the kernel decrypts received records of the current connection
+
+    // Share of payload kept off the wire, negative if frames cost more than they carry
+    double saved() const { return payload_bytes ? 1.0 - static_cast<double>(wire_bytes) / payload_bytes : 0.0; }
+
+    std::chrono::duration<double, std::micro> decode_time_per_message() const
+    {
+        using Micros = std::chrono::duration<double, std::micro>;
+        return messages ? Micros(decode_time) / static_cast<double>(messages) : Micros(0);
+    }
+
+    std::ostream & print(std::ostream & strm) const
+    {
+        const auto flags = strm.flags();
+        const auto precision = strm.precision();
+        strm << std::fixed << std::setprecision(1)
+             << "wire " << wire_bytes / 1024.0 << " KB for " << payload_bytes / 1024.0 << " KB of messages ("
+             << 100 * saved() << "% saved), websocket " << decode_time_per_message().count() << "us/msg"
+             << (compressed ? ", deflate" : "") << (kernel_tls ? ", kTLS" : "");
+        strm.flags(flags);
+        strm.precision(precision);
+        return strm;
+    }
+
+    friend std::ostream & operator<< (std::ostream & strm, const TransportStatistics & s) { return s.print(strm); }
+};
+
 class IConnector {
 public:
     virtual ~IConnector() = default;
@@ -12,4 +52,9 @@ public:
     virtual bool is_running() const = 0;
 
     virtual IPAddress get_host() const = 0;
-};
\ No newline at end of file
+
+    // CPU time consumed by the connector's thread so far
+    virtual std::chrono::nanoseconds get_cpu_time() const = 0;
+
+    virtual TransportStatistics get_transport_statistics() const = 0;
+};
@@ -1,11 +1,15 @@
 #pragma once
 
-#include "OrderBook.h"
+#include "BookManager.h"
+#include "ListenerMetrics.h"
+#include "PipelineTrace.h"
+#include "WindowedStatistics.h"
 
 #include <chrono>
 #include <iomanip>
 #include <memory>
 #include <ostream>
+#include <span>
 #include <string_view>
 
 struct Statistics
@@ -58,17 +62,53 @@ class IJsonDataListener
 public:
     virtual ~IJsonDataListener() = default;
 
-    virtual bool process(std::string_view data) = 0;
+    // trace carries timestamps of the stages passed before the listener
+    virtual bool process(std::string_view data, PipelineTrace & trace) = 0;
+    // The connector gave up, nothing comes anymore
     virtual void failure(std::string_view reason) = 0;
+    // The session dropped and the connector retries, messages of the next one
+    // continue the statistics but not the update ids of the previous one
+    virtual void session_lost(std::string_view reason) = 0;
+
+    bool process(std::string_view data)
+    {
+        PipelineTrace trace;
+        return process(data, trace);
+    }
+
+    // Messages read in one wakeup of the connector, in order; trace covers
+    // reading all of them. Stops on the first one failed to process.
+    virtual bool process_batch(std::span<const std::string_view> batch, PipelineTrace & trace)
+    {
+        for (const auto data : batch) {
+            if (!process(data, trace)) {
+                return false;
+            }
+        }
+        return true;
+    }
 
     virtual Statistics get_statistics() const = 0;
+    // Statistics of the last window only, see WindowedStatistics for the supported length
+    virtual WindowSummary get_window_summary(std::chrono::seconds window) const = 0;
+    virtual PipelineStatistics get_pipeline_statistics() const = 0;
+
+    // Lock-free, safe to read from any thread
+    virtual const ListenerMetrics & get_metrics() const = 0;
+    // Called by FeedWatchdog from its thread when the feed goes silent and when it resumes
+    virtual void set_silent(bool silent) = 0;
 };
 
 class IDepthDataListener
     : public IJsonDataListener
 {
 public:
-    virtual OrderBook get_order_book() const = 0;
+    // Books of all symbols of the feed, the first symbol is the primary one
+    virtual const BookManager & get_books() const = 0;
+
+    // Copy of the best levels_num levels per side of the primary book only
+    OrderBook get_order_book(size_t levels_num = -1) const { return get_books().copy_top(0, levels_num); }
+    BookAnalytics get_analytics() const { return get_books().get_analytics(0); }
 };
 
 using JsonDataListenerPtr = std::shared_ptr<IJsonDataListener>;
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// How a connector waits for and takes received bytes
+enum class IoBackend
+{
+    Epoll,   // asio's reactor, a recv() per read
+    IoUring, // multishot receive into registered buffers, see UringStream
+};
+
+inline const char * to_string(const IoBackend b)
+{
+    switch (b) {
+    case IoBackend::Epoll: return "epoll";
+    case IoBackend::IoUring: return "io_uring";
+    }
+    return "unknown";
+}
+
+inline std::ostream & operator<< (std::ostream & strm, const IoBackend b) { return strm << to_string(b); }
+
+// Throws std::invalid_argument for an unknown name
+inline IoBackend parse_io_backend(const std::string_view name)
+{
+    for (const auto b : {IoBackend::Epoll, IoBackend::IoUring}) {
+        if (name == to_string(b)) {
+            return b;
+        }
+    }
+    throw std::invalid_argument("unknown io backend: " + std::string(name));
+}
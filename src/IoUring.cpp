@@ -0,0 +1,323 @@
+#include "IoUring.h"
+
+#include <boost/asio/error.hpp>
+
+#include <system_error>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace uring {
+
+#ifdef __linux__
+
+namespace {
+
+constexpr uint64_t receive_tag = 1;
+
+int setup(const unsigned entries, io_uring_params & params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int enter(const int fd, const unsigned to_submit)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, 0, 0, nullptr, 0));
+}
+
+int register_ring(const int fd, const unsigned opcode, void * arg, const unsigned args_num)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, args_num));
+}
+
+[[noreturn]] void throw_errno(const char * what, const int error = errno)
+{
+    throw std::system_error(error, std::system_category(), what);
+}
+
+void * map_ring(const int fd, const std::size_t size, const off_t offset)
+{
+    auto * ret = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (ret == MAP_FAILED) {
+        throw_errno("io_uring mmap");
+    }
+    return ret;
+}
+
+void * map_memory(const std::size_t size)
+{
+    auto * ret = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (ret == MAP_FAILED) {
+        throw_errno("mmap");
+    }
+    return ret;
+}
+
+void unmap(void * address, const std::size_t size)
+{
+    if (address != nullptr) {
+        ::munmap(address, size);
+    }
+}
+
+// Fields of the rings are shared with the kernel
+template <class T>
+T load_acquire(T * p) { return std::atomic_ref<T>(*p).load(std::memory_order_acquire); }
+
+template <class T>
+void store_release(T * p, const T value) { std::atomic_ref<T>(*p).store(value, std::memory_order_release); }
+
+template <class T>
+T * at(void * base, const std::size_t offset) { return reinterpret_cast<T *>(static_cast<uint8_t *>(base) + offset); }
+
+}
+
+Receiver::Receiver(const unsigned buffers_num, const std::size_t buffer_size)
+    : m_buffers_num(buffers_num)
+    , m_buffer_size(buffer_size)
+{
+    // the buffer ring is indexed by a mask
+    if (buffers_num == 0 || (buffers_num & (buffers_num - 1)) != 0 || buffers_num > 32768) {
+        throw std::system_error(EINVAL, std::system_category(), "number of io_uring buffers must be a power of 2");
+    }
+    try {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = 2 * buffers_num;
+        m_ring_fd = setup(1, params);
+        if (m_ring_fd < 0) {
+            throw_errno("io_uring_setup");
+        }
+
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+            m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+        m_sq_ring = map_ring(m_ring_fd, m_sq_ring_size, IORING_OFF_SQ_RING);
+        m_cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) != 0 ? m_sq_ring : map_ring(m_ring_fd, m_cq_ring_size, IORING_OFF_CQ_RING);
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = map_ring(m_ring_fd, m_sqes_size, IORING_OFF_SQES);
+
+        m_sq_tail = at<unsigned>(m_sq_ring, params.sq_off.tail);
+        m_sq_mask = at<unsigned>(m_sq_ring, params.sq_off.ring_mask);
+        m_sq_array = at<unsigned>(m_sq_ring, params.sq_off.array);
+        m_cq_head = at<unsigned>(m_cq_ring, params.cq_off.head);
+        m_cq_tail = at<unsigned>(m_cq_ring, params.cq_off.tail);
+        m_cq_mask = at<unsigned>(m_cq_ring, params.cq_off.ring_mask);
+        m_cqes = at<void>(m_cq_ring, params.cq_off.cqes);
+
+        // the kernel picks a free buffer of the group for every receive
+        m_buffer_ring_size = buffers_num * sizeof(io_uring_buf);
+        m_buffer_ring = map_memory(m_buffer_ring_size);
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(m_buffer_ring);
+        reg.ring_entries = buffers_num;
+        reg.bgid = m_buffer_group;
+        if (register_ring(m_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            throw_errno("IORING_REGISTER_PBUF_RING");
+        }
+        m_buffers_size = buffers_num * buffer_size;
+        m_buffers = static_cast<uint8_t *>(map_memory(m_buffers_size));
+        for (unsigned i = 0; i < buffers_num; ++i) {
+            recycle(static_cast<uint16_t>(i));
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+Receiver::~Receiver()
+{
+    release();
+}
+
+void Receiver::release()
+{
+    if (m_armed) {
+        // the kernel must be done with the buffers before they are unmapped
+        io_uring_sync_cancel_reg reg{};
+        reg.addr = receive_tag;
+        reg.timeout.tv_sec = -1;
+        reg.timeout.tv_nsec = -1;
+        register_ring(m_ring_fd, IORING_REGISTER_SYNC_CANCEL, &reg, 1);
+        m_armed = false;
+    }
+    if (m_cq_ring != m_sq_ring) {
+        unmap(m_cq_ring, m_cq_ring_size);
+    }
+    unmap(m_sq_ring, m_sq_ring_size);
+    unmap(m_sqes, m_sqes_size);
+    m_sq_ring = m_cq_ring = m_sqes = nullptr;
+    if (m_ring_fd >= 0) {
+        ::close(m_ring_fd);
+        m_ring_fd = -1;
+    }
+    unmap(m_buffer_ring, m_buffer_ring_size);
+    unmap(m_buffers, m_buffers_size);
+    m_buffer_ring = nullptr;
+    m_buffers = nullptr;
+}
+
+void Receiver::start(const int socket_fd, boost::system::error_code & ec)
+{
+    m_socket_fd = socket_fd;
+    submit_receive(ec);
+}
+
+bool Receiver::submit_receive(boost::system::error_code & ec)
+{
+    const auto tail = *m_sq_tail;
+    const auto index = tail & *m_sq_mask;
+    auto & sqe = static_cast<io_uring_sqe *>(m_sqes)[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = m_socket_fd;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = m_buffer_group;
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.user_data = receive_tag;
+    m_sq_array[index] = index;
+    store_release(m_sq_tail, tail + 1);
+    if (enter(m_ring_fd, 1) < 0) {
+        ec = boost::system::error_code(errno, boost::asio::error::get_system_category());
+        return false;
+    }
+    m_armed = true;
+    return true;
+}
+
+void Receiver::recycle(const uint16_t buffer_id)
+{
+    // the ring is an array of entries with the tail over resv of the first
+    // one; io_uring_buf_ring says so with a flexible array member, which C++
+    // does not lay out at offset 0, so it is not used
+    auto * ring = static_cast<io_uring_buf *>(m_buffer_ring);
+    auto & buf = ring[m_buffer_tail & (m_buffers_num - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(m_buffers + buffer_id * m_buffer_size);
+    buf.len = static_cast<uint32_t>(m_buffer_size);
+    buf.bid = buffer_id;
+    store_release(&ring[0].resv, ++m_buffer_tail);
+}
+
+bool Receiver::ready() const
+{
+    return m_left != 0 || m_error || *m_cq_head != load_acquire(m_cq_tail);
+}
+
+bool Receiver::next_buffer(boost::system::error_code & ec)
+{
+    for (;;) {
+        if (m_error) {
+            ec = m_error;
+            return false;
+        }
+        const auto head = *m_cq_head;
+        if (head == load_acquire(m_cq_tail)) {
+            // it stops when buffers run out, they are all back once everything is taken
+            if (!m_armed && !submit_receive(ec)) {
+                return false;
+            }
+            ec = boost::asio::error::would_block;
+            return false;
+        }
+        const auto cqe = static_cast<const io_uring_cqe *>(m_cqes)[head & *m_cq_mask];
+        store_release(m_cq_head, head + 1);
+        if (cqe.user_data != receive_tag) {
+            continue;
+        }
+        if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+            m_armed = false;
+        }
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+            m_current = static_cast<int>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            m_offset = 0;
+            m_left = static_cast<std::size_t>(cqe.res);
+            return true;
+        }
+        if (cqe.res == 0) {
+            m_error = boost::asio::error::eof;
+        } else if (cqe.res != -ENOBUFS) {
+            m_error = boost::system::error_code(-cqe.res, boost::asio::error::get_system_category());
+        }
+    }
+}
+
+std::size_t Receiver::receive(void * data, const std::size_t size, boost::system::error_code & ec)
+{
+    auto * out = static_cast<uint8_t *>(data);
+    std::size_t ret = 0;
+    while (ret < size) {
+        if (m_left == 0 && !next_buffer(ec)) {
+            break;
+        }
+        const auto n = std::min(m_left, size - ret);
+        std::memcpy(out + ret, m_buffers + m_current * m_buffer_size + m_offset, n);
+        ret += n;
+        m_offset += n;
+        m_left -= n;
+        if (m_left == 0) {
+            recycle(static_cast<uint16_t>(m_current));
+            m_current = -1;
+        }
+    }
+    if (ret != 0) {
+        ec = {};
+    }
+    return ret;
+}
+
+#else
+
+Receiver::Receiver(unsigned, std::size_t)
+{
+    throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring is supported on Linux only");
+}
+
+Receiver::~Receiver() = default;
+
+void Receiver::release() { }
+
+void Receiver::start(int, boost::system::error_code & ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+}
+
+bool Receiver::submit_receive(boost::system::error_code & ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+    return false;
+}
+
+bool Receiver::next_buffer(boost::system::error_code & ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+    return false;
+}
+
+void Receiver::recycle(uint16_t) { }
+
+bool Receiver::ready() const
+{
+    return false;
+}
+
+std::size_t Receiver::receive(void *, std::size_t, boost::system::error_code & ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+    return 0;
+}
+
+#endif
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <boost/system/error_code.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Native io_uring receive path of a socket, without liburing. One multishot
+// receive stays armed on the socket and the kernel fills buffers of a ring
+// registered up front, completions are read from shared memory: taking
+// received bytes costs no system call, waiting for them is a poll of the
+// ring fd. Linux 6.0 or later, sending stays with the socket.
+namespace uring {
+
+class Receiver
+{
+public:
+    // Throws std::system_error if io_uring is not available, e.g. on an
+    // older kernel, with kernel.io_uring_disabled or under seccomp
+    Receiver(unsigned buffers_num, std::size_t buffer_size);
+    ~Receiver();
+
+    Receiver(const Receiver &) = delete;
+    Receiver & operator= (const Receiver &) = delete;
+
+    // To poll for readable, it is when completions are there
+    int fd() const { return m_ring_fd; }
+
+    // Arms the multishot receive of a connected socket, once
+    void start(int socket_fd, boost::system::error_code & ec);
+    bool is_started() const { return m_socket_fd >= 0; }
+
+    // Whether receive() has something to give without waiting: bytes or an error
+    bool ready() const;
+
+    // Copies received bytes without blocking, would_block if there are none;
+    // eof once the peer has closed and everything before it is taken
+    std::size_t receive(void * data, std::size_t size, boost::system::error_code & ec);
+
+private:
+    void release();
+    bool submit_receive(boost::system::error_code & ec);
+    // Takes the next buffer the kernel has filled, false with why if there is none
+    bool next_buffer(boost::system::error_code & ec);
+    void recycle(uint16_t buffer_id);
+
+private:
+    int m_ring_fd = -1;
+    int m_socket_fd = -1;
+    uint16_t m_buffer_group = 0;
+
+    // submission queue, one entry is enough for the single receive
+    void * m_sq_ring = nullptr;
+    std::size_t m_sq_ring_size = 0;
+    void * m_sqes = nullptr;
+    std::size_t m_sqes_size = 0;
+    unsigned * m_sq_tail = nullptr;
+    unsigned * m_sq_mask = nullptr;
+    unsigned * m_sq_array = nullptr;
+
+    // completion queue, sized so that it can hold a completion of every buffer
+    void * m_cq_ring = nullptr;
+    std::size_t m_cq_ring_size = 0;
+    unsigned * m_cq_head = nullptr;
+    unsigned * m_cq_tail = nullptr;
+    unsigned * m_cq_mask = nullptr;
+    void * m_cqes = nullptr;
+
+    // provided buffers and their ring, owned by us and read by the kernel
+    void * m_buffer_ring = nullptr;
+    std::size_t m_buffer_ring_size = 0;
+    uint8_t * m_buffers = nullptr;
+    std::size_t m_buffers_size = 0;
+    unsigned m_buffers_num = 0;
+    std::size_t m_buffer_size = 0;
+    uint16_t m_buffer_tail = 0;
+
+    bool m_armed = false;      // the multishot receive goes on
+    int m_current = -1;        // buffer being taken, -1 if none
+    std::size_t m_offset = 0;  // of what is left in the current buffer
+    std::size_t m_left = 0;
+    boost::system::error_code m_error; // eof or a failure, given after the bytes before it
+};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "IPAddress.h"
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Address families of endpoints to measure
+enum class IpFamily
+{
+    Any, // both, v4 and v6 paths to the same edge side by side
+    V4,
+    V6,
+};
+
+inline const char * to_string(const IpFamily f)
+{
+    switch (f) {
+    case IpFamily::Any: return "any";
+    case IpFamily::V4: return "v4";
+    case IpFamily::V6: return "v6";
+    }
+    return "unknown";
+}
+
+inline std::ostream & operator<< (std::ostream & strm, const IpFamily f) { return strm << to_string(f); }
+
+// Throws std::invalid_argument for an unknown name
+inline IpFamily parse_ip_family(const std::string_view name)
+{
+    for (const auto f : {IpFamily::Any, IpFamily::V4, IpFamily::V6}) {
+        if (name == to_string(f)) {
+            return f;
+        }
+    }
+    throw std::invalid_argument("unknown address family: " + std::string(name));
+}
+
+// Only textual IPv6 addresses have colons
+inline IpFamily family_of(const IPAddress & ip)
+{
+    return ip.find(':') == IPAddress::npos ? IpFamily::V4 : IpFamily::V6;
+}
+
+inline bool matches(const IpFamily filter, const IPAddress & ip)
+{
+    return filter == IpFamily::Any || filter == family_of(ip);
+}
@@ -0,0 +1,270 @@
+#include "KernelTls.h"
+
+#include <boost/asio/error.hpp>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+
+#ifdef __linux__
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace ktls {
+
+namespace {
+
+constexpr uint8_t record_alert = 21;
+constexpr uint8_t record_handshake = 22;
+constexpr uint8_t record_application_data = 23;
+constexpr uint8_t handshake_key_update = 24;
+
+void free_secret(void *, void * ptr, CRYPTO_EX_DATA *, int, long, void *)
+{
+    if (auto * secret = static_cast<std::string *>(ptr)) {
+        OPENSSL_cleanse(secret->data(), secret->size());
+        delete secret;
+    }
+}
+
+int secret_index()
+{
+    static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, free_secret);
+    return index;
+}
+
+int from_hex(const char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Lines are in the NSS key log format: <label> <client random> <secret>, hex encoded
+void keylog(const SSL * ssl, const char * line)
+{
+    constexpr std::string_view label = "SERVER_TRAFFIC_SECRET_0 ";
+    const std::string_view l(line);
+    if (l.substr(0, label.size()) != label) {
+        return;
+    }
+    const auto hex = l.substr(l.rfind(' ') + 1);
+    auto secret = std::make_unique<std::string>(hex.size() / 2, '\0');
+    for (std::size_t i = 0; i < secret->size(); ++i) {
+        const auto high = from_hex(hex[2 * i]);
+        const auto low = from_hex(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return;
+        }
+        (*secret)[i] = static_cast<char>(high << 4 | low);
+    }
+    auto * s = const_cast<SSL *>(ssl);
+    free_secret(nullptr, SSL_get_ex_data(s, secret_index()), nullptr, 0, 0, nullptr);
+    SSL_set_ex_data(s, secret_index(), secret.release());
+}
+
+// HKDF-Expand-Label of RFC 8446 with an empty context
+std::vector<uint8_t> expand_label(const EVP_MD * md, const std::string & secret, const std::string_view label, const std::size_t length)
+{
+    std::vector<uint8_t> info;
+    const std::string full_label = "tls13 " + std::string(label);
+    info.push_back(static_cast<uint8_t>(length >> 8));
+    info.push_back(static_cast<uint8_t>(length));
+    info.push_back(static_cast<uint8_t>(full_label.size()));
+    info.insert(info.end(), full_label.begin(), full_label.end());
+    info.push_back(0);
+
+    std::vector<uint8_t> out(length);
+    std::size_t out_length = length;
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr), EVP_PKEY_CTX_free);
+    if (!ctx
+            || EVP_PKEY_derive_init(ctx.get()) <= 0
+            || EVP_PKEY_CTX_hkdf_mode(ctx.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) <= 0
+            || EVP_PKEY_CTX_set_hkdf_md(ctx.get(), md) <= 0
+            || EVP_PKEY_CTX_set1_hkdf_key(ctx.get(), reinterpret_cast<const unsigned char *>(secret.data()), secret.size()) <= 0
+            || EVP_PKEY_CTX_add1_hkdf_info(ctx.get(), info.data(), info.size()) <= 0
+            || EVP_PKEY_derive(ctx.get(), out.data(), &out_length) <= 0
+            || out_length != length) {
+        return {};
+    }
+    return out;
+}
+
+std::string wipe_secret(SSL * ssl, std::string reason)
+{
+    free_secret(nullptr, SSL_get_ex_data(ssl, secret_index()), nullptr, 0, 0, nullptr);
+    SSL_set_ex_data(ssl, secret_index(), nullptr);
+    return reason;
+}
+
+}
+
+void capture_secrets(SSL_CTX * ctx)
+{
+    SSL_CTX_set_keylog_callback(ctx, keylog);
+}
+
+bool server_keys(const SSL * ssl, TrafficKeys & keys)
+{
+    const auto * secret = static_cast<const std::string *>(SSL_get_ex_data(ssl, secret_index()));
+    const auto * cipher = SSL_get_current_cipher(ssl);
+    if (secret == nullptr || cipher == nullptr) {
+        return false;
+    }
+    keys.cipher_suite = SSL_CIPHER_get_protocol_id(cipher);
+    std::size_t key_size = 0;
+    switch (keys.cipher_suite) {
+    case 0x1301: key_size = 16; break; // TLS_AES_128_GCM_SHA256
+    case 0x1302: key_size = 32; break; // TLS_AES_256_GCM_SHA384
+    case 0x1303: key_size = 32; break; // TLS_CHACHA20_POLY1305_SHA256
+    default: return false;
+    }
+    const auto * md = SSL_CIPHER_get_handshake_digest(cipher);
+    keys.key = expand_label(md, *secret, "key", key_size);
+    const auto iv = expand_label(md, *secret, "iv", keys.iv.size());
+    if (keys.key.empty() || iv.empty()) {
+        return false;
+    }
+    std::copy(iv.begin(), iv.end(), keys.iv.begin());
+    return true;
+}
+
+#ifdef __linux__
+
+namespace {
+
+// rec_seq stays zero, no record was received with the key yet
+template <class CryptoInfo>
+std::string set_rx(const int fd, CryptoInfo & info, const TrafficKeys & keys, const uint16_t cipher_type)
+{
+    info.info.version = TLS_1_3_VERSION;
+    info.info.cipher_type = cipher_type;
+    std::memcpy(info.key, keys.key.data(), sizeof(info.key));
+    if constexpr (sizeof(info.iv) == 12) {
+        std::memcpy(info.iv, keys.iv.data(), sizeof(info.iv));
+    } else {
+        // the nonce is salt followed by iv
+        std::memcpy(info.salt, keys.iv.data(), sizeof(info.salt));
+        std::memcpy(info.iv, keys.iv.data() + sizeof(info.salt), sizeof(info.iv));
+    }
+    const auto ret = setsockopt(fd, SOL_TLS, TLS_RX, &info, sizeof(info));
+    const auto error = errno;
+    OPENSSL_cleanse(&info, sizeof(info));
+    return ret == 0 ? std::string() : std::string("TLS_RX: ") + std::strerror(error);
+}
+
+}
+
+std::string enable_rx(SSL * ssl, const int fd)
+{
+    if (SSL_version(ssl) != TLS1_3_VERSION) {
+        return wipe_secret(ssl, "not a TLS 1.3 connection");
+    }
+    if (SSL_pending(ssl) > 0 || BIO_ctrl_pending(SSL_get_rbio(ssl)) > 0) {
+        return wipe_secret(ssl, "OpenSSL has received records already");
+    }
+    TrafficKeys keys;
+    if (!server_keys(ssl, keys)) {
+        return wipe_secret(ssl, "no traffic secret captured or cipher suite is not supported");
+    }
+    wipe_secret(ssl, {});
+    std::string reason;
+    if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+        reason = std::string("TCP_ULP: ") + std::strerror(errno);
+    } else if (keys.cipher_suite == 0x1301) {
+        tls12_crypto_info_aes_gcm_128 info{};
+        reason = set_rx(fd, info, keys, TLS_CIPHER_AES_GCM_128);
+    } else if (keys.cipher_suite == 0x1302) {
+        tls12_crypto_info_aes_gcm_256 info{};
+        reason = set_rx(fd, info, keys, TLS_CIPHER_AES_GCM_256);
+    } else {
+        tls12_crypto_info_chacha20_poly1305 info{};
+        reason = set_rx(fd, info, keys, TLS_CIPHER_CHACHA20_POLY1305);
+    }
+    OPENSSL_cleanse(keys.key.data(), keys.key.size());
+    OPENSSL_cleanse(keys.iv.data(), keys.iv.size());
+    return reason;
+}
+
+std::size_t receive(const int fd, void * data, const std::size_t size, boost::system::error_code & ec)
+{
+    for (;;) {
+        char control[CMSG_SPACE(sizeof(uint8_t))];
+        iovec iov{data, size};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        const auto ret = ::recvmsg(fd, &msg, MSG_DONTWAIT);
+        if (ret < 0) {
+            ec = boost::system::error_code(errno, boost::asio::error::get_system_category());
+            return 0;
+        }
+        if (ret == 0) {
+            ec = boost::asio::error::eof;
+            return 0;
+        }
+        const auto * cmsg = CMSG_FIRSTHDR(&msg);
+        const auto type = cmsg && cmsg->cmsg_level == SOL_TLS && cmsg->cmsg_type == TLS_GET_RECORD_TYPE
+                ? *reinterpret_cast<const uint8_t *>(CMSG_DATA(cmsg)) : record_application_data;
+        const auto * p = static_cast<const uint8_t *>(data);
+        switch (type) {
+        case record_application_data:
+            ec = {};
+            return ret;
+        case record_handshake:
+            // messages of a record: type, 3 bytes of length, body
+            for (std::size_t offset = 0; offset + 4 <= static_cast<std::size_t>(ret); offset += 4 + (p[offset + 1] << 16 | p[offset + 2] << 8 | p[offset + 3])) {
+                if (p[offset] == handshake_key_update) {
+                    ec = boost::asio::error::operation_not_supported;
+                    return 0;
+                }
+            }
+            break;
+        case record_alert:
+            // level, description; 0 is close_notify
+            if (ret >= 2 && p[1] == 0) {
+                ec = boost::asio::error::eof;
+            } else {
+                ec = boost::asio::error::connection_aborted;
+            }
+            return 0;
+        default:
+            ec = boost::asio::error::connection_aborted;
+            return 0;
+        }
+    }
+}
+
+#else
+
+std::string enable_rx(SSL * ssl, int)
+{
+    return wipe_secret(ssl, "kernel TLS is supported on Linux only");
+}
+
+std::size_t receive(int, void *, std::size_t, boost::system::error_code & ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+    return 0;
+}
+
+#endif
+
+}
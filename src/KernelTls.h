@@ -0,0 +1,48 @@
+#pragma once
+
+#include <boost/system/error_code.hpp>
+
+#include <openssl/ssl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Kernel TLS (Linux kTLS) receive offload of TLS 1.3 connections. OpenSSL
+// does the handshake, then the kernel gets the key of the server to client
+// direction and decrypts records itself: reads of the socket give plain
+// text and the feed thread does no AES work. Sending stays with OpenSSL.
+namespace ktls {
+
+// Keys of one direction of a TLS 1.3 connection
+struct TrafficKeys
+{
+    uint16_t cipher_suite = 0; // e.g. 0x1301 for TLS_AES_128_GCM_SHA256
+    std::vector<uint8_t> key;
+    std::array<uint8_t, 12> iv{};
+};
+
+// Keeps the server traffic secret of connections from ctx when their
+// handshake is done, must be called before handshakes
+void capture_secrets(SSL_CTX * ctx);
+
+// Keys of what the server sends derived from the captured secret, false if
+// there is none or the cipher suite is not supported by the kernel
+bool server_keys(const SSL * ssl, TrafficKeys & keys);
+
+// Moves decryption of records received on fd of the connection of ssl into
+// the kernel, right after the handshake: the server sends nothing until it
+// gets our Finished, so OpenSSL has decrypted no record with the key yet.
+// Returns why it is not possible, then nothing changes and OpenSSL goes on
+// reading; an empty string on success, reads must go through receive() then.
+// The captured secret is wiped either way.
+std::string enable_rx(SSL * ssl, int fd);
+
+// Plain text of received application data without blocking, would_block if
+// there is none. Session tickets are skipped, a key update the kernel can
+// not follow fails the read, close_notify gives eof.
+std::size_t receive(int fd, void * data, std::size_t size, boost::system::error_code & ec);
+
+}
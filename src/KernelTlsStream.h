@@ -0,0 +1,149 @@
+#pragma once
+
+#include "KernelTls.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core/bind_handler.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+
+#include <type_traits>
+#include <utility>
+
+// Layer over an asio::ssl::stream which, once ktls::enable_rx() took over
+// decryption, reads plain text straight from the socket. Writes always go
+// through OpenSSL.
+template <class NextLayer>
+class KernelTlsStream
+{
+public:
+    using next_layer_type = std::remove_reference_t<NextLayer>;
+    using lowest_layer_type = typename next_layer_type::lowest_layer_type;
+    using executor_type = typename next_layer_type::executor_type;
+
+    template <class... Args>
+    explicit KernelTlsStream(Args &&... args)
+        : m_next(std::forward<Args>(args)...)
+    { }
+
+    executor_type get_executor() noexcept { return m_next.get_executor(); }
+
+    next_layer_type & next_layer() { return m_next; }
+    const next_layer_type & next_layer() const { return m_next; }
+    lowest_layer_type & lowest_layer() { return m_next.lowest_layer(); }
+    const lowest_layer_type & lowest_layer() const { return m_next.lowest_layer(); }
+
+    // Reads skip OpenSSL from now on, after ktls::enable_rx() succeeded
+    void set_kernel_rx() { m_kernel_rx = true; }
+    bool is_kernel_rx() const { return m_kernel_rx; }
+
+    // Blocks unless the socket is in non-blocking mode, as asio sockets do
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        if (!m_kernel_rx) {
+            return m_next.read_some(buffers, ec);
+        }
+        for (;;) {
+            const auto ret = receive(buffers, ec);
+            if (ec != boost::asio::error::would_block || lowest_layer().non_blocking()) {
+                return ret;
+            }
+            lowest_layer().wait(boost::asio::socket_base::wait_read, ec);
+            if (ec) {
+                return 0;
+            }
+        }
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers)
+    {
+        boost::system::error_code ec;
+        const auto ret = read_some(buffers, ec);
+        if (ec) {
+            throw boost::system::system_error(ec);
+        }
+        return ret;
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        return m_next.write_some(buffers, ec);
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers)
+    {
+        return m_next.write_some(buffers);
+    }
+
+    template <class MutableBufferSequence, class ReadToken>
+    auto async_read_some(const MutableBufferSequence & buffers, ReadToken && token)
+    {
+        return boost::asio::async_initiate<ReadToken, void(boost::system::error_code, std::size_t)>(
+            [this] (auto handler, const MutableBufferSequence & buffers) {
+                if (!m_kernel_rx) {
+                    m_next.async_read_some(buffers, std::move(handler));
+                    return;
+                }
+                // waits for the socket first, so it never completes inside the initiating function
+                boost::asio::async_compose<decltype(handler), void(boost::system::error_code, std::size_t)>(
+                    [this, buffers, waited = false] (auto & self, boost::system::error_code ec = {}) mutable {
+                        if (waited && !ec) {
+                            const auto ret = receive(buffers, ec);
+                            if (ec != boost::asio::error::would_block) {
+                                return self.complete(ec, ret);
+                            }
+                        } else if (ec) {
+                            return self.complete(ec, 0);
+                        }
+                        waited = true;
+                        lowest_layer().async_wait(boost::asio::socket_base::wait_read, std::move(self));
+                    }, handler, lowest_layer());
+            }, token, buffers);
+    }
+
+    template <class ConstBufferSequence, class WriteToken>
+    auto async_write_some(const ConstBufferSequence & buffers, WriteToken && token)
+    {
+        return m_next.async_write_some(buffers, std::forward<WriteToken>(token));
+    }
+
+private:
+    template <class MutableBufferSequence>
+    std::size_t receive(const MutableBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        const boost::asio::mutable_buffer buffer = *boost::asio::buffer_sequence_begin(buffers);
+        return ktls::receive(lowest_layer().native_handle(), buffer.data(), buffer.size(), ec);
+    }
+
+private:
+    NextLayer m_next;
+    bool m_kernel_rx = false;
+};
+
+// OpenSSL can not read the peer's close_notify with kernel TLS, the socket is just shut down then
+template <class NextLayer>
+void teardown(const boost::beast::role_type role, KernelTlsStream<NextLayer> & stream, boost::system::error_code & ec)
+{
+    if (stream.is_kernel_rx()) {
+        stream.lowest_layer().shutdown(boost::asio::socket_base::shutdown_both, ec);
+        return;
+    }
+    using boost::beast::websocket::teardown;
+    teardown(role, stream.next_layer(), ec);
+}
+
+template <class NextLayer, class TeardownHandler>
+void async_teardown(const boost::beast::role_type role, KernelTlsStream<NextLayer> & stream, TeardownHandler && handler)
+{
+    if (stream.is_kernel_rx()) {
+        boost::system::error_code ec;
+        stream.lowest_layer().shutdown(boost::asio::socket_base::shutdown_both, ec);
+        boost::asio::post(stream.get_executor(), boost::beast::bind_front_handler(std::forward<TeardownHandler>(handler), ec));
+        return;
+    }
+    using boost::beast::websocket::async_teardown;
+    async_teardown(role, stream.next_layer(), std::forward<TeardownHandler>(handler));
+}
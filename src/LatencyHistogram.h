@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// Log-linear histogram: every power of two is split into 8 linear
+// sub-buckets, i.e. ~12% relative error, fixed size and no allocations,
+// so it can be updated on the hot path and copied as a snapshot.
+class LatencyHistogram
+{
+public:
+    static constexpr uint64_t sub_bucket_bits = 3;
+    static constexpr uint64_t sub_buckets = 1 << sub_bucket_bits;
+    static constexpr uint64_t max_msb = 39; // larger values are clamped to the last bucket
+    static constexpr size_t buckets_num = (max_msb - sub_bucket_bits + 2) * sub_buckets;
+
+    static size_t bucket_index(const uint64_t v)
+    {
+        if (v < sub_buckets) {
+            return v;
+        }
+        const uint64_t msb = 63 - __builtin_clzll(v);
+        if (msb > max_msb) {
+            return buckets_num - 1;
+        }
+        const auto shift = msb - sub_bucket_bits;
+        return (shift + 1) * sub_buckets + ((v >> shift) & (sub_buckets - 1));
+    }
+
+    static uint64_t bucket_upper_bound(const size_t idx)
+    {
+        if (idx < sub_buckets) {
+            return idx;
+        }
+        const auto shift = idx / sub_buckets - 1;
+        const auto lower = (sub_buckets + idx % sub_buckets) << shift;
+        return lower + (uint64_t(1) << shift) - 1;
+    }
+
+    void add(const uint64_t v)
+    {
+        ++m_buckets[bucket_index(v)];
+        ++m_count;
+        m_sum += v;
+        m_min = std::min(m_min, v);
+        m_max = std::max(m_max, v);
+    }
+
+    void merge(const LatencyHistogram & other)
+    {
+        for (size_t i = 0; i < buckets_num; ++i) {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    void clear()
+    {
+        *this = LatencyHistogram();
+    }
+
+    // p in [0, 1], returns upper bound of the bucket holding the percentile
+    uint64_t percentile(const double p) const
+    {
+        if (m_count == 0) {
+            return 0;
+        }
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * m_count + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_num; ++i) {
+            seen += m_buckets[i];
+            if (seen >= rank) {
+                return std::clamp(bucket_upper_bound(i), m_min, m_max);
+            }
+        }
+        return m_max;
+    }
+
+    uint64_t count() const { return m_count; }
+    uint64_t sum() const { return m_sum; }
+    uint64_t min() const { return m_count ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    uint64_t avg() const { return m_count ? m_sum / m_count : 0; }
+    bool empty() const { return m_count == 0; }
+
+    const auto & get_buckets() const { return m_buckets; }
+
+private:
+    std::array<uint64_t, buckets_num> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    uint64_t m_max = 0;
+};
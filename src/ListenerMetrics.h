@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Counters exported for monitoring. Written by the feed thread only, so
+// updates are plain relaxed load+store, and readers take snapshots without
+// any lock. A snapshot is not atomic as a whole, which is fine for scrapes.
+// The only exception is the silent flag, which is stored by FeedWatchdog.
+class ListenerMetrics
+{
+public:
+    // Upper bounds of latency buckets in microseconds, the last bucket is +Inf
+    static constexpr std::array<uint64_t, 14> latency_bounds_us{
+        50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000};
+
+    struct Snapshot
+    {
+        std::array<uint64_t, latency_bounds_us.size() + 1> latency_buckets{};
+        uint64_t latency_sum_us = 0;
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+        uint64_t failures = 0;
+        uint64_t sessions_lost = 0;
+        uint64_t gaps = 0;
+        uint64_t bids = 0;
+        uint64_t asks = 0;
+        uint64_t book_reallocations = 0;
+        uint64_t max_book_update_ticks = 0; // tsc ticks
+        bool stale = false;
+        bool silent = false;
+    };
+
+    void on_message(const size_t bytes, const std::chrono::microseconds latency)
+    {
+        const auto us = static_cast<uint64_t>(latency.count());
+        size_t idx = 0;
+        while (idx < latency_bounds_us.size() && us > latency_bounds_us[idx]) {
+            ++idx;
+        }
+        increment(m_latency_buckets[idx]);
+        increment(m_latency_sum_us, us);
+        on_message(bytes);
+    }
+
+    // Message without event time, e.g. of spot bookTicker, counts for everything but latency
+    void on_message(const size_t bytes)
+    {
+        increment(m_messages);
+        increment(m_bytes, bytes);
+        m_last_message_time.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void on_gap()
+    {
+        increment(m_gaps);
+        set_stale(true);
+    }
+
+    void on_failure()
+    {
+        increment(m_failures);
+        set_stale(true);
+    }
+
+    // The connector retries, the book of the next session starts clean
+    void on_session_lost()
+    {
+        increment(m_sessions_lost);
+        set_stale(false);
+    }
+
+    void set_book_depth(const size_t bids, const size_t asks)
+    {
+        m_bids.store(bids, std::memory_order_relaxed);
+        m_asks.store(asks, std::memory_order_relaxed);
+    }
+
+    // Cost of applying one message to the order book
+    void on_book_update(const uint64_t ticks, const uint64_t reallocations)
+    {
+        if (ticks > m_max_book_update_ticks.load(std::memory_order_relaxed)) {
+            m_max_book_update_ticks.store(ticks, std::memory_order_relaxed);
+        }
+        increment(m_book_reallocations, reallocations);
+    }
+
+    void set_stale(const bool stale)
+    {
+        m_stale.store(stale, std::memory_order_relaxed);
+    }
+
+    void set_silent(const bool silent)
+    {
+        m_silent.store(silent, std::memory_order_relaxed);
+    }
+
+    bool is_stale() const { return m_stale.load(std::memory_order_relaxed); }
+    bool is_silent() const { return m_silent.load(std::memory_order_relaxed); }
+
+    // Epoch of steady_clock if nothing was received yet
+    std::chrono::steady_clock::time_point last_message_time() const
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_last_message_time.load(std::memory_order_relaxed)));
+    }
+
+    Snapshot snapshot() const
+    {
+        Snapshot ret;
+        for (size_t i = 0; i < m_latency_buckets.size(); ++i) {
+            ret.latency_buckets[i] = m_latency_buckets[i].load(std::memory_order_relaxed);
+        }
+        ret.latency_sum_us = m_latency_sum_us.load(std::memory_order_relaxed);
+        ret.messages = m_messages.load(std::memory_order_relaxed);
+        ret.bytes = m_bytes.load(std::memory_order_relaxed);
+        ret.failures = m_failures.load(std::memory_order_relaxed);
+        ret.sessions_lost = m_sessions_lost.load(std::memory_order_relaxed);
+        ret.gaps = m_gaps.load(std::memory_order_relaxed);
+        ret.bids = m_bids.load(std::memory_order_relaxed);
+        ret.asks = m_asks.load(std::memory_order_relaxed);
+        ret.book_reallocations = m_book_reallocations.load(std::memory_order_relaxed);
+        ret.max_book_update_ticks = m_max_book_update_ticks.load(std::memory_order_relaxed);
+        ret.stale = m_stale.load(std::memory_order_relaxed);
+        ret.silent = m_silent.load(std::memory_order_relaxed);
+        return ret;
+    }
+
+private:
+    static void increment(std::atomic<uint64_t> & v, const uint64_t by = 1)
+    {
+        v.store(v.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, latency_bounds_us.size() + 1> m_latency_buckets{};
+    std::atomic<uint64_t> m_latency_sum_us{0};
+    std::atomic<uint64_t> m_messages{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_failures{0};
+    std::atomic<uint64_t> m_sessions_lost{0};
+    std::atomic<uint64_t> m_gaps{0};
+    std::atomic<uint64_t> m_bids{0};
+    std::atomic<uint64_t> m_asks{0};
+    std::atomic<uint64_t> m_book_reallocations{0};
+    std::atomic<uint64_t> m_max_book_update_ticks{0};
+    std::atomic<bool> m_stale{false};
+    std::atomic<bool> m_silent{false};
+    std::atomic<std::chrono::steady_clock::rep> m_last_message_time{0};
+};
@@ -1,36 +1,104 @@
 #include "Log.h"
 
-#include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <iostream>
-#include <mutex>
-
-template<class Clock, class Duration>
-struct TimePrinter {
-    explicit constexpr TimePrinter(const std::chrono::time_point<Clock, Duration> & time)
-        : m_time(time)
-    { } 
-
-    friend std::ostream & operator<<(std::ostream & oss, const TimePrinter<Clock, Duration> & time) { time.print(oss); return oss; }
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace logging {
+
+namespace {
+
+// Grows only when a message is longer than any before it on this thread
+class RecordBuffer
+    : public std::streambuf
+{
+public:
+    RecordBuffer()
+        : m_buf(initial_size)
+    {
+        reset();
+    }
+
+    void reset() { setp(m_buf.data(), m_buf.data() + m_buf.size()); }
+
+    const char * data() const { return pbase(); }
+    size_t size() const { return pptr() - pbase(); }
+
+protected:
+    int_type overflow(const int_type ch) final
+    {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        grow(1);
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    std::streamsize xsputn(const char * s, const std::streamsize n) final
+    {
+        if (epptr() - pptr() < n) {
+            grow(n);
+        }
+        std::memcpy(pptr(), s, n);
+        pbump(static_cast<int>(n));
+        return n;
+    }
+
 private:
-    void print(std::ostream & oss) const
-    {   
-        const time_t time = Clock::to_time_t(m_time);
-        auto tm = std::localtime(&time);
-        oss << std::put_time(tm, "%F %T");
-    }   
+    void grow(const size_t at_least)
+    {
+        const auto sz = size();
+        m_buf.resize(std::max(m_buf.size() * 2, sz + at_least));
+        setp(m_buf.data(), m_buf.data() + m_buf.size());
+        pbump(static_cast<int>(sz));
+    }
 
 private:
-    const std::chrono::time_point<Clock> & m_time;
+    static constexpr size_t initial_size = 4096;
+    std::vector<char> m_buf;
+};
+
+struct RecordStream
+{
+    RecordBuffer buf;
+    std::ostream strm{&buf};
 };
 
-static std::mutex log_mutex;
+thread_local RecordStream record_stream;
 
-void commit_log_message(std::string && str)
+AsyncLogger & logger()
 {
-    const auto now = std::chrono::system_clock::now();
-    // simple protection for mutlithreaded output, can be improved with any async logging
-    std::lock_guard lock(log_mutex);
-    std::cout << TimePrinter(now) << ": " << str;
+    static AsyncLogger instance;
+    return instance;
+}
+
+}
+
+std::ostream & begin_record()
+{
+    auto & rs = record_stream;
+    rs.buf.reset();
+    rs.strm.clear();
+    rs.strm.flags(std::ios_base::dec | std::ios_base::skipws);
+    rs.strm.precision(6);
+    rs.strm.width(0);
+    rs.strm.fill(' ');
+    return rs.strm;
+}
+
+void commit_record(const char * file, const int line)
+{
+    auto & rs = record_stream;
+    logger().push(file, line, rs.buf.data(), rs.buf.size());
+}
+
+void flush()
+{
+    logger().flush();
+}
+
 }
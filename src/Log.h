@@ -2,17 +2,27 @@
 
 //#define ENABLE_LOGGING
 
-#include <iostream>
-#include <sstream>
+#include <ostream>
 #include <string>
 
-void commit_log_message(std::string &&);
+// Messages are streamed into a reusable thread local buffer and handed to
+// a background thread through a lock-free ring, which adds the timestamp and
+// does the I/O, so logging does not block or allocate on the calling thread.
+namespace logging {
+
+std::ostream & begin_record();
+void commit_record(const char * file, int line);
+
+// Blocks until everything logged so far is written
+void flush();
+
+}
 
 #define _DO_LOG(msg) \
     do { \
-        std::ostringstream __oss; \
-        __oss << __FILE__ << "(" << __LINE__ << "): "<< msg << "\n"; \
-        commit_log_message(std::move(__oss).str()); \
+        auto & __strm = ::logging::begin_record(); \
+        __strm << msg; \
+        ::logging::commit_record(__FILE__, __LINE__); \
     } while (0)
 
 #define ALWAYS_LOG(msg) _DO_LOG(msg)
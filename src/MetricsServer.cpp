@@ -0,0 +1,262 @@
+#include "MetricsServer.h"
+
+#include "Log.h"
+#include "Tsc.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+namespace {
+
+// Label values escape backslash, double quote and line feed in the text format
+std::string escape_label_value(const std::string_view value)
+{
+    std::string ret;
+    ret.reserve(value.size());
+    for (const char c : value) {
+        switch (c) {
+        case '\\': ret += "\\\\"; break;
+        case '"': ret += "\\\""; break;
+        case '\n': ret += "\\n"; break;
+        default: ret += c;
+        }
+    }
+    return ret;
+}
+
+class Labels
+{
+public:
+    explicit Labels(const MetricsServer::Endpoint & e)
+        : m_labels("host=\"" + escape_label_value(e.host) + "\",ip=\"" + escape_label_value(e.ip) + "\",port=\"" + std::to_string(e.port) + "\"")
+    { }
+
+    friend std::ostream & operator<< (std::ostream & strm, const Labels & l) { return strm << l.m_labels; }
+
+private:
+    std::string m_labels;
+};
+
+void write_metadata(std::ostream & strm, const char * name, const char * type, const char * help, const char * unit = nullptr)
+{
+    strm << "# TYPE " << name << " " << type << "\n";
+    if (unit) {
+        strm << "# UNIT " << name << " " << unit << "\n";
+    }
+    strm << "# HELP " << name << " " << help << "\n";
+}
+
+class Session
+    : public std::enable_shared_from_this<Session>
+{
+public:
+    Session(asio::ip::tcp::socket socket, const MetricsServer & server)
+        : m_socket(std::move(socket))
+        , m_server(server)
+    { }
+
+    void run()
+    {
+        http::async_read(m_socket, m_buffer, m_request, [self = shared_from_this()] (const auto ec, std::size_t) {
+            if (ec) {
+                LOG_LINE("metrics request read failed: " << ec.message());
+                return;
+            }
+            self->respond();
+        });
+    }
+
+private:
+    void respond()
+    {
+        m_response.version(m_request.version());
+        m_response.keep_alive(false);
+        if (m_request.method() != http::verb::get) {
+            m_response.result(http::status::method_not_allowed);
+        } else {
+            m_response.result(http::status::ok);
+            m_response.set(http::field::content_type, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+            m_response.body() = m_server.render();
+        }
+        m_response.prepare_payload();
+        http::async_write(m_socket, m_response, [self = shared_from_this()] (const auto ec, std::size_t) {
+            if (ec) {
+                LOG_LINE("metrics response write failed: " << ec.message());
+            }
+            boost::system::error_code ignored;
+            self->m_socket.shutdown(asio::ip::tcp::socket::shutdown_send, ignored);
+        });
+    }
+
+private:
+    asio::ip::tcp::socket m_socket;
+    const MetricsServer & m_server;
+    beast::flat_buffer m_buffer;
+    http::request<http::empty_body> m_request;
+    http::response<http::string_body> m_response;
+};
+
+}
+
+class MetricsServer::Impl
+{
+public:
+    Impl(const MetricsServer & server, const IPAddress & address, const Port & port)
+        : m_server(server)
+        , m_endpoint(asio::ip::make_address(address), port)
+        , m_acceptor(m_io_context)
+    { }
+
+    ~Impl()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        m_acceptor.open(m_endpoint.protocol());
+        m_acceptor.set_option(asio::socket_base::reuse_address(true));
+        m_acceptor.bind(m_endpoint);
+        m_acceptor.listen();
+        ALWAYS_LOG("serving metrics on http://" << m_endpoint << "/metrics");
+        accept_next();
+        m_thread = std::thread([this] { m_io_context.run(); });
+    }
+
+    void stop()
+    {
+        if (!m_io_context.stopped()) {
+            m_io_context.stop();
+        }
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void add_endpoint(Endpoint endpoint)
+    {
+        m_endpoints.push_back(std::move(endpoint));
+    }
+
+    std::string render() const
+    {
+        std::ostringstream oss;
+        std::vector<ListenerMetrics::Snapshot> snapshots;
+        snapshots.reserve(m_endpoints.size());
+        for (const auto & e : m_endpoints) {
+            snapshots.push_back(e.listener->get_metrics().snapshot());
+        }
+
+        write_metadata(oss, "binance_latency_microseconds", "histogram", "Exchange event time to local receive time", "microseconds");
+        for (size_t i = 0; i < m_endpoints.size(); ++i) {
+            const Labels labels(m_endpoints[i]);
+            const auto & s = snapshots[i];
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < ListenerMetrics::latency_bounds_us.size(); ++b) {
+                cumulative += s.latency_buckets[b];
+                oss << "binance_latency_microseconds_bucket{" << labels << ",le=\"" << ListenerMetrics::latency_bounds_us[b] << ".0\"} " << cumulative << "\n";
+            }
+            cumulative += s.latency_buckets.back();
+            oss << "binance_latency_microseconds_bucket{" << labels << ",le=\"+Inf\"} " << cumulative << "\n";
+            oss << "binance_latency_microseconds_count{" << labels << "} " << cumulative << "\n";
+            oss << "binance_latency_microseconds_sum{" << labels << "} " << s.latency_sum_us << "\n";
+        }
+
+        const auto write_per_endpoint = [&] (const char * name, const char * type, const char * help, const char * suffix, const auto & get) {
+            write_metadata(oss, name, type, help);
+            for (size_t i = 0; i < m_endpoints.size(); ++i) {
+                oss << name << suffix << "{" << Labels(m_endpoints[i]) << "} " << get(m_endpoints[i], snapshots[i]) << "\n";
+            }
+        };
+        write_per_endpoint("binance_messages", "counter", "Messages received", "_total",
+                           [] (const auto &, const auto & s) { return s.messages; });
+        write_per_endpoint("binance_received_bytes", "counter", "Payload bytes received", "_total",
+                           [] (const auto &, const auto & s) { return s.bytes; });
+        write_per_endpoint("binance_listener_failures", "counter", "Failures reported to the listener", "_total",
+                           [] (const auto &, const auto & s) { return s.failures; });
+        write_per_endpoint("binance_listener_sessions_lost", "counter", "Dropped sessions the connector reconnected after", "_total",
+                           [] (const auto &, const auto & s) { return s.sessions_lost; });
+        write_per_endpoint("binance_sequence_gaps", "counter", "Discontinuities of update ids", "_total",
+                           [] (const auto &, const auto & s) { return s.gaps; });
+        write_per_endpoint("binance_book_reallocations", "counter", "Order book level vectors grown with a copy", "_total",
+                           [] (const auto &, const auto & s) { return s.book_reallocations; });
+        write_per_endpoint("binance_book_update_max_nanoseconds", "gauge", "Longest time of applying one message to the order book", "",
+                           [] (const auto &, const auto & s) { return tsc::to_ns(s.max_book_update_ticks); });
+        write_per_endpoint("binance_connector_cpu_seconds", "counter", "CPU time of the connector's thread", "_total",
+                           [] (const auto & e, const auto &) { return e.connector ? std::chrono::duration<double>(e.connector->get_cpu_time()).count() : 0.0; });
+        write_per_endpoint("binance_wire_bytes", "counter", "Bytes of websocket frames received, deflated ones with compression", "_total",
+                           [] (const auto & e, const auto &) { return e.connector ? e.connector->get_transport_statistics().wire_bytes : 0; });
+        write_per_endpoint("binance_websocket_decode_seconds", "counter", "Time of websocket framing and inflating of received messages", "_total",
+                           [] (const auto & e, const auto &) { return e.connector ? std::chrono::duration<double>(e.connector->get_transport_statistics().decode_time).count() : 0.0; });
+        write_per_endpoint("binance_connection_up", "gauge", "1 if the connector is running", "",
+                           [] (const auto & e, const auto &) { return e.connector && e.connector->is_running() ? 1 : 0; });
+        write_per_endpoint("binance_book_stale", "gauge", "1 if the order book can not be trusted", "",
+                           [] (const auto &, const auto & s) { return s.stale || s.silent ? 1 : 0; });
+        write_per_endpoint("binance_feed_silent", "gauge", "1 if no messages came for longer than the stale timeout", "",
+                           [] (const auto &, const auto & s) { return s.silent ? 1 : 0; });
+
+        write_metadata(oss, "binance_book_levels", "gauge", "Price levels in the order book");
+        for (size_t i = 0; i < m_endpoints.size(); ++i) {
+            const Labels labels(m_endpoints[i]);
+            oss << "binance_book_levels{" << labels << ",side=\"bid\"} " << snapshots[i].bids << "\n";
+            oss << "binance_book_levels{" << labels << ",side=\"ask\"} " << snapshots[i].asks << "\n";
+        }
+        oss << "# EOF\n";
+        return std::move(oss).str();
+    }
+
+private:
+    void accept_next()
+    {
+        m_acceptor.async_accept([this] (const auto ec, asio::ip::tcp::socket socket) {
+            if (ec) {
+                ALWAYS_LOG("metrics accept failed: " << ec.message());
+                return;
+            }
+            std::make_shared<Session>(std::move(socket), m_server)->run();
+            accept_next();
+        });
+    }
+
+private:
+    const MetricsServer & m_server;
+    asio::ip::tcp::endpoint m_endpoint;
+    asio::io_context m_io_context;
+    asio::ip::tcp::acceptor m_acceptor;
+    std::thread m_thread;
+    std::vector<Endpoint> m_endpoints;
+};
+
+MetricsServer::MetricsServer(const IPAddress & address, const Port & port)
+    : m_impl(std::make_unique<MetricsServer::Impl>(*this, address, port))
+{ }
+
+MetricsServer::~MetricsServer() = default;
+
+void MetricsServer::add_endpoint(Endpoint endpoint)
+{
+    return m_impl->add_endpoint(std::move(endpoint));
+}
+
+void MetricsServer::start()
+{
+    return m_impl->start();
+}
+
+void MetricsServer::stop()
+{
+    return m_impl->stop();
+}
+
+std::string MetricsServer::render() const
+{
+    return m_impl->render();
+}
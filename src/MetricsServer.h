@@ -0,0 +1,40 @@
+#pragma once
+
+#include "IConnector.h"
+#include "IJsonDataListener.h"
+#include "IPAddress.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Embedded HTTP endpoint serving per-endpoint metrics in OpenMetrics text
+// format on any path. Scrapes read ListenerMetrics snapshots only and never
+// take listeners' locks, so monitoring does not slow feed threads down.
+class MetricsServer
+{
+    class Impl;
+public:
+    struct Endpoint
+    {
+        std::string host;
+        IPAddress ip;
+        Port port;
+        std::shared_ptr<const IConnector> connector;
+        JsonDataListenerPtr listener;
+    };
+
+    MetricsServer(const IPAddress & address, const Port & port);
+    ~MetricsServer();
+
+    // Must be called before start()
+    void add_endpoint(Endpoint endpoint);
+
+    void start();
+    void stop();
+
+    std::string render() const;
+
+private:
+    std::unique_ptr<Impl> m_impl;
+};
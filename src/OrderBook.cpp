@@ -34,84 +34,209 @@ struct Double
     }
 };
 
-struct OrderBook::AskComparator
-{
-    int compare(const Price & p1, const Price & p2) const
-    {
-        return Double::compare(p1, p2);
-    }
-
-    bool operator() (const Level & lvl, const Price & p) const
-    {
-        return Double::less(lvl.price, p);
-    }
+namespace {
 
-    bool operator() (const Price & p, const Level & lvl) const
+// Strict order of prices within the side, equal prices are neither better nor worse
+template <OrderBook::Side S>
+struct Better
+{
+    bool operator() (const double p1, const double p2) const
     {
-        return Double::less(p, lvl.price);
+        if constexpr (S == OrderBook::Side::Bid) {
+            return Double::greater(p1, p2);
+        } else {
+            return Double::less(p1, p2);
+        }
     }
 };
 
-struct OrderBook::BidComparator
+template <OrderBook::Side S>
+struct Worse
 {
-    int compare(const Price & p1, const Price & p2) const
-    {
-        return -Double::compare(p1, p2);
-    }
+    bool operator() (const double p1, const double p2) const { return Better<S>()(p2, p1); }
+};
 
-    bool operator() (const Level & lvl, const Price & p) const
-    {
-        return Double::greater(lvl.price, p);
-    }
+}
 
-    bool operator() (const Price & p, const Level & lvl) const
+template <OrderBook::Side S>
+struct OrderBook::BookSide<S>::Update
+{
+    enum class Kind
     {
-        return Double::greater(p, lvl.price);
-    }
+        None,
+        Replaced,
+        Inserted,
+        Erased,
+    };
+
+    Kind kind = Kind::None;
+    size_t pos = 0;
+    double old_price = 0; // Replaced and Erased only
+    double old_volume = 0;
 };
 
-template <class Comp>
-void OrderBook::insert_replace(std::vector<Level> & lvls, const Price & p, const Volume & v, const Comp comp)
+// lvls are sorted by Order, a level with the same price is replaced or removed on zero volume
+template <OrderBook::Side S>
+template <class Order>
+typename OrderBook::BookSide<S>::Update OrderBook::BookSide<S>::update_levels(Levels & lvls, const Price & p, const Volume & v)
 {
+    const Order order;
     const bool remove_lvl = Double::equal(v, 0);
-    auto it = std::lower_bound(lvls.begin(), lvls.end(), p, comp);
-    if (it == lvls.end()) {
-        if(!remove_lvl) { // FIXME: probably volume is too low to fit even event from binance
-            lvls.emplace_back(p, v);
-        }
-        return;
-    }
-    const auto res = comp.compare(p, it->price);
-    switch (res) {
-    case 0:
+    const auto it = std::lower_bound(lvls.begin(), lvls.end(), p, [&order] (const auto & lvl, const double price) {
+        return order(lvl.price, price);
+    });
+    Update ret;
+    ret.pos = static_cast<size_t>(it - lvls.begin());
+    if (it != lvls.end() && !order(p, it->price)) {
+        ret.old_price = it->price;
+        ret.old_volume = it->volume;
         if (remove_lvl) {
             lvls.erase(it);
+            ret.kind = Update::Kind::Erased;
         } else {
             it->price = p;
             it->volume = v;
+            ret.kind = Update::Kind::Replaced;
         }
+    } else if (!remove_lvl) {
+        lvls.emplace(it, p, v);
+        ret.kind = Update::Kind::Inserted;
+    }
+    return ret;
+}
+
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::insert_replace(const Price & p, const Volume & v)
+{
+    const auto hot_capacity = m_hot.capacity();
+    const auto cold_capacity = m_cold.capacity();
+    // the worst hot level is better than p, so p is somewhere in the cold store
+    if (m_max_depth != 0 && m_hot.size() >= m_max_depth && Better<S>()(m_hot.back().price, p)) {
+        update_levels<Worse<S>>(m_cold, p, v);
+    } else {
+        update_top(update_levels<Better<S>>(m_hot, p, v));
+        rebalance();
+    }
+    m_reallocations += (m_hot.capacity() != hot_capacity) + (m_cold.capacity() != cold_capacity);
+}
+
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::add_top(const Level & lvl, const double sign)
+{
+    m_top_volume += sign * lvl.volume;
+    m_top_notional += sign * lvl.price * lvl.volume;
+}
+
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::update_top(const Update & update)
+{
+    if (update.pos >= m_top_depth || update.kind == Update::Kind::None) {
+        return;
+    }
+    // subtractions accumulate rounding errors, start over from time to time
+    if (++m_top_updates == 1 << 16) {
+        resum_top();
+        return;
+    }
+    switch (update.kind) {
+    case Update::Kind::Replaced:
+        add_top(Level(update.old_price, update.old_volume), -1);
+        add_top(m_hot[update.pos], 1);
         break;
-    case -1:
-        if (!remove_lvl) {
-            lvls.insert(it, Level(p, v));
+    case Update::Kind::Inserted:
+        add_top(m_hot[update.pos], 1);
+        if (m_hot.size() > m_top_depth) { // pushed out of the top
+            add_top(m_hot[m_top_depth], -1);
         }
         break;
-    case 1:
-        if (!remove_lvl) {
-            lvls.insert(it == lvls.begin() ? it : it - 1, Level(p, v));
+    case Update::Kind::Erased:
+        add_top(Level(update.old_price, update.old_volume), -1);
+        if (m_hot.size() >= m_top_depth) { // moved up into the top
+            add_top(m_hot[m_top_depth - 1], 1);
         }
         break;
+    default:
+        break;
+    }
+}
+
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::resum_top()
+{
+    m_top_updates = 0;
+    m_top_volume = 0;
+    m_top_notional = 0;
+    for (size_t i = 0; i < std::min(m_top_depth, m_hot.size()); ++i) {
+        add_top(m_hot[i], 1);
+    }
+}
+
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::rebalance()
+{
+    if (m_max_depth == 0) {
+        return;
     }
+    while (m_hot.size() > m_max_depth) {
+        m_cold.push_back(m_hot.back());
+        m_hot.pop_back();
+    }
+    while (m_hot.size() < m_max_depth && !m_cold.empty()) {
+        m_hot.push_back(m_cold.back());
+        m_cold.pop_back();
+        if (m_hot.size() <= m_top_depth) {
+            add_top(m_hot.back(), 1);
+        }
+    }
+}
+
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::clear()
+{
+    m_hot.clear();
+    m_cold.clear();
+    resum_top();
 }
 
+template <OrderBook::Side S>
+void OrderBook::BookSide<S>::configure(const OrderBookConfig & config)
+{
+    m_max_depth = config.max_depth;
+    // a new level is inserted before the worst one is moved out, hence + 1
+    const auto hot_depth = m_max_depth ? std::min(config.reserved_depth, m_max_depth + 1) : config.reserved_depth;
+    m_hot.reserve(hot_depth);
+    m_cold.reserve(config.reserved_depth > hot_depth ? config.reserved_depth - hot_depth : 0);
+    rebalance();
+    // the top is kept within the hot levels
+    m_top_depth = m_max_depth ? std::min(config.analytics_depth, m_max_depth) : config.analytics_depth;
+    resum_top();
+}
+
+template <OrderBook::Side S>
+OrderBook::BookSide<S> OrderBook::BookSide<S>::copy_top(const size_t levels_num) const
+{
+    BookSide ret;
+    auto & out = ret.m_hot;
+    out.reserve(std::min(levels_num, depth()));
+    out.assign(m_hot.begin(), m_hot.begin() + std::min(levels_num, m_hot.size()));
+    const auto from_cold = std::min(levels_num - out.size(), m_cold.size());
+    out.insert(out.end(), m_cold.rbegin(), m_cold.rbegin() + from_cold);
+    ret.m_top_depth = m_top_depth;
+    ret.resum_top();
+    return ret;
+}
+
+template class OrderBook::BookSide<OrderBook::Side::Bid>;
+template class OrderBook::BookSide<OrderBook::Side::Ask>;
+
 void OrderBook::insert_replace(const Price & p, const Volume & v, const Side s)
 {
     switch (s) {
     case Side::Bid:
-        insert_replace(m_bids, p, v, BidComparator());
+        insert_replace<Side::Bid>(p, v);
         break;
     case Side::Ask:
-        insert_replace(m_asks, p, v, AskComparator());
+        insert_replace<Side::Ask>(p, v);
         break;
     default:
         assert(false);
@@ -124,8 +249,65 @@ void OrderBook::clear()
     m_asks.clear();
 }
 
+void OrderBook::configure(const OrderBookConfig & config)
+{
+    m_bids.configure(config);
+    m_asks.configure(config);
+}
+
+BookAnalytics OrderBook::get_analytics() const
+{
+    BookAnalytics ret;
+    if (get_bids().empty() || get_asks().empty()) {
+        return ret;
+    }
+    const auto & bid = get_bids().front();
+    const auto & ask = get_asks().front();
+    ret.valid = true;
+    ret.best_bid = bid.price;
+    ret.best_ask = ask.price;
+    ret.mid = (bid.price + ask.price) / 2;
+    ret.spread = ask.price - bid.price;
+    const auto best_volume = bid.volume + ask.volume;
+    ret.microprice = best_volume > 0 ? (bid.price * ask.volume + ask.price * bid.volume) / best_volume : ret.mid;
+    ret.bid_volume = std::max(m_bids.top_volume(), 0.0);
+    ret.ask_volume = std::max(m_asks.top_volume(), 0.0);
+    const auto top_volume = ret.bid_volume + ret.ask_volume;
+    ret.imbalance = top_volume > 0 ? (ret.bid_volume - ret.ask_volume) / top_volume : 0;
+    ret.bid_vwap = ret.bid_volume > 0 ? m_bids.top_notional() / ret.bid_volume : 0;
+    ret.ask_vwap = ret.ask_volume > 0 ? m_asks.top_notional() / ret.ask_volume : 0;
+    return ret;
+}
+
+OrderBook OrderBook::copy_top(const size_t levels_num) const
+{
+    OrderBook ret;
+    ret.m_bids = m_bids.copy_top(levels_num);
+    ret.m_asks = m_asks.copy_top(levels_num);
+    return ret;
+}
+
+std::ostream & operator<< (std::ostream & strm, const BookAnalytics & a)
+{
+    if (!a.valid) {
+        return strm << "no two-sided book";
+    }
+    const auto precision = strm.precision();
+    strm << std::setprecision(10) << "mid: " << a.mid << ", spread: " << a.spread << ", microprice: " << a.microprice
+         << ", imbalance: " << std::setprecision(3) << a.imbalance
+         << ", vwap bid/ask: " << std::setprecision(10) << a.bid_vwap << "/" << a.ask_vwap;
+    strm.precision(precision);
+    return strm;
+}
+
 std::ostream & OrderBook::print(std::ostream & strm, const size_t levels_to_show) const
 {
+    if (get_bids().size() < get_bids_depth() || get_asks().size() < get_asks_depth()) {
+        // the copy has no depth limit, all its levels are hot
+        return copy_top(-1).print(strm, levels_to_show);
+    }
+    const auto flags = strm.flags();
+    const auto precision = strm.precision();
     const auto print_pre = [] (auto & strm) { strm << "\n|"; };
     const auto print_lvl = [] (auto & strm, const auto & lvls, const auto idx) {
         if (idx < lvls.size()) {
@@ -135,8 +317,8 @@ std::ostream & OrderBook::print(std::ostream & strm, const size_t levels_to_show
         }
     };
     const auto print_post = [] (auto & strm) { strm << "|"; };
-    const auto max_sz = std::max(m_asks.size(), m_bids.size());
-    strm << "OrderBook: BIDS: " << m_bids.size() << ", ASKS: " << m_asks.size();
+    const auto max_sz = std::max(get_asks().size(), get_bids().size());
+    strm << "OrderBook: BIDS: " << get_bids().size() << ", ASKS: " << get_asks().size();
     if (levels_to_show == -1) {
         strm << ", showing ALL levels";
     } else {
@@ -145,15 +327,17 @@ std::ostream & OrderBook::print(std::ostream & strm, const size_t levels_to_show
     strm << "\n||            BIDS             ||" << "            ASKS             ||";
     for (size_t idx = 0; idx < std::min(max_sz, levels_to_show); ++idx) {
         print_pre(strm);
-        print_lvl(strm, m_bids, idx);
-        print_lvl(strm, m_asks, idx);
+        print_lvl(strm, get_bids(), idx);
+        print_lvl(strm, get_asks(), idx);
         print_post(strm);
     }
     if (max_sz == 0) { // print empty
         print_pre(strm);
-        print_lvl(strm, m_bids, 0);
-        print_lvl(strm, m_asks, 0);
+        print_lvl(strm, get_bids(), 0);
+        print_lvl(strm, get_asks(), 0);
         print_post(strm);
     }
+    strm.flags(flags);
+    strm.precision(precision);
     return strm;
 }
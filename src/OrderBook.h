@@ -1,9 +1,38 @@
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
+#include <memory_resource>
 #include <vector>
 
-class OrderBook // TODO: write tests
+struct OrderBookConfig
+{
+    size_t reserved_depth = 0;  // levels per side allocated up front
+    size_t max_depth = 0;       // levels per side kept in the hot vectors, 0 means no limit
+    size_t analytics_depth = 0; // levels per side summed for BookAnalytics, 0 disables the sums
+};
+
+// Derived from the best levels and the running sums over the top
+// analytics_depth levels, so reading it costs the same for any book size.
+// Everything is zero unless both sides have levels.
+struct BookAnalytics
+{
+    bool valid = false;
+    double best_bid = 0;
+    double best_ask = 0;
+    double mid = 0;
+    double spread = 0;
+    double microprice = 0; // mid weighted by the opposite side's best volume
+    double bid_volume = 0; // over the top levels
+    double ask_volume = 0;
+    double imbalance = 0;  // (bid_volume - ask_volume) / (bid_volume + ask_volume)
+    double bid_vwap = 0;   // volume weighted price over the top levels
+    double ask_vwap = 0;
+};
+
+std::ostream & operator<< (std::ostream & strm, const BookAnalytics & a);
+
+class OrderBook
 {
     using Price = double;
     using Volume = double;
@@ -17,8 +46,6 @@ class OrderBook // TODO: write tests
         Price price;
         Volume volume;
     };
-    struct BidComparator;
-    struct AskComparator;
 
 public:
     enum class Side
@@ -27,23 +54,108 @@ public:
         Ask,
     };
 
+    using Levels = std::pmr::vector<Level>;
+
+    // Levels of one side sorted best first in a vector. The direction is a
+    // template parameter, so price comparisons compile to a single branch
+    // free of any side dispatch. With a depth limit only the top max_depth
+    // levels stay in the vector, deeper ones go to a cold store sorted worst
+    // first, so levels crossing the boundary are pushed and popped at its
+    // back. The cold store is not visible through levels(), copy_top()
+    // merges it back. Sums over the top levels are adjusted by the changed
+    // level and the one crossing the top boundary only.
+    template <Side S>
+    class BookSide
+    {
+    public:
+        explicit BookSide(std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+            : m_hot(resource)
+            , m_cold(resource)
+        { }
+
+        void insert_replace(const Price &, const Volume &);
+        void clear();
+        void configure(const OrderBookConfig & config);
+        // Copy with the default memory resource and no depth limit
+        BookSide copy_top(size_t levels_num) const;
+
+        const Levels & levels() const { return m_hot; }
+        // Including the cold store
+        size_t depth() const { return m_hot.size() + m_cold.size(); }
+        uint64_t get_reallocations() const { return m_reallocations; }
+
+        double top_volume() const { return m_top_volume; }
+        double top_notional() const { return m_top_notional; }
+
+    private:
+        struct Update;
+        template <class Order>
+        static Update update_levels(Levels & lvls, const Price &, const Volume &);
+        void update_top(const Update & update);
+        void add_top(const Level & lvl, double sign);
+        void resum_top();
+        void rebalance();
+
+    private:
+        Levels m_hot;
+        Levels m_cold;
+        size_t m_max_depth = 0;
+        uint64_t m_reallocations = 0;
+        size_t m_top_depth = 0;
+        double m_top_volume = 0;
+        double m_top_notional = 0;
+        uint32_t m_top_updates = 0; // since the sums were recomputed
+    };
+
+    OrderBook() = default;
+    // Level storage of both sides comes from resource, which must outlive the book
+    explicit OrderBook(std::pmr::memory_resource * resource)
+        : m_bids(resource)
+        , m_asks(resource)
+    { }
+
+    template <Side S>
+    void insert_replace(const Price & p, const Volume & v) { side<S>().insert_replace(p, v); }
+    // For callers which know the side at runtime only
     void insert_replace(const Price &, const Volume &, Side);
     void clear();
 
-    const auto & get_bids() const { return m_bids; }
-    const auto & get_asks() const { return m_asks; }
+    // Reserves storage, moves levels beyond the new depth limit to the cold
+    // store and recomputes the analytics sums
+    void configure(const OrderBookConfig & config);
+
+    const Levels & get_bids() const { return m_bids.levels(); }
+    const Levels & get_asks() const { return m_asks.levels(); }
+
+    size_t get_bids_depth() const { return m_bids.depth(); }
+    size_t get_asks_depth() const { return m_asks.depth(); }
 
-    bool empty() const { return m_bids.empty() && m_asks.empty(); }
+    // Times a level vector had to grow and move its levels
+    uint64_t get_reallocations() const { return m_bids.get_reallocations() + m_asks.get_reallocations(); }
 
+    bool empty() const { return get_bids_depth() == 0 && get_asks_depth() == 0; }
+
+    BookAnalytics get_analytics() const;
+
+    OrderBook copy_top(size_t levels_num) const;
+
+    // Including the cold store
     std::ostream & print(std::ostream &, size_t levels_num = -1) const;
 
     friend std::ostream & operator<< (std::ostream & strm, const OrderBook & ob) { return ob.print(strm); }
 
 private:
-    template <class Comp>
-    static void insert_replace(std::vector<Level> & lvls, const Price &, const Volume &, Comp);
+    template <Side S>
+    BookSide<S> & side()
+    {
+        if constexpr (S == Side::Bid) {
+            return m_bids;
+        } else {
+            return m_asks;
+        }
+    }
 
-public:
-    std::vector<Level> m_bids;
-    std::vector<Level> m_asks;
+private:
+    BookSide<Side::Bid> m_bids;
+    BookSide<Side::Ask> m_asks;
 };
@@ -0,0 +1,121 @@
+#include "OrderBookRenderer.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+constexpr size_t volume_width = 11;
+constexpr size_t price_width = 16;
+
+template <class Levels, class Cells>
+bool update_cell(const Levels & lvls, Cells & cells, const size_t idx)
+{
+    typename Cells::value_type cell;
+    if (idx < lvls.size()) {
+        cell.price = lvls[idx].price;
+        cell.volume = lvls[idx].volume;
+        cell.present = true;
+    }
+    if (cells[idx] == cell) {
+        return false;
+    }
+    cells[idx] = cell;
+    return true;
+}
+
+}
+
+OrderBookRenderer::OrderBookRenderer(const size_t levels_num)
+    : m_levels_num(levels_num)
+{ }
+
+void OrderBookRenderer::reset()
+{
+    m_rendered = false;
+    m_bids.clear();
+    m_asks.clear();
+}
+
+std::string_view OrderBookRenderer::render(const OrderBook & ob)
+{
+    return render(ob, !m_rendered);
+}
+
+std::string_view OrderBookRenderer::render_full(const OrderBook & ob)
+{
+    return render(ob, true);
+}
+
+std::string_view OrderBookRenderer::render(const OrderBook & ob, const bool full)
+{
+    const auto rows = std::min(std::max(ob.get_bids().size(), ob.get_asks().size()), m_levels_num);
+    if (m_bids.size() < rows) {
+        m_bids.resize(rows);
+        m_asks.resize(rows);
+    }
+
+    m_changed.clear();
+    for (size_t idx = 0; idx < m_bids.size(); ++idx) {
+        const bool bid_changed = update_cell(ob.get_bids(), m_bids, idx);
+        const bool ask_changed = update_cell(ob.get_asks(), m_asks, idx);
+        if (full ? idx < rows : (bid_changed || ask_changed)) {
+            m_changed.push_back(idx);
+        }
+    }
+    m_rendered = true;
+
+    m_out.clear();
+    append_header(rows, m_changed.size());
+    for (const auto idx : m_changed) {
+        append_row(idx);
+    }
+    return m_out;
+}
+
+void OrderBookRenderer::append_header(const size_t rows, const size_t changed)
+{
+    m_out += "OrderBook rows changed: ";
+    append_number(static_cast<double>(changed), 0, false);
+    m_out += " of ";
+    append_number(static_cast<double>(rows), 0, false);
+    m_out += "\n      ||             BIDS             ||             ASKS             ||";
+}
+
+void OrderBookRenderer::append_row(const size_t idx)
+{
+    m_out += "\n";
+    append_number(static_cast<double>(idx), 5, true);
+    m_out += " |";
+    append_cell(m_bids[idx]);
+    append_cell(m_asks[idx]);
+    m_out += "|";
+}
+
+void OrderBookRenderer::append_cell(const Cell & cell)
+{
+    if (!cell.present) {
+        m_out += "|            <empty>           |";
+        return;
+    }
+    m_out += "| ";
+    append_number(cell.volume, volume_width, true);
+    m_out += "@";
+    append_number(cell.price, price_width, false);
+    m_out += " |";
+}
+
+void OrderBookRenderer::append_number(const double v, const size_t width, const bool align_right)
+{
+    char buf[32];
+    const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    const auto len = ec == std::errc() ? static_cast<size_t>(end - buf) : 0;
+    const auto pad = width > len ? width - len : 0;
+    if (align_right) {
+        m_out.append(pad, ' ');
+    }
+    m_out.append(buf, len);
+    if (!align_right) {
+        m_out.append(pad, ' ');
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "OrderBook.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Renders the top levels of an order book as text, remembering what was
+// rendered last time so that consecutive reports only contain the rows that
+// changed. Numbers are formatted with to_chars into fixed width cells of a
+// reusable buffer, there are no streams and no allocations in steady state.
+class OrderBookRenderer
+{
+public:
+    explicit OrderBookRenderer(size_t levels_num);
+
+    // Rows changed since the previous call, the first call renders all of them
+    std::string_view render(const OrderBook & ob);
+    // All rows, also remembered for the next render()
+    std::string_view render_full(const OrderBook & ob);
+
+    void reset();
+
+    size_t get_levels_num() const { return m_levels_num; }
+
+private:
+    struct Cell
+    {
+        double price = 0;
+        double volume = 0;
+        bool present = false;
+
+        bool operator== (const Cell & o) const { return present == o.present && (!present || (price == o.price && volume == o.volume)); }
+        bool operator!= (const Cell & o) const { return !(*this == o); }
+    };
+
+    std::string_view render(const OrderBook & ob, bool full);
+    void append_header(size_t rows, size_t changed);
+    void append_row(size_t idx);
+    void append_cell(const Cell & cell);
+    void append_number(double v, size_t width, bool align_right);
+
+private:
+    size_t m_levels_num;
+    bool m_rendered = false;
+    std::vector<Cell> m_bids;
+    std::vector<Cell> m_asks;
+    std::vector<size_t> m_changed;
+    std::string m_out;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace binance {
+
+// Memory of parsed documents. Allocators hand out pieces of fixed buffers
+// and are cleared before every message, so parsing usual messages touches
+// no heap at all. A message not fitting the buffers takes chunks from the
+// heap, which are released on the next clear().
+class ParseArena
+{
+    // Lets the allocation tracking in tests see chunks of overflowing messages
+    struct NewAllocator
+    {
+        static const bool kNeedFree = true;
+        void * Malloc(const size_t size) { return size ? ::operator new(size) : nullptr; }
+        void * Realloc(void * p, const size_t old_size, const size_t new_size)
+        {
+            void * ret = Malloc(new_size);
+            if (p && ret) {
+                std::memcpy(ret, p, std::min(old_size, new_size));
+            }
+            Free(p);
+            return ret;
+        }
+        static void Free(void * p) { ::operator delete(p); }
+    };
+
+public:
+    using Allocator = rapidjson::MemoryPoolAllocator<NewAllocator>;
+    using Document = rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator, Allocator>;
+    using Value = rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>;
+
+    static constexpr size_t values_size = 256 * 1024;
+    static constexpr size_t stack_size = 16 * 1024;
+
+    void clear()
+    {
+        m_values.Clear();
+        m_stack.Clear();
+    }
+
+    Document make_document() { return Document(&m_values, stack_size / 2, &m_stack); }
+
+private:
+    alignas(std::max_align_t) char m_values_buffer[values_size];
+    alignas(std::max_align_t) char m_stack_buffer[stack_size];
+    NewAllocator m_base;
+    Allocator m_values{m_values_buffer, sizeof(m_values_buffer), values_size, &m_base};
+    Allocator m_stack{m_stack_buffer, sizeof(m_stack_buffer), stack_size, &m_base};
+};
+
+// Binance sends prices and quantities as strings
+template <class Value>
+double to_double(const Value & v)
+{
+    const auto str = v.GetString();
+    double ret;
+    const auto [ptr, ec] = std::from_chars(str, str + v.GetStringLength(), ret);
+    if (ec != std::errc()) {
+        throw std::invalid_argument("not a number in price level");
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+//#define ENABLE_PIPELINE_TRACE
+
+#include "LatencyHistogram.h"
+#include "Tsc.h"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// Per message breakdown of time spent inside the process, from the moment
+// bytes of the message reached user space until the order book is updated.
+// Network time before that is what Statistics already measures via "E".
+// Without ENABLE_PIPELINE_TRACE all of it compiles to nothing.
+enum class Stage : uint8_t
+{
+    Tls,        // socket read completed -> TLS record decrypted
+    WebSocket,  // TLS decrypted -> websocket message complete
+    Copy,       // copy of the message into the connector's buffer
+    Parse,      // rapidjson parse
+    Lock,       // waiting for the listener's mutex, e.g. while order book is copied
+    Convert,    // price/volume string to double conversions
+    Book,       // OrderBook::insert_replace
+    Count
+};
+
+inline const char * to_string(const Stage s)
+{
+    switch (s) {
+    case Stage::Tls: return "tls";
+    case Stage::WebSocket: return "ws";
+    case Stage::Copy: return "copy";
+    case Stage::Parse: return "parse";
+    case Stage::Lock: return "lock";
+    case Stage::Convert: return "convert";
+    case Stage::Book: return "book";
+    default: return "unknown";
+    }
+}
+
+#ifdef ENABLE_PIPELINE_TRACE
+
+// Each lap attributes ticks elapsed since the previous lap to the given stage
+class PipelineTrace
+{
+public:
+    void start(const uint64_t ticks) { m_last = ticks; }
+    void lap(const Stage s) { lap(s, tsc::now()); }
+    void lap(const Stage s, const uint64_t ticks)
+    {
+        if (m_last && ticks > m_last) {
+            m_durations[static_cast<size_t>(s)] += ticks - m_last;
+        }
+        m_last = ticks;
+    }
+
+    bool started() const { return m_last != 0; }
+    uint64_t get(const Stage s) const { return m_durations[static_cast<size_t>(s)]; }
+
+private:
+    uint64_t m_last = 0;
+    std::array<uint64_t, static_cast<size_t>(Stage::Count)> m_durations{};
+};
+
+class PipelineStatistics
+{
+public:
+    void add(const PipelineTrace & trace)
+    {
+        if (!trace.started()) {
+            return;
+        }
+        uint64_t total = 0;
+        for (size_t i = 0; i < m_stages.size(); ++i) {
+            const auto ticks = trace.get(static_cast<Stage>(i));
+            m_stages[i].add(ticks);
+            total += ticks;
+        }
+        m_total.add(total);
+    }
+
+    void clear() { *this = PipelineStatistics(); }
+    bool empty() const { return m_total.empty(); }
+
+    const LatencyHistogram & get(const Stage s) const { return m_stages[static_cast<size_t>(s)]; }
+    const LatencyHistogram & get_total() const { return m_total; }
+
+    // Histograms keep ticks, conversion happens here to keep calibration off the feed threads
+    std::ostream & print(std::ostream & strm) const
+    {
+        if (empty()) {
+            return strm << "<empty>";
+        }
+        const auto print_hist = [&strm] (const char * name, const LatencyHistogram & h) {
+            strm << name << " p50/p99: " << tsc::to_ns(h.percentile(0.5)) << "/" << tsc::to_ns(h.percentile(0.99)) << "ns";
+        };
+        for (size_t i = 0; i < m_stages.size(); ++i) {
+            print_hist(to_string(static_cast<Stage>(i)), m_stages[i]);
+            strm << ", ";
+        }
+        print_hist("total", m_total);
+        return strm;
+    }
+
+    friend std::ostream & operator<< (std::ostream & strm, const PipelineStatistics & s) { return s.print(strm); }
+
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(Stage::Count)> m_stages;
+    LatencyHistogram m_total;
+};
+
+#else
+
+class PipelineTrace
+{
+public:
+    void start(uint64_t) {}
+    void lap(Stage) {}
+    void lap(Stage, uint64_t) {}
+};
+
+class PipelineStatistics
+{
+public:
+    void add(const PipelineTrace &) {}
+    void clear() {}
+    bool empty() const { return true; }
+
+    friend std::ostream & operator<< (std::ostream & strm, const PipelineStatistics &) { return strm << "<disabled>"; }
+};
+
+#endif
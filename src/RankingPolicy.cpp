@@ -0,0 +1,116 @@
+#include "RankingPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// A window without event times has no latency, it goes after all measured ones
+double latency_score(const WindowSummary & s, const uint64_t us)
+{
+    return s.timed ? static_cast<double>(us) : std::numeric_limits<double>::max();
+}
+
+class P99Policy final
+    : public IRankingPolicy
+{
+public:
+    const char * name() const final { return "p99"; }
+    double score(const WindowSummary & s) const final { return latency_score(s, s.p99_us); }
+};
+
+class MedianPolicy final
+    : public IRankingPolicy
+{
+public:
+    const char * name() const final { return "median"; }
+    double score(const WindowSummary & s) const final { return latency_score(s, s.p50_us); }
+};
+
+class AvgPolicy final
+    : public IRankingPolicy
+{
+public:
+    const char * name() const final { return "avg"; }
+    double score(const WindowSummary & s) const final { return latency_score(s, s.avg_us); }
+};
+
+// Does not depend on clocks at all, works for streams without event time too
+class WinRatePolicy final
+    : public IRankingPolicy
+{
+public:
+    const char * name() const final { return "win-rate"; }
+    double score(const WindowSummary & s) const final { return -s.win_rate; }
+};
+
+}
+
+std::unique_ptr<IRankingPolicy> make_ranking_policy(const std::string_view name)
+{
+    if (name == "p99") {
+        return std::make_unique<P99Policy>();
+    }
+    if (name == "median") {
+        return std::make_unique<MedianPolicy>();
+    }
+    if (name == "avg") {
+        return std::make_unique<AvgPolicy>();
+    }
+    if (name == "win-rate") {
+        return std::make_unique<WinRatePolicy>();
+    }
+    throw std::invalid_argument("unknown ranking policy: " + std::string(name));
+}
+
+EndpointRanker::EndpointRanker(std::unique_ptr<IRankingPolicy> policy, const std::chrono::seconds window, const double hysteresis)
+    : m_policy(std::move(policy))
+    , m_window(window)
+    , m_hysteresis(hysteresis)
+{ }
+
+size_t EndpointRanker::rank(std::vector<Candidate> & candidates)
+{
+    std::vector<std::pair<double, size_t>> order;
+    order.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        order.emplace_back(m_policy->score(candidates[i].window), i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&] (const auto & a, const auto & b) {
+        const bool a_empty = candidates[a.second].window.empty();
+        const bool b_empty = candidates[b.second].window.empty();
+        if (a_empty != b_empty) {
+            return b_empty;
+        }
+        return !a_empty && a.first < b.first;
+    });
+
+    std::vector<Candidate> sorted;
+    sorted.reserve(candidates.size());
+    for (const auto & [score, i] : order) {
+        sorted.push_back(std::move(candidates[i]));
+    }
+    candidates = std::move(sorted);
+
+    if (candidates.empty() || candidates.front().window.empty()) {
+        m_best = nullptr;
+        return candidates.size();
+    }
+
+    const auto leader_score = order.front().first;
+    for (size_t i = 0; i < candidates.size() && m_best; ++i) {
+        if (candidates[i].listener.get() != m_best || candidates[i].window.empty()) {
+            continue;
+        }
+        // the current best stays unless the leader beats it by the margin
+        const auto best_score = order[i].first;
+        if (leader_score >= best_score - m_hysteresis * std::abs(best_score)) {
+            return i;
+        }
+        break;
+    }
+    m_best = candidates.front().listener.get();
+    return 0;
+}
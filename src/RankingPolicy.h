@@ -0,0 +1,55 @@
+#pragma once
+
+#include "IConnector.h"
+#include "IJsonDataListener.h"
+#include "WindowedStatistics.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Scores a listener by its windowed statistics, lower is better
+class IRankingPolicy
+{
+public:
+    virtual ~IRankingPolicy() = default;
+
+    virtual const char * name() const = 0;
+    virtual double score(const WindowSummary & s) const = 0;
+};
+
+// One of "p99", "median", "avg", "win-rate", throws std::invalid_argument otherwise
+std::unique_ptr<IRankingPolicy> make_ranking_policy(std::string_view name);
+
+// Orders listeners by a policy applied to a recent time window and keeps
+// the best listener until another one is better by more than the
+// hysteresis share of its score, so the choice does not flap on noise.
+class EndpointRanker
+{
+public:
+    struct Candidate
+    {
+        std::string host;
+        Statistics total;
+        WindowSummary window;
+        DepthDataListenerPtr listener;
+        TransportStatistics transport; // reported along, not ranked
+    };
+
+    EndpointRanker(std::unique_ptr<IRankingPolicy> policy, std::chrono::seconds window, double hysteresis);
+
+    std::chrono::seconds get_window() const { return m_window; }
+    const IRankingPolicy & get_policy() const { return *m_policy; }
+
+    // Sorts candidates best first with empty windows last, returns the
+    // position of the chosen listener or candidates.size() if all are empty
+    size_t rank(std::vector<Candidate> & candidates);
+
+private:
+    std::unique_ptr<IRankingPolicy> m_policy;
+    std::chrono::seconds m_window;
+    double m_hysteresis;
+    const IJsonDataListener * m_best = nullptr;
+};
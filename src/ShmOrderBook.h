@@ -0,0 +1,119 @@
+#pragma once
+
+// Header-only layout and reader of the order book published to POSIX shared
+// memory by ShmOrderBookPublisher. Consumers only need this file:
+//
+//     shm_book::Reader reader("/binance_btcusdt");
+//     shm_book::Snapshot snapshot;
+//     if (reader.read(snapshot)) { ... snapshot.bids[0].price ... }
+//
+// The segment holds one snapshot guarded by a seqlock, so reading is a
+// couple of atomic loads and a memcpy, no syscalls after the mapping.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shm_book {
+
+inline constexpr uint32_t magic = 0x4B4F4242; // "BBOK"
+inline constexpr uint32_t version = 1;
+inline constexpr size_t max_depth = 50;
+
+struct Level
+{
+    double price;
+    double volume;
+};
+
+struct Snapshot
+{
+    uint64_t update_id;        // "u" of the last applied depthUpdate
+    int64_t event_time_ms;     // "E" of the last applied depthUpdate
+    int64_t publish_time_ns;   // local system_clock time of publication
+    char source[48];           // endpoint the book came from, null terminated
+    uint32_t bids_num;
+    uint32_t asks_num;
+    Level bids[max_depth];     // best first
+    Level asks[max_depth];     // best first
+};
+
+struct Segment
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t depth;            // levels per side the publisher fills, <= max_depth
+    alignas(64) std::atomic<uint64_t> seq; // odd while a write is in progress
+    alignas(64) Snapshot snapshot;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock in shared memory needs address-free atomics");
+
+class Reader
+{
+public:
+    explicit Reader(const std::string & name)
+    {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open(" + name + ")");
+        }
+        void * ptr = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap(" + name + ")");
+        }
+        m_segment = static_cast<const Segment *>(ptr);
+        if (m_segment->magic != magic || m_segment->version != version) {
+            munmap(ptr, sizeof(Segment));
+            throw std::runtime_error("unexpected shared order book layout in " + name);
+        }
+    }
+
+    ~Reader()
+    {
+        munmap(const_cast<Segment *>(m_segment), sizeof(Segment));
+    }
+
+    Reader(const Reader &) = delete;
+    Reader & operator=(const Reader &) = delete;
+
+    // Changes on every publication, cheap to poll before reading
+    uint64_t sequence() const { return m_segment->seq.load(std::memory_order_acquire); }
+
+    uint32_t depth() const { return m_segment->depth; }
+
+    // Returns false if nothing was published yet or the writer kept the
+    // snapshot busy for max_attempts tries
+    bool read(Snapshot & out, const size_t max_attempts = 1000) const
+    {
+        for (size_t i = 0; i < max_attempts; ++i) {
+            const auto before = m_segment->seq.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            if (before & 1) {
+                continue;
+            }
+            std::memcpy(&out, &m_segment->snapshot, sizeof(Snapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_segment->seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const Segment * m_segment = nullptr;
+};
+
+}
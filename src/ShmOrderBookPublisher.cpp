@@ -0,0 +1,67 @@
+#include "ShmOrderBookPublisher.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <new>
+
+ShmOrderBookPublisher::ShmOrderBookPublisher(std::string name, const size_t depth)
+    : m_name(std::move(name))
+{
+    const int fd = shm_open(m_name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "shm_open(" + m_name + ")");
+    }
+    if (ftruncate(fd, sizeof(shm_book::Segment)) != 0) {
+        const auto err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(), "ftruncate(" + m_name + ")");
+    }
+    void * ptr = mmap(nullptr, sizeof(shm_book::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "mmap(" + m_name + ")");
+    }
+    m_segment = new (ptr) shm_book::Segment{};
+    m_segment->depth = static_cast<uint32_t>(std::min(depth, shm_book::max_depth));
+    m_segment->version = shm_book::version;
+    std::atomic_thread_fence(std::memory_order_release);
+    m_segment->magic = shm_book::magic;
+    ALWAYS_LOG("publishing " << m_segment->depth << " order book levels to shared memory " << m_name);
+}
+
+ShmOrderBookPublisher::~ShmOrderBookPublisher()
+{
+    munmap(m_segment, sizeof(shm_book::Segment));
+    shm_unlink(m_name.c_str());
+}
+
+void ShmOrderBookPublisher::on_source_changed(const std::string_view source_name)
+{
+    const auto len = std::min(source_name.size(), sizeof(m_source_name) - 1);
+    std::memcpy(m_source_name, source_name.data(), len);
+    m_source_name[len] = '\0';
+}
+
+void ShmOrderBookPublisher::write(const BookUpdate & update)
+{
+    const auto seq = m_segment->seq.load(std::memory_order_relaxed);
+    m_segment->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto & s = m_segment->snapshot;
+    s.update_id = update.update_id;
+    s.event_time_ms = update.event_time.count();
+    s.publish_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(s.source, m_source_name, sizeof(s.source));
+    const auto copy_side = [depth = m_segment->depth] (const auto & lvls, shm_book::Level * out, uint32_t & num) {
+        num = static_cast<uint32_t>(std::min<size_t>(lvls.size(), depth));
+        for (uint32_t i = 0; i < num; ++i) {
+            out[i] = {lvls[i].price, lvls[i].volume};
+        }
+    };
+    copy_side(update.book.get_bids(), s.bids, s.bids_num);
+    copy_side(update.book.get_asks(), s.asks, s.asks_num);
+
+    m_segment->seq.store(seq + 2, std::memory_order_release);
+}
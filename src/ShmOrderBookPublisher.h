@@ -0,0 +1,33 @@
+#pragma once
+
+#include "BookPublisher.h"
+#include "ShmOrderBook.h"
+
+#include <string>
+#include <string_view>
+
+// Writes top levels of the order book from the currently selected source
+// listener into a POSIX shared memory segment (see ShmOrderBook.h for the
+// reader side).
+class ShmOrderBookPublisher final
+    : public BookPublisher
+{
+public:
+    ShmOrderBookPublisher(std::string name, size_t depth);
+    ~ShmOrderBookPublisher() final;
+
+    ShmOrderBookPublisher(const ShmOrderBookPublisher &) = delete;
+    ShmOrderBookPublisher & operator=(const ShmOrderBookPublisher &) = delete;
+
+    const std::string & get_name() const { return m_name; }
+
+private:
+    void on_source_changed(std::string_view source_name) final;
+    void on_reset() final { } // every write replaces the whole snapshot
+    void write(const BookUpdate & update) final;
+
+private:
+    std::string m_name;
+    shm_book::Segment * m_segment = nullptr;
+    char m_source_name[sizeof(shm_book::Snapshot::source)] = {};
+};
@@ -0,0 +1,195 @@
+#include "StreamComparison.h"
+
+#include "BinanceIncDepthProcessor.h"
+#include "BinanceTopOfBookProcessor.h"
+#include "BinanceWebSocketConnector.h"
+#include "Log.h"
+#include "Tsc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace binance {
+
+namespace {
+
+JsonDataListenerPtr make_listener(const StreamVariant & variant, const bool build_order_book, const OrderBookConfig & book_config,
+                                  const std::vector<std::string> & tickers, std::shared_ptr<ArrivalLog> log)
+{
+    if (variant.type == StreamType::Depth) {
+        auto processor = std::make_shared<BinanceIncDepthProcessor>(build_order_book, book_config, tickers);
+        processor->set_arrival_log(std::move(log));
+        return processor;
+    }
+    auto processor = std::make_shared<BinanceTopOfBookProcessor>(variant.type, build_order_book, book_config, tickers);
+    processor->set_arrival_log(std::move(log));
+    return processor;
+}
+
+}
+
+StreamComparison::StreamComparison(const std::vector<StreamEndpoint> & endpoints, const std::vector<std::string> & tickers,
+                                   const std::vector<StreamVariant> & variants, const std::vector<Transport> & transports,
+                                   const bool build_order_book, const OrderBookConfig & book_config, const ConnectorOptions & options)
+    : m_last_report(std::chrono::steady_clock::now())
+{
+    m_endpoints.reserve(endpoints.size());
+    for (const auto & e : endpoints) {
+        auto & endpoint = m_endpoints.emplace_back();
+        endpoint.label = e.label();
+        endpoint.feeds.reserve(variants.size() * transports.size());
+        for (const auto & variant : variants) {
+            for (const auto & transport : transports) {
+                auto & feed = endpoint.feeds.emplace_back();
+                feed.variant = variant;
+                feed.name = transports.size() > 1 ? variant.name() + '/' + transport.name() : variant.name();
+                if (has_book(variant.type)) {
+                    feed.log = std::make_shared<ArrivalLog>();
+                }
+                feed.listener = make_listener(variant, build_order_book, book_config, tickers, feed.log);
+                auto connector = BinanceWebSocketConnector::make_connector(e.ip, e.port, tickers, variant, feed.listener);
+                connector->set_reconnect_attempts(options.reconnect_attempts);
+                connector->set_kernel_tls(options.kernel_tls);
+                connector->set_io_backend(transport.backend);
+                connector->set_compression(transport.compression);
+                if (options.cpu_pool) {
+                    connector->set_cpu_pool(options.cpu_pool);
+                }
+                feed.connector = std::move(connector);
+            }
+        }
+    }
+}
+
+StreamComparison::~StreamComparison()
+{
+    stop();
+}
+
+void StreamComparison::start()
+{
+    m_last_report = std::chrono::steady_clock::now();
+    for (auto & endpoint : m_endpoints) {
+        for (auto & feed : endpoint.feeds) {
+            try {
+                feed.connector->start();
+            } catch (const std::exception & e) {
+                LOG_LINE("Exception on starting " << feed.name << " stream of [" << endpoint.label << "]");
+            }
+        }
+    }
+}
+
+void StreamComparison::stop()
+{
+    for (auto & endpoint : m_endpoints) {
+        for (auto & feed : endpoint.feeds) {
+            feed.connector->stop();
+        }
+    }
+}
+
+bool StreamComparison::is_running() const
+{
+    return std::any_of(m_endpoints.begin(), m_endpoints.end(), [] (const auto & endpoint) {
+        return std::any_of(endpoint.feeds.begin(), endpoint.feeds.end(), [] (const auto & feed) { return feed.connector->is_running(); });
+    });
+}
+
+void StreamComparison::measure_lags(Endpoint & endpoint)
+{
+    std::vector<Feed *> feeds;
+    for (auto & feed : endpoint.feeds) {
+        if (feed.log && feed.connector->is_running() && feed.log->frontier()) {
+            feeds.push_back(&feed);
+        }
+    }
+    if (feeds.size() < 2) {
+        return;
+    }
+    // ids every variant has got past, a lagging variant holds the others back
+    auto limit = feeds.front()->log->frontier();
+    for (const auto * feed : feeds) {
+        limit = std::min(limit, feed->log->frontier());
+    }
+    std::vector<uint64_t> ids;
+    for (const auto * feed : feeds) {
+        feed->log->collect_ids(endpoint.last_sampled_id, limit, ids);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<uint64_t> arrivals(feeds.size());
+    for (const auto id : ids) {
+        for (size_t i = 0; i < feeds.size(); ++i) {
+            arrivals[i] = feeds[i]->log->covered_at(id);
+        }
+        if (std::find(arrivals.begin(), arrivals.end(), 0) != arrivals.end()) {
+            continue; // before a log started or already out of it
+        }
+        const auto first = *std::min_element(arrivals.begin(), arrivals.end());
+        for (size_t i = 0; i < feeds.size(); ++i) {
+            feeds[i]->lag.add(tsc::to_ns(arrivals[i] - first) / 1000);
+            feeds[i]->firsts += arrivals[i] == first;
+        }
+    }
+    endpoint.last_sampled_id = std::max(endpoint.last_sampled_id, limit);
+}
+
+std::string StreamComparison::report()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const auto seconds = std::max(std::chrono::duration<double>(now - m_last_report).count(), 1e-3);
+    const std::chrono::seconds window(std::clamp<int64_t>(static_cast<int64_t>(std::ceil(seconds)), 1, 300));
+    m_last_report = now;
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "Stream comparison over the last " << seconds << "s:\n";
+    for (auto & endpoint : m_endpoints) {
+        measure_lags(endpoint);
+        oss << endpoint.label << ":\n";
+        for (auto & feed : endpoint.feeds) {
+            const auto metrics = feed.listener->get_metrics().snapshot();
+            const auto cpu_time = feed.connector->get_cpu_time();
+            const auto transport = feed.connector->get_transport_statistics();
+            const auto messages = metrics.messages - feed.last_metrics.messages;
+            const auto bytes = metrics.bytes - feed.last_metrics.bytes;
+            const auto cpu_us = std::chrono::duration<double, std::micro>(cpu_time - feed.last_cpu_time).count();
+            TransportStatistics period;
+            period.messages = transport.messages - feed.last_transport.messages;
+            period.payload_bytes = transport.payload_bytes - feed.last_transport.payload_bytes;
+            period.wire_bytes = transport.wire_bytes - feed.last_transport.wire_bytes;
+            period.decode_time = transport.decode_time - feed.last_transport.decode_time;
+            const auto summary = feed.listener->get_window_summary(window);
+
+            oss << std::setw(30) << feed.name << ": " << (feed.connector->is_running() ? "" : "[down] ")
+                << std::setw(8) << messages / seconds << " msg/s, "
+                << std::setw(8) << bytes / seconds / 1024 << " KB/s, "
+                << std::setw(8) << period.wire_bytes / seconds / 1024 << " KB/s wire (" << std::setw(5) << 100 * period.saved() << "% saved), "
+                << std::setw(6) << (messages ? cpu_us / messages : 0.0) << "us cpu/msg, "
+                << std::setw(6) << period.decode_time_per_message().count() << "us ws/msg, ";
+            if (summary.timed) {
+                oss << "latency p50: " << std::setw(7) << summary.p50_us << "us, p99: " << std::setw(7) << summary.p99_us << "us";
+            } else {
+                oss << "no event time";
+            }
+            if (feed.lag.count()) {
+                oss << ", lag p50: " << std::setw(7) << feed.lag.percentile(0.5) << "us, p99: " << std::setw(7) << feed.lag.percentile(0.99)
+                    << "us, first: " << std::setw(3) << static_cast<int>(100.0 * feed.firsts / feed.lag.count() + 0.5) << "%";
+            }
+            oss << "\n";
+
+            feed.last_metrics = metrics;
+            feed.last_cpu_time = cpu_time;
+            feed.last_transport = transport;
+            feed.lag.clear();
+            feed.firsts = 0;
+        }
+    }
+    return std::move(oss).str();
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ArrivalLog.h"
+#include "CpuAffinity.h"
+#include "EndpointDiscovery.h"
+#include "IConnector.h"
+#include "IJsonDataListener.h"
+#include "IoBackend.h"
+#include "IPAddress.h"
+#include "LatencyHistogram.h"
+#include "OrderBook.h"
+#include "StreamType.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace binance {
+
+// Experiment mode telling which stream variant is the best feed. Every
+// endpoint receives each variant over its own connection, and variants
+// are compared on the same endpoint, so the network path is the same.
+// With several transports, io backends or compression on and off, every
+// variant is received through each of them, which compares transports on
+// the same traffic the same way.
+//
+// A report has, per variant since the previous report:
+//  - messages and payload bytes per second, and bytes of websocket frames
+//    per second with the share compression kept off the wire
+//  - CPU time of the connector thread per message, it covers TLS,
+//    websocket, parsing and the order book, and the websocket part alone,
+//    which includes inflating of compressed messages
+//  - latency from the exchange's event time, if the variant carries one
+//  - lag of order book changes: for every update id, the time since the
+//    first variant delivered it, measured on the local clock only. It
+//    covers variants without event time and does not depend on clock
+//    synchronisation. Trade streams have their own ids and no lag.
+class StreamComparison
+{
+public:
+    struct Transport
+    {
+        IoBackend backend = IoBackend::Epoll;
+        bool compression = false;
+
+        std::string name() const { return std::string(to_string(backend)) + (compression ? "+deflate" : ""); }
+    };
+
+    // Settings every connector of the comparison gets, the same as of a ranking run
+    struct ConnectorOptions
+    {
+        size_t reconnect_attempts = 0;
+        bool kernel_tls = false;
+        std::shared_ptr<affinity::CpuPool> cpu_pool; // threads float if empty
+    };
+
+    StreamComparison(const std::vector<StreamEndpoint> & endpoints, const std::vector<std::string> & tickers,
+                     const std::vector<StreamVariant> & variants, const std::vector<Transport> & transports,
+                     bool build_order_book, const OrderBookConfig & book_config, const ConnectorOptions & options);
+    ~StreamComparison();
+
+    void start();
+    void stop();
+
+    bool is_running() const;
+
+    std::string report();
+
+private:
+    struct Feed
+    {
+        StreamVariant variant;
+        std::string name; // of the variant, and of the transport if there are several
+        std::shared_ptr<IConnector> connector;
+        JsonDataListenerPtr listener;
+        std::shared_ptr<ArrivalLog> log; // book streams only
+        ListenerMetrics::Snapshot last_metrics;
+        std::chrono::nanoseconds last_cpu_time{0};
+        TransportStatistics last_transport;
+        LatencyHistogram lag;
+        uint64_t firsts = 0;
+    };
+
+    struct Endpoint
+    {
+        std::string label;
+        std::vector<Feed> feeds;
+        uint64_t last_sampled_id = 0;
+    };
+
+    static void measure_lags(Endpoint & endpoint);
+
+private:
+    std::vector<Endpoint> m_endpoints;
+    std::chrono::steady_clock::time_point m_last_report;
+};
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace binance {
+
+enum class StreamType
+{
+    Depth,        // <symbol>@depth, diffs of the whole book
+    PartialDepth, // <symbol>@depth<levels>, snapshots of the top levels, no event time on spot
+    BookTicker,   // <symbol>@bookTicker, best bid and ask on every change, no event time on spot
+    Trade,        // <symbol>@trade, every trade
+    AggTrade,     // <symbol>@aggTrade, trades of one taker order aggregated
+};
+
+// Name as in the stream name, e.g. "bookTicker"
+inline const char * to_string(const StreamType t)
+{
+    switch (t) {
+    case StreamType::Depth: return "depth";
+    case StreamType::PartialDepth: return "partialDepth";
+    case StreamType::BookTicker: return "bookTicker";
+    case StreamType::Trade: return "trade";
+    case StreamType::AggTrade: return "aggTrade";
+    }
+    return "unknown";
+}
+
+inline std::ostream & operator<< (std::ostream & strm, const StreamType t) { return strm << to_string(t); }
+
+// Throws std::invalid_argument for an unknown name; partial depth needs
+// its levels, it is parsed by parse_stream_variant() only
+inline StreamType parse_stream_type(const std::string_view name)
+{
+    for (const auto t : {StreamType::Depth, StreamType::BookTicker, StreamType::Trade, StreamType::AggTrade}) {
+        if (name == to_string(t)) {
+            return t;
+        }
+    }
+    throw std::invalid_argument("unknown stream type: " + std::string(name));
+}
+
+// Trade streams carry no book, there is nothing to build from them
+inline bool has_book(const StreamType t)
+{
+    return t == StreamType::Depth || t == StreamType::PartialDepth || t == StreamType::BookTicker;
+}
+
+// A stream as it is subscribed, e.g. depth20@100ms
+struct StreamVariant
+{
+    StreamVariant(const StreamType t = StreamType::Depth, const size_t levels_num = 0, const bool fast = false)
+        : type(t)
+        , levels(levels_num)
+        , every_100ms(fast)
+    { }
+
+    StreamType type;
+    size_t levels;    // of partial depth: 5, 10 or 20
+    bool every_100ms; // depth streams only, they update every second otherwise
+
+    // Stream name without the symbol, e.g. "depth@100ms"
+    std::string name() const
+    {
+        auto ret = type == StreamType::PartialDepth ? "depth" + std::to_string(levels) : std::string(to_string(type));
+        return every_100ms ? ret + "@100ms" : ret;
+    }
+
+    friend std::ostream & operator<< (std::ostream & strm, const StreamVariant & v) { return strm << v.name(); }
+};
+
+// E.g. "depth", "depth@100ms", "depth20@100ms", "bookTicker"; throws std::invalid_argument otherwise
+inline StreamVariant parse_stream_variant(const std::string_view name)
+{
+    const auto at = name.find('@');
+    const auto base = name.substr(0, at);
+    const auto speed = at == std::string_view::npos ? std::string_view() : name.substr(at + 1);
+    StreamVariant ret;
+    if (base == "depth5" || base == "depth10" || base == "depth20") {
+        ret.type = StreamType::PartialDepth;
+        ret.levels = std::stoul(std::string(base.substr(5)));
+    } else {
+        ret.type = parse_stream_type(base);
+    }
+    if (speed == "100ms" && (ret.type == StreamType::Depth || ret.type == StreamType::PartialDepth)) {
+        ret.every_100ms = true;
+    } else if (!speed.empty() && speed != "1000ms") {
+        throw std::invalid_argument("unknown update speed of stream: " + std::string(name));
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Interns exchange symbols into dense ids 0..size()-1. A symbol is packed
+// into two zero padded 64-bit words, so a lookup mixes and compares two
+// integers instead of hashing a string. The open addressing table is kept
+// at most half full, a lookup usually touches one slot.
+class SymbolTable
+{
+public:
+    using Id = uint32_t;
+    static constexpr Id npos = static_cast<Id>(-1);
+    static constexpr size_t max_length = 16; // exchange tickers are well below that
+
+    // Returns the id of symbol, adding it if needed; throws std::invalid_argument if symbol is empty or too long
+    Id intern(const std::string_view symbol)
+    {
+        if (symbol.empty() || symbol.size() > max_length) {
+            throw std::invalid_argument("symbol must have 1 to 16 characters: " + std::string(symbol));
+        }
+        if (const auto id = find(symbol); id != npos) {
+            return id;
+        }
+        if ((m_names.size() + 1) * 2 > m_slots.size()) {
+            rehash(std::max<size_t>(16, m_slots.size() * 2));
+        }
+        const auto id = static_cast<Id>(m_names.size());
+        m_names.emplace_back(symbol);
+        insert(make_key(symbol), id);
+        return id;
+    }
+
+    Id find(const std::string_view symbol) const
+    {
+        if (m_slots.empty() || symbol.empty() || symbol.size() > max_length) {
+            return npos;
+        }
+        const auto key = make_key(symbol);
+        const auto mask = m_slots.size() - 1;
+        for (auto idx = hash(key) & mask; ; idx = (idx + 1) & mask) {
+            const auto & slot = m_slots[idx];
+            if (slot.id == npos) {
+                return npos;
+            }
+            if (slot.key == key) {
+                return slot.id;
+            }
+        }
+    }
+
+    const std::string & name(const Id id) const { return m_names[id]; }
+    size_t size() const { return m_names.size(); }
+    bool empty() const { return m_names.empty(); }
+
+private:
+    struct Key
+    {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+
+        bool operator== (const Key & other) const { return lo == other.lo && hi == other.hi; }
+    };
+
+    struct Slot
+    {
+        Key key;
+        Id id = npos;
+    };
+
+    static Key make_key(const std::string_view symbol)
+    {
+        char buf[max_length] = {};
+        std::memcpy(buf, symbol.data(), symbol.size());
+        Key ret;
+        std::memcpy(&ret.lo, buf, sizeof(ret.lo));
+        std::memcpy(&ret.hi, buf + sizeof(ret.lo), sizeof(ret.hi));
+        return ret;
+    }
+
+    static size_t hash(const Key & key)
+    {
+        const auto h = (key.lo ^ (key.hi * 0xc2b2ae3d27d4eb4fULL)) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    void insert(const Key & key, const Id id)
+    {
+        const auto mask = m_slots.size() - 1;
+        auto idx = hash(key) & mask;
+        while (m_slots[idx].id != npos) {
+            idx = (idx + 1) & mask;
+        }
+        m_slots[idx] = {key, id};
+    }
+
+    void rehash(const size_t capacity)
+    {
+        m_slots.assign(capacity, Slot());
+        for (size_t id = 0; id < m_names.size(); ++id) {
+            insert(make_key(m_names[id]), static_cast<Id>(id));
+        }
+    }
+
+private:
+    std::vector<Slot> m_slots;
+    std::vector<std::string> m_names;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "PipelineTrace.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+
+#include <type_traits>
+#include <utility>
+
+// Transparent stream layer remembering when its last read completed, stacked
+// under TLS and under websocket to split the time between these layers.
+template <class NextLayer>
+class TimestampingStream
+{
+    template <class Handler>
+    struct StampingHandler
+    {
+        using executor_type = boost::asio::associated_executor_t<Handler, typename std::remove_reference_t<NextLayer>::executor_type>;
+        using allocator_type = boost::asio::associated_allocator_t<Handler>;
+
+        void operator()(const boost::system::error_code & ec, const std::size_t size)
+        {
+            stamp = tsc::now();
+            handler(ec, size);
+        }
+
+        executor_type get_executor() const noexcept { return boost::asio::get_associated_executor(handler, executor); }
+        allocator_type get_allocator() const noexcept { return boost::asio::get_associated_allocator(handler); }
+
+        Handler handler;
+        typename std::remove_reference_t<NextLayer>::executor_type executor;
+        uint64_t & stamp;
+    };
+
+public:
+    using next_layer_type = std::remove_reference_t<NextLayer>;
+    using lowest_layer_type = typename next_layer_type::lowest_layer_type;
+    using executor_type = typename next_layer_type::executor_type;
+
+    template <class... Args>
+    explicit TimestampingStream(Args &&... args)
+        : m_next(std::forward<Args>(args)...)
+    { }
+
+    executor_type get_executor() noexcept { return m_next.get_executor(); }
+
+    next_layer_type & next_layer() { return m_next; }
+    const next_layer_type & next_layer() const { return m_next; }
+    lowest_layer_type & lowest_layer() { return m_next.lowest_layer(); }
+    const lowest_layer_type & lowest_layer() const { return m_next.lowest_layer(); }
+
+    uint64_t get_last_read_ticks() const { return m_last_read; }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        const auto ret = m_next.read_some(buffers, ec);
+        m_last_read = tsc::now();
+        return ret;
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers)
+    {
+        const auto ret = m_next.read_some(buffers);
+        m_last_read = tsc::now();
+        return ret;
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        return m_next.write_some(buffers, ec);
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers)
+    {
+        return m_next.write_some(buffers);
+    }
+
+    template <class MutableBufferSequence, class ReadToken>
+    auto async_read_some(const MutableBufferSequence & buffers, ReadToken && token)
+    {
+        return boost::asio::async_initiate<ReadToken, void(boost::system::error_code, std::size_t)>(
+            [this] (auto handler, const MutableBufferSequence & buffers) {
+                using Handler = std::decay_t<decltype(handler)>;
+                m_next.async_read_some(buffers, StampingHandler<Handler>{std::move(handler), m_next.get_executor(), m_last_read});
+            }, token, buffers);
+    }
+
+    template <class ConstBufferSequence, class WriteToken>
+    auto async_write_some(const ConstBufferSequence & buffers, WriteToken && token)
+    {
+        return m_next.async_write_some(buffers, std::forward<WriteToken>(token));
+    }
+
+private:
+    NextLayer m_next;
+    uint64_t m_last_read = 0;
+};
+
+template <class NextLayer>
+void teardown(const boost::beast::role_type role, TimestampingStream<NextLayer> & stream, boost::system::error_code & ec)
+{
+    using boost::beast::websocket::teardown;
+    teardown(role, stream.next_layer(), ec);
+}
+
+template <class NextLayer, class TeardownHandler>
+void async_teardown(const boost::beast::role_type role, TimestampingStream<NextLayer> & stream, TeardownHandler && handler)
+{
+    using boost::beast::websocket::async_teardown;
+    async_teardown(role, stream.next_layer(), std::forward<TeardownHandler>(handler));
+}
+
+// Layers are stacked only when tracing is enabled, otherwise the aliases
+// resolve to the plain streams and read ticks are constant zero.
+#ifdef ENABLE_PIPELINE_TRACE
+template <class Stream>
+using TracedStream = TimestampingStream<Stream>;
+
+template <class Stream>
+auto & untraced(TimestampingStream<Stream> & stream) { return stream.next_layer(); }
+
+template <class Stream>
+uint64_t last_read_ticks(const TimestampingStream<Stream> & stream) { return stream.get_last_read_ticks(); }
+#else
+template <class Stream>
+using TracedStream = Stream;
+
+template <class Stream>
+Stream & untraced(Stream & stream) { return stream; }
+
+template <class Stream>
+constexpr uint64_t last_read_ticks(const Stream &) { return 0; }
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Cheap timestamps for hot path measurements. Raw ticks are only meant
+// to be subtracted from each other; conversion to nanoseconds goes through
+// a one-off calibration against steady_clock, so convert on reporting side.
+namespace tsc {
+
+inline uint64_t now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline double ticks_per_ns()
+{
+    static const double value = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        const auto start_ts = std::chrono::steady_clock::now();
+        const auto start = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const auto ticks = now() - start;
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_ts).count();
+        return ns > 0 ? static_cast<double>(ticks) / ns : 1.0;
+#else
+        return 1.0;
+#endif
+    }();
+    return value;
+}
+
+inline uint64_t to_ns(const uint64_t ticks)
+{
+    return static_cast<uint64_t>(ticks / ticks_per_ns());
+}
+
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "IoUring.h"
+
+#include <boost/asio.hpp>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Layer over a socket which, once given a uring::Receiver, reads through
+// its ring instead of recv(). A wakeup is a poll of the ring fd by the
+// io_context, taking the bytes costs no system call. Writes and connect go
+// to the socket as before.
+template <class NextLayer>
+class UringStream
+{
+public:
+    using next_layer_type = std::remove_reference_t<NextLayer>;
+    using lowest_layer_type = typename next_layer_type::lowest_layer_type;
+    using executor_type = typename next_layer_type::executor_type;
+
+    template <class... Args>
+    explicit UringStream(Args &&... args)
+        : m_next(std::forward<Args>(args)...)
+        , m_ring(m_next.get_executor())
+    { }
+
+    ~UringStream()
+    {
+        if (m_receiver) {
+            m_ring.release(); // the receiver closes it
+        }
+    }
+
+    executor_type get_executor() noexcept { return m_next.get_executor(); }
+
+    next_layer_type & next_layer() { return m_next; }
+    const next_layer_type & next_layer() const { return m_next; }
+    lowest_layer_type & lowest_layer() { return m_next.lowest_layer(); }
+    const lowest_layer_type & lowest_layer() const { return m_next.lowest_layer(); }
+
+    // Reads go through the ring from now on, must be called before the first one
+    void set_receiver(std::unique_ptr<uring::Receiver> receiver)
+    {
+        m_receiver = std::move(receiver);
+        m_ring.assign(m_receiver->fd());
+    }
+    bool is_uring() const { return m_receiver != nullptr; }
+
+    // Closing the socket does not end a receive armed in the ring, a read
+    // waiting on the ring fails with operation_aborted then
+    void close(boost::system::error_code & ec)
+    {
+        if (m_receiver) {
+            m_closed = true;
+            boost::system::error_code ignored;
+            m_next.shutdown(boost::asio::socket_base::shutdown_both, ignored);
+            m_ring.cancel(ignored);
+        }
+        m_next.close(ec);
+    }
+
+    // Blocks unless the socket is in non-blocking mode, as asio sockets do
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        if (!m_receiver) {
+            return m_next.read_some(buffers, ec);
+        }
+        for (;;) {
+            const auto ret = receive(buffers, ec);
+            if (ec != boost::asio::error::would_block || m_next.non_blocking()) {
+                return ret;
+            }
+            m_ring.wait(boost::asio::posix::descriptor_base::wait_read, ec);
+            if (ec) {
+                return 0;
+            }
+        }
+    }
+
+    template <class MutableBufferSequence>
+    std::size_t read_some(const MutableBufferSequence & buffers)
+    {
+        boost::system::error_code ec;
+        const auto ret = read_some(buffers, ec);
+        if (ec) {
+            throw boost::system::system_error(ec);
+        }
+        return ret;
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        return m_next.write_some(buffers, ec);
+    }
+
+    template <class ConstBufferSequence>
+    std::size_t write_some(const ConstBufferSequence & buffers)
+    {
+        return m_next.write_some(buffers);
+    }
+
+    template <class MutableBufferSequence, class ReadToken>
+    auto async_read_some(const MutableBufferSequence & buffers, ReadToken && token)
+    {
+        return boost::asio::async_initiate<ReadToken, void(boost::system::error_code, std::size_t)>(
+            [this] (auto handler, const MutableBufferSequence & buffers) {
+                if (!m_receiver) {
+                    m_next.async_read_some(buffers, std::move(handler));
+                    return;
+                }
+                enum class State { Start, Posted, Waiting };
+                boost::asio::async_compose<decltype(handler), void(boost::system::error_code, std::size_t)>(
+                    [this, buffers, state = State::Start, result = std::size_t(0), error = boost::system::error_code()]
+                    (auto & self, boost::system::error_code ec = {}) mutable {
+                        if (state == State::Posted) {
+                            return self.complete(error, result);
+                        }
+                        if (state == State::Waiting) {
+                            if (m_closed) {
+                                return self.complete(boost::asio::error::operation_aborted, 0);
+                            }
+                            // operation_aborted is also a wakeup, see below
+                            if (ec && ec != boost::asio::error::operation_aborted) {
+                                return self.complete(ec, 0);
+                            }
+                        }
+                        const auto size = receive(buffers, ec);
+                        if (ec != boost::asio::error::would_block) {
+                            if (state == State::Start) {
+                                // must not complete inside the initiating function
+                                state = State::Posted;
+                                result = size;
+                                error = ec;
+                                return boost::asio::post(m_next.get_executor(), std::move(self));
+                            }
+                            return self.complete(ec, size);
+                        }
+                        state = State::Waiting;
+                        m_ring.async_wait(boost::asio::posix::descriptor_base::wait_read, std::move(self));
+                        // the reactor is edge triggered, a completion which came after the receive
+                        // above and before the wait would not wake it up; cancelling does instead
+                        if (m_receiver->ready()) {
+                            m_ring.cancel(ec);
+                        }
+                    }, handler, m_next);
+            }, token, buffers);
+    }
+
+    template <class ConstBufferSequence, class WriteToken>
+    auto async_write_some(const ConstBufferSequence & buffers, WriteToken && token)
+    {
+        return m_next.async_write_some(buffers, std::forward<WriteToken>(token));
+    }
+
+private:
+    template <class MutableBufferSequence>
+    std::size_t receive(const MutableBufferSequence & buffers, boost::system::error_code & ec)
+    {
+        // armed on the first read, the socket is connected by then
+        if (!m_receiver->is_started()) {
+            m_receiver->start(m_next.native_handle(), ec);
+            if (ec) {
+                return 0;
+            }
+        }
+        const boost::asio::mutable_buffer buffer = *boost::asio::buffer_sequence_begin(buffers);
+        return m_receiver->receive(buffer.data(), buffer.size(), ec);
+    }
+
+private:
+    NextLayer m_next;
+    boost::asio::posix::stream_descriptor m_ring;
+    std::unique_ptr<uring::Receiver> m_receiver;
+    bool m_closed = false;
+};
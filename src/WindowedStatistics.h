@@ -0,0 +1,156 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+struct WindowSummary
+{
+    uint64_t count = 0;
+    uint64_t timed = 0; // updates with event time, percentiles come from these only
+    uint64_t p50_us = 0;
+    uint64_t p99_us = 0;
+    uint64_t avg_us = 0;
+    double win_rate = 0; // share of updates this listener delivered first
+
+    bool empty() const { return count == 0; }
+
+    friend std::ostream & operator<< (std::ostream & strm, const WindowSummary & s)
+    {
+        if (s.empty()) {
+            return strm << "<empty>";
+        }
+        if (!s.timed) {
+            return strm << "no event time, wins: " << std::setw(3) << static_cast<int>(s.win_rate * 100 + 0.5) << "%";
+        }
+        return strm << "p50: " << std::setw(7) << s.p50_us << "us, p99: " << std::setw(7) << s.p99_us << "us, wins: "
+                    << std::setw(3) << static_cast<int>(s.win_rate * 100 + 0.5) << "%";
+    }
+};
+
+// Latency histograms and win counters over sliding windows of up to five
+// minutes. Values go to rings of time slots, a slot is reset when the ring
+// comes around to it again, so old history simply falls out. Windows up to a
+// minute are served by one second slots, longer ones by ten second slots,
+// which keeps the memory per listener at about a hundred histograms.
+class WindowedStatistics
+{
+    class Ring
+    {
+        struct Slot
+        {
+            int64_t epoch = -1;
+            LatencyHistogram latency;
+            uint64_t arrivals = 0;
+            uint64_t wins = 0;
+        };
+
+    public:
+        Ring(const int64_t slot_seconds, const size_t slots_num)
+            : m_slot_seconds(slot_seconds)
+            , m_slots(slots_num)
+        { }
+
+        int64_t span() const { return m_slot_seconds * static_cast<int64_t>(m_slots.size() - 1); }
+
+        void add(const int64_t now_s, const uint64_t latency_us, const bool won)
+        {
+            auto & slot = arrive(now_s, won);
+            slot.latency.add(latency_us);
+        }
+
+        Slot & arrive(const int64_t now_s, const bool won)
+        {
+            const auto epoch = now_s / m_slot_seconds;
+            auto & slot = m_slots[epoch % m_slots.size()];
+            if (slot.epoch != epoch) {
+                slot.epoch = epoch;
+                slot.latency.clear();
+                slot.arrivals = 0;
+                slot.wins = 0;
+            }
+            ++slot.arrivals;
+            slot.wins += won;
+            return slot;
+        }
+
+        void collect(const int64_t now_s, const int64_t window_s, LatencyHistogram & latency, uint64_t & arrivals, uint64_t & wins) const
+        {
+            const auto current = now_s / m_slot_seconds;
+            const auto slots = std::min<int64_t>((window_s + m_slot_seconds - 1) / m_slot_seconds, m_slots.size() - 1);
+            for (auto epoch = current - slots + 1; epoch <= current; ++epoch) {
+                const auto & slot = m_slots[epoch % m_slots.size()];
+                if (slot.epoch == epoch) {
+                    latency.merge(slot.latency);
+                    arrivals += slot.arrivals;
+                    wins += slot.wins;
+                }
+            }
+        }
+
+    private:
+        int64_t m_slot_seconds;
+        std::vector<Slot> m_slots;
+    };
+
+public:
+    using Clock = std::chrono::system_clock;
+
+    void add(const Clock::time_point now, const std::chrono::microseconds latency, const bool won)
+    {
+        const auto now_s = seconds(now);
+        const auto us = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+        m_fine.add(now_s, us, won);
+        m_coarse.add(now_s, us, won);
+    }
+
+    // Update without event time, it only counts for the win rate
+    void add(const Clock::time_point now, const bool won)
+    {
+        const auto now_s = seconds(now);
+        m_fine.arrive(now_s, won);
+        m_coarse.arrive(now_s, won);
+    }
+
+    WindowSummary summary(const std::chrono::seconds window, const Clock::time_point now = Clock::now()) const
+    {
+        LatencyHistogram latency;
+        uint64_t arrivals = 0;
+        uint64_t wins = 0;
+        const auto window_s = static_cast<int64_t>(window.count());
+        (window_s <= m_fine.span() ? m_fine : m_coarse).collect(seconds(now), window_s, latency, arrivals, wins);
+
+        WindowSummary ret;
+        ret.count = arrivals;
+        ret.timed = latency.count();
+        if (ret.timed) {
+            ret.p50_us = latency.percentile(0.5);
+            ret.p99_us = latency.percentile(0.99);
+            ret.avg_us = latency.avg();
+        }
+        if (ret.count) {
+            ret.win_rate = static_cast<double>(wins) / ret.count;
+        }
+        return ret;
+    }
+
+    void clear()
+    {
+        *this = WindowedStatistics();
+    }
+
+private:
+    static int64_t seconds(const Clock::time_point tp)
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+    }
+
+private:
+    Ring m_fine{1, 61};
+    Ring m_coarse{10, 31};
+};
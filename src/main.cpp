@@ -1,40 +1,117 @@
 #include <iostream>
 
 #include "BinanceIncDepthProcessor.h"
+#include "BinanceTopOfBookProcessor.h"
+#include "StreamComparison.h"
+#include "BookDeltaPublisher.h"
 #include "BinanceWebSocketConnector.h"
+#include "CpuAffinity.h"
 #include "DNSLookup.h"
+#include "EndpointDiscovery.h"
+#include "FeedWatchdog.h"
 #include "Helpers.h"
+#include "IpFamily.h"
 #include "Log.h"
+#include "MetricsServer.h"
+#include "OrderBookRenderer.h"
+#include "RankingPolicy.h"
+#include "ShmOrderBookPublisher.h"
 
 #include <boost/program_options.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <csignal>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 #include <thread>
-#include <tuple>
 
 namespace po = boost::program_options;
 
+namespace {
+
+constexpr size_t max_symbols_to_show = 10;
+
+}
+
 int main(int argc, char ** argv)
 {
-    std::string ticker = "BTCUSDT";
+    std::vector<std::string> tickers;
+    std::string stream = "depth";
+    std::vector<std::string> compare_streams;
     int64_t delay_ms = 5000;
     bool with_order_book = true;
     size_t max_ob_levels_to_show = -1;
+    bool order_book_diff = false;
+    OrderBookConfig book_config;
     std::string domain = "stream.binance.com";
     Port port = 9443;
+    std::vector<std::string> endpoint_names;
+    std::vector<IPAddress> static_ips;
+    std::string ip_family_name = "v4";
+    IPAddress metrics_address = "127.0.0.1";
+    Port metrics_port = 0;
+    std::string shm_name;
+    size_t shm_depth = 20;
+    std::string delta_output;
+    size_t delta_keyframe_interval = 1000;
+    int64_t stale_timeout_ms = 5000;
+    size_t reconnect_attempts = 0;
+    bool kernel_tls = false;
+    std::string io_backend_name = "epoll";
+    std::vector<std::string> compare_io_backends;
+    bool compression = false;
+    bool compare_compression = false;
+    std::string cpus;
+    std::string rank_by = "p99";
+    int64_t rank_window_s = 60;
+    double rank_hysteresis = 0.1;
 
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help", "produce help message")
-        ("ticker", po::value<std::string>(&ticker)->default_value("BTCUSDT"), "set ticker")
+        ("ticker", po::value<std::vector<std::string>>(&tickers)->multitoken()->default_value({"BTCUSDT"}, "BTCUSDT"),
+            "set tickers, several ones are received through one combined stream, the first one is published and shown")
+        ("stream", po::value<std::string>(&stream)->default_value("depth"),
+            "set stream to measure: depth, depth@100ms, depth<5|10|20>[@100ms], bookTicker, trade or aggTrade; bookTicker keeps only the best bid and ask, trades build no order book")
+        ("compare-streams", po::value<std::vector<std::string>>(&compare_streams)->multitoken(),
+            "instead of ranking IPs, receive given streams from every IP at once and report their latency, bytes/s and CPU per message, e.g. depth depth@100ms depth20@100ms bookTicker")
+        ("compare-io-backends", po::value<std::vector<std::string>>(&compare_io_backends)->multitoken(),
+            "receive every compared stream, or --stream, through each of given io backends at once, e.g. epoll io_uring")
+        ("compare-compression", po::value<bool>(&compare_compression)->default_value(false),
+            "receive every compared stream, or --stream, both with and without permessage-deflate at once")
         ("period", po::value<int64_t>(&delay_ms)->default_value(5000), "set period between statistics output")
         ("with-orderbook", po::value<bool>(&with_order_book)->default_value(true), "prints order book from the best listener")
         ("show-orderbook-levels-num", po::value<size_t>(&max_ob_levels_to_show)->default_value(-1), "set number of levels for orderbook to output, default -1, i.e. all")
+        ("orderbook-diff", po::value<bool>(&order_book_diff)->default_value(false), "prints only order book rows changed since the previous output")
+        ("book-reserve", po::value<size_t>(&book_config.reserved_depth)->default_value(5000), "set number of levels per side allocated up front")
+        ("book-max-depth", po::value<size_t>(&book_config.max_depth)->default_value(0), "keep only given number of top levels per side in the hot order book, deeper ones go to a cold store, 0 keeps all")
+        ("analytics-depth", po::value<size_t>(&book_config.analytics_depth)->default_value(10), "set number of top levels per side for imbalance and VWAP of the best listener's book, 0 disables analytics")
         ("host", po::value<std::string>(&domain)->default_value("stream.binance.com"), "set host to connect")
         ("port", po::value<Port>(&port)->default_value(9443), "set port to connect")
+        ("endpoints", po::value<std::vector<std::string>>(&endpoint_names)->multitoken(),
+            "resolve hosts of given host:port pairs instead of --host and --port and rank all their IPs together, an IP several hosts resolve to is measured once per port, e.g. stream.binance.com:443 data-stream.binance.vision:443")
+        ("ip", po::value<std::vector<IPAddress>>(&static_ips)->multitoken(), "connect to given IPs on --port instead of resolving hosts, e.g. to binance_stub_server")
+        ("ip-family", po::value<std::string>(&ip_family_name)->default_value("v4"),
+            "set address family of IPs to measure: any, v4 or v6; with any, IPv4 and IPv6 paths are measured side by side")
+        ("metrics-address", po::value<IPAddress>(&metrics_address)->default_value("127.0.0.1"), "set address to serve OpenMetrics on")
+        ("metrics-port", po::value<Port>(&metrics_port)->default_value(0), "set port to serve OpenMetrics on, 0 disables it")
+        ("shm-name", po::value<std::string>(&shm_name), "publish order book of the best listener to POSIX shared memory with given name, e.g. /binance_btcusdt")
+        ("shm-depth", po::value<size_t>(&shm_depth)->default_value(20), "set number of levels per side to publish to shared memory, at most --book-max-depth if that is set")
+        ("delta-output", po::value<std::string>(&delta_output), "write binary order book deltas of the best listener to given file or FIFO")
+        ("delta-keyframe-interval", po::value<size_t>(&delta_keyframe_interval)->default_value(1000), "set number of delta frames between full order book keyframes")
+        ("stale-timeout", po::value<int64_t>(&stale_timeout_ms)->default_value(5000), "set silence in milliseconds after which a feed is stale and not ranked, 0 disables it")
+        ("reconnect-attempts", po::value<size_t>(&reconnect_attempts)->default_value(0), "set number of failed connections in a row to retry, 0 stops listening to an IP on its first failure")
+        ("kernel-tls", po::value<bool>(&kernel_tls)->default_value(false), "decrypt received TLS 1.3 records in the kernel (Linux kTLS), falls back to OpenSSL if it is not available")
+        ("compression", po::value<bool>(&compression)->default_value(false), "offer permessage-deflate compression, messages are inflated if the server takes it")
+        ("io-backend", po::value<std::string>(&io_backend_name)->default_value("epoll"), "set how connections receive: epoll or io_uring (Linux 6.0+, multishot receive into registered buffers), falls back to epoll if io_uring is not allowed")
+        ("cpus", po::value<std::string>(&cpus),
+            "pin connector threads to given CPUs, e.g. 2-5,8, the least used one each; auto spreads them over isolated cores, or all allowed CPUs without isolcpus, and moves each next to the CPU its packets are received on")
+        ("rank-by", po::value<std::string>(&rank_by)->default_value("p99"), "set ranking policy of listeners: p99, median, avg or win-rate")
+        ("rank-window", po::value<int64_t>(&rank_window_s)->default_value(60), "set window in seconds the ranking looks at, up to 300")
+        ("rank-hysteresis", po::value<double>(&rank_hysteresis)->default_value(0.1), "set share by which a listener must beat the current best one to replace it")
 
         ;
 
@@ -47,91 +124,341 @@ int main(int argc, char ** argv)
         return 1;
     }
 
+    // events carry symbols upper case
+    for (auto & t : tickers) {
+        std::transform(t.begin(), t.end(), t.begin(), [] (const unsigned char c) { return std::toupper(c); });
+    }
+
+    std::unique_ptr<IRankingPolicy> ranking_policy;
+    binance::StreamVariant stream_variant;
+    std::vector<binance::StreamVariant> compared_variants;
+    IoBackend io_backend = IoBackend::Epoll;
+    std::vector<IoBackend> compared_backends;
+    IpFamily ip_family = IpFamily::V4;
+    std::vector<HostPort> host_ports;
+    std::shared_ptr<affinity::CpuPool> cpu_pool;
+    try {
+        ranking_policy = make_ranking_policy(rank_by);
+        stream_variant = binance::parse_stream_variant(stream);
+        for (const auto & s : compare_streams) {
+            compared_variants.push_back(binance::parse_stream_variant(s));
+        }
+        io_backend = parse_io_backend(io_backend_name);
+        ip_family = parse_ip_family(ip_family_name);
+        for (const auto & e : endpoint_names) {
+            host_ports.push_back(parse_host_port(e));
+        }
+        if (host_ports.empty()) {
+            host_ports.push_back({domain, port});
+        }
+        for (const auto & b : compare_io_backends) {
+            compared_backends.push_back(parse_io_backend(b));
+        }
+        if (cpus == "auto") {
+            auto ids = affinity::isolated_cpus();
+            if (ids.empty()) {
+                ALWAYS_LOG("No isolated cores, connectors are spread over all allowed CPUs");
+                ids = affinity::allowed_cpus();
+            }
+            cpu_pool = std::make_shared<affinity::CpuPool>(affinity::make_cpus(ids), true);
+        } else if (!cpus.empty()) {
+            cpu_pool = std::make_shared<affinity::CpuPool>(affinity::make_cpus(affinity::parse_cpu_list(cpus)), false);
+        }
+    } catch (const std::invalid_argument & e) {
+        ALWAYS_LOG(e.what());
+        return 1;
+    }
+    const auto stream_type = stream_variant.type;
+    if (with_order_book && !binance::has_book(stream_type)) {
+        ALWAYS_LOG("No order book is built from " << stream_type << " stream");
+        with_order_book = false;
+    }
+    if ((stream_type == binance::StreamType::BookTicker || stream_type == binance::StreamType::PartialDepth) && rank_by != "win-rate") {
+        ALWAYS_LOG("Spot " << stream_variant << " carries no event time, consider --rank-by win-rate");
+    }
+
     const auto period = std::chrono::milliseconds(delay_ms);
     ALWAYS_LOG(
         "Configuration:"
-        << "\n Ticker: " << ticker
+        << "\n Tickers: " << SequencePrinter(tickers, ", ")
+        << "\n Stream: " << stream_variant
         << "\n Period: " << period.count() << "ms"
         << "\n Build order book: " << std::boolalpha << with_order_book
         << "\n Max OB levels num to show: " << max_ob_levels_to_show
-        << "\n Host: " << domain
-        << "\n Port: " << port);
+        << "\n Endpoints: " << SequencePrinter(host_ports, ", ")
+        << "\n IP family: " << ip_family
+        << "\n IO backend: " << io_backend
+        << "\n Compression: " << compression);
+
+    std::vector<StreamEndpoint> endpoints;
+    if (static_ips.empty()) {
+        endpoints = discover_endpoints(*create_dns_resolver(), host_ports, ip_family);
+    } else {
+        for (const auto & ip : static_ips) {
+            if (matches(ip_family, ip)) {
+                endpoints.push_back({ip, port, {domain}});
+            }
+        }
+    }
+    // IPs alone are enough to tell endpoints of a single host and port apart
+    const bool single_host = !static_ips.empty() || host_ports.size() == 1;
+    const auto label = [single_host] (const StreamEndpoint & e) { return single_host ? e.ip : e.label(); };
+
+    LOG_LINE("Resolved endpoints [" << endpoints.size() << "]:\n" << SequencePrinter(endpoints, "\n"));
+
+    static std::condition_variable cv;
+    static std::mutex signal_mutex;
+    static bool run = true;
+    std::signal(SIGINT, [] ([[maybe_unused]] const int signal) {
+        std::unique_lock lk(signal_mutex);
+        run = false;
+        cv.notify_one();
+    });
+
+    if (!compared_variants.empty() || !compared_backends.empty() || compare_compression) {
+        if (compared_variants.empty()) {
+            compared_variants.push_back(stream_variant);
+        }
+        if (compared_backends.empty()) {
+            compared_backends.push_back(io_backend);
+        }
+        std::vector<binance::StreamComparison::Transport> transports;
+        for (const auto backend : compared_backends) {
+            if (compare_compression) {
+                transports.push_back({backend, false});
+                transports.push_back({backend, true});
+            } else {
+                transports.push_back({backend, compression});
+            }
+        }
+        binance::StreamComparison comparison(endpoints, tickers, compared_variants, transports, with_order_book, book_config,
+                                             {reconnect_attempts, kernel_tls, cpu_pool});
+        comparison.start();
+        for (;;) {
+            {
+                std::unique_lock lk(signal_mutex); // synchronizes run variable
+                if (cv.wait_for(lk, period, [] { return !run; })) {
+                    break;
+                }
+            }
+            ALWAYS_LOG(comparison.report());
+            if (!comparison.is_running()) {
+                ALWAYS_LOG("All connections are down, time to stop");
+                break;
+            }
+        }
+        ALWAYS_LOG("Stopping comparison");
+        comparison.stop();
+        return 0;
+    }
 
-    const auto dns_lookup = create_dns_resolver();
+    std::vector<std::shared_ptr<BookPublisher>> publishers;
+    if ((!shm_name.empty() || !delta_output.empty()) && !with_order_book) {
+        ALWAYS_LOG("Order book publication requires --with-orderbook=true");
+        return -1;
+    }
+    if (!shm_name.empty() && book_config.max_depth && book_config.max_depth < shm_depth) {
+        // the publisher copies the hot levels only, on every update
+        ALWAYS_LOG("--shm-depth must not exceed --book-max-depth");
+        return -1;
+    }
+    if (!shm_name.empty()) {
+        publishers.push_back(std::make_shared<ShmOrderBookPublisher>(shm_name, shm_depth));
+    }
+    if (!delta_output.empty()) {
+        std::signal(SIGPIPE, SIG_IGN); // a gone reader of a FIFO or socket must not kill us
+        book_delta::EncoderConfig config;
+        config.keyframe_interval = delta_keyframe_interval;
+        publishers.push_back(std::make_shared<BookDeltaPublisher>(delta_output, config));
+    }
 
-    const auto ips = dns_lookup->resolve(domain);
+    std::unique_ptr<FeedWatchdog> watchdog;
+    if (stale_timeout_ms > 0) {
+        watchdog = std::make_unique<FeedWatchdog>(std::chrono::milliseconds(stale_timeout_ms));
+    }
+    const auto log_feed_event = [] (const std::string & name) {
+        return [name] (const IJsonDataListener &, const FeedEvent event) {
+            ALWAYS_LOG("Feed from [" << name << "] is " << event);
+        };
+    };
 
-    LOG_LINE("Resolved IPs [" << ips.size() << "]:\n" << SequencePrinter(ips, "\n"));
+    EndpointRanker ranker(std::move(ranking_policy), std::chrono::seconds(rank_window_s), rank_hysteresis);
+    const auto arrival_race = std::make_shared<ArrivalRace>();
 
-    std::vector<std::pair<std::unique_ptr<IConnector>, DepthDataListenerPtr>> measurers;
-    measurers.reserve(ips.size());
-    for (const auto & ip : ips) {
-        auto listener = std::make_shared<binance::BinanceIncDepthProcessor>(with_order_book);
+    struct Measurer
+    {
+        StreamEndpoint endpoint;
+        std::string label;
+        std::shared_ptr<IConnector> connector;
+        DepthDataListenerPtr listener;
+    };
+    std::vector<Measurer> measurers;
+    measurers.reserve(endpoints.size());
+    for (const auto & endpoint : endpoints) {
+        const auto attach = [&] (auto & processor) {
+            for (const auto & publisher : publishers) {
+                processor.add_publisher(publisher);
+            }
+            processor.set_arrival_race(arrival_race);
+        };
+        DepthDataListenerPtr listener;
+        if (stream_type == binance::StreamType::Depth) {
+            auto processor = std::make_shared<binance::BinanceIncDepthProcessor>(with_order_book, book_config, tickers);
+            attach(*processor);
+            processor->set_event_handler(log_feed_event(label(endpoint)));
+            listener = std::move(processor);
+        } else {
+            auto processor = std::make_shared<binance::BinanceTopOfBookProcessor>(stream_type, with_order_book, book_config, tickers);
+            attach(*processor);
+            listener = std::move(processor);
+        }
+        if (watchdog) {
+            watchdog->add_listener(listener, log_feed_event(label(endpoint)));
+        }
         auto copy_listener = listener;
-        auto & it = measurers.emplace_back(binance::BinanceWebSocketConnector::make_depth_connector(ip, port, ticker, std::move(listener)), std::move(copy_listener));
+        auto connector = binance::BinanceWebSocketConnector::make_connector(endpoint.ip, endpoint.port, tickers, stream_variant, std::move(listener));
+        connector->set_reconnect_attempts(reconnect_attempts);
+        connector->set_kernel_tls(kernel_tls);
+        connector->set_io_backend(io_backend);
+        connector->set_compression(compression);
+        if (cpu_pool) {
+            connector->set_cpu_pool(cpu_pool);
+        }
+        auto & it = measurers.emplace_back(Measurer{endpoint, label(endpoint), std::move(connector), std::move(copy_listener)});
         try {
-            it.first->start();
+            it.connector->start();
         } catch (const std::exception & e) {
-            LOG_LINE("Exception on starting listening to ip [" << ip << "]");
+            LOG_LINE("Exception on starting listening to [" << it.label << "]");
         }
     }
 
     if (measurers.empty()) {
-        ALWAYS_LOG("No IPs detected for " << domain);
+        ALWAYS_LOG("No IPs detected for " << SequencePrinter(host_ports, ", "));
         return -1;
     }
 
-    static std::condition_variable cv;
-    static std::mutex signal_mutex;
-    static bool run = true;
-    std::signal(SIGINT, [] ([[maybe_unused]] const int signal) {
-        std::unique_lock lk(signal_mutex);
-        run = false;
-        cv.notify_one();
-    });
+    if (watchdog) {
+        watchdog->start();
+    }
+
+    std::unique_ptr<MetricsServer> metrics_server;
+    if (metrics_port) {
+        metrics_server = std::make_unique<MetricsServer>(metrics_address, metrics_port);
+        for (const auto & m : measurers) {
+            metrics_server->add_endpoint({m.endpoint.joined_hosts(), m.endpoint.ip, m.endpoint.port, m.connector, m.listener});
+        }
+        metrics_server->start();
+    }
 
-    std::vector<std::tuple<std::string, Statistics, DepthDataListenerPtr>> stats;
+    std::vector<EndpointRanker::Candidate> stats;
     stats.reserve(measurers.size());
+
+    OrderBookRenderer renderer(max_ob_levels_to_show);
     while (run) {
         stats.clear();
         bool any_running = false;
-        for (const auto & [connection, listener] : measurers) {
-            if (connection->is_running()) {
+        for (const auto & m : measurers) {
+            if (m.connector->is_running()) {
                 any_running = true;
-                stats.emplace_back(connection->get_host(), listener->get_statistics(), listener);
+                if (!m.listener->get_metrics().is_silent()) {
+                    stats.push_back({m.label, m.listener->get_statistics(), m.listener->get_window_summary(ranker.get_window()), m.listener,
+                                     m.connector->get_transport_statistics()});
+                }
             }
         }
         if (!any_running) {
             ALWAYS_LOG("All connections are down, time to stop");
             break;
         }
-        std::sort(stats.begin(), stats.end(), [] (const auto & a, const auto & b) {
-            if (std::get<1>(a).empty()) {
-                return false;
+        if (stats.empty()) {
+            ALWAYS_LOG("All feeds are stale, nothing to rank");
+            std::unique_lock lk(signal_mutex);
+            cv.wait_for(lk, std::chrono::milliseconds(delay_ms), [] { return !run; });
+            continue;
+        }
+        const auto best = ranker.rank(stats);
+        if (!publishers.empty() && best < stats.size()) {
+            // the best listener unless its book missed updates, then the next one that did not
+            auto source = stats.begin() + best;
+            if (source->listener->get_metrics().is_stale()) {
+                source = std::find_if(stats.begin(), stats.end(), [] (const auto & c) {
+                    return !c.window.empty() && !c.listener->get_metrics().is_stale();
+                });
             }
-            return std::get<1>(a).get_avg_time() < std::get<1>(b).get_avg_time();
-        });
+            if (source != stats.end()) {
+                for (const auto & publisher : publishers) {
+                    publisher->set_source(source->listener.get(), source->host);
+                }
+            }
+        }
         std::ostringstream oss;
-        oss << "Statistics:\n";
-        for (const auto & [host, s, listener_] : stats) {
-            oss << std::setw(15) << host << ": " << s << "\n";
-        }
-	if (with_order_book) {
-            oss << "OrderBook from the best listener:\n";
-	    auto & listener = std::get<2>(stats[0]);
-	    if (listener) {
-	        std::get<2>(stats[0])->get_order_book().print(oss, max_ob_levels_to_show);
-	    } else {
-                ALWAYS_LOG("[ERROR]: unexpected empty listener when with_order_book=" << std::boolalpha << with_order_book);
-	    }
+        oss << "Statistics (ranked by " << ranker.get_policy().name() << " over the last " << ranker.get_window().count() << "s):\n";
+        // IPv6 addresses are longer, columns widen for them
+        int host_width = 15;
+        for (const auto & c : stats) {
+            host_width = std::max<int>(host_width, c.host.size());
+        }
+        for (size_t i = 0; i < stats.size(); ++i) {
+            const auto & c = stats[i];
+            oss << (i == best ? "*" : " ") << std::setw(host_width) << c.host << ": " << c.total
+                << (c.listener->get_metrics().is_stale() ? " [stale book]" : "") << "\n";
+            oss << std::setw(host_width + 1) << "window" << ": " << c.window << "\n";
+            oss << std::setw(host_width + 1) << "transport" << ": " << c.transport << "\n";
+            if (const auto pipeline = c.listener->get_pipeline_statistics(); !pipeline.empty()) {
+                oss << std::setw(host_width + 1) << "stages" << ": " << pipeline << "\n";
+            }
+        }
+        if (ip_family == IpFamily::Any) {
+            // candidates are sorted, the first one of a family is its best path
+            const auto family = [&measurers] (const EndpointRanker::Candidate & c) {
+                const auto it = std::find_if(measurers.begin(), measurers.end(), [&c] (const auto & m) { return m.listener == c.listener; });
+                return family_of(it->endpoint.ip);
+            };
+            const auto best_of = [&] (const IpFamily f) {
+                return std::find_if(stats.begin(), stats.end(), [&] (const auto & c) { return !c.window.empty() && family(c) == f; });
+            };
+            const auto v4 = best_of(IpFamily::V4);
+            const auto v6 = best_of(IpFamily::V6);
+            if (v4 != stats.end() && v6 != stats.end()) {
+                oss << "Best path per address family:\n";
+                for (const auto & it : {v4, v6}) {
+                    oss << std::setw(host_width + 1) << family(*it) << ": " << it->host << ", " << it->window << "\n";
+                }
+            }
+        }
+        if (with_order_book && best < stats.size()) {
+            const auto depth = stats[best].listener->get_metrics().snapshot();
+            oss << "OrderBook from the best listener, BIDS: " << depth.bids << ", ASKS: " << depth.asks << "\n";
+            if (book_config.analytics_depth) {
+                const auto & books = stats[best].listener->get_books();
+                oss << "Top " << book_config.analytics_depth << " levels:\n";
+                for (BookManager::Id id = 0; id < std::min<size_t>(books.size(), max_symbols_to_show); ++id) {
+                    oss << std::setw(16) << books.get_symbol(id) << ": " << books.get_analytics(id) << "\n";
+                }
+                if (books.size() > max_symbols_to_show) {
+                    oss << std::setw(16) << "..." << "  and " << books.size() - max_symbols_to_show << " more symbols\n";
+                }
+            }
+            const auto ob = stats[best].listener->get_order_book(max_ob_levels_to_show);
+            if (order_book_diff) {
+                oss << renderer.render(ob);
+            } else {
+                ob.print(oss, max_ob_levels_to_show);
+            }
         }
         ALWAYS_LOG(std::move(oss).str());
         std::unique_lock lk(signal_mutex); // synchronizes run variable
         cv.wait_for(lk, std::chrono::milliseconds(delay_ms));
     }
+    if (metrics_server) {
+        metrics_server->stop();
+    }
+    if (watchdog) {
+        watchdog->stop();
+    }
     ALWAYS_LOG("Stopping measurers");
     for (auto & m : measurers) {
-        m.first->stop();
+        m.connector->stop();
     }
     return 0;
 }
@@ -0,0 +1,110 @@
+#include "DepthStubServer.h"
+#include "Log.h"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+namespace po = boost::program_options;
+
+namespace {
+
+// ip:port[:delay_us]
+binance::DepthStubServer::Listener parse_listener(const std::string & str)
+{
+    // IPv6 addresses go in brackets, e.g. [::1]:9443
+    const auto ip_end = str.starts_with('[') ? str.find(']') : 0;
+    const auto port_pos = ip_end == std::string::npos ? ip_end : str.find(':', ip_end);
+    if (port_pos == std::string::npos || (ip_end != 0 && port_pos != ip_end + 1)) {
+        throw std::invalid_argument("listener must be ip:port[:delay_us] or [ipv6]:port[:delay_us], got [" + str + "]");
+    }
+    binance::DepthStubServer::Listener ret;
+    ret.ip = ip_end != 0 ? str.substr(1, ip_end - 1) : str.substr(0, port_pos);
+    const auto delay_pos = str.find(':', port_pos + 1);
+    ret.port = static_cast<Port>(std::stoul(str.substr(port_pos + 1, delay_pos - port_pos - 1)));
+    if (delay_pos != std::string::npos) {
+        ret.delay = std::chrono::microseconds(std::stoll(str.substr(delay_pos + 1)));
+    }
+    return ret;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+    binance::DepthStubServer::Config config;
+    std::vector<std::string> listeners;
+    int64_t report_period_ms = 5000;
+    std::string stream = "depth";
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("listen", po::value<std::vector<std::string>>(&listeners)->multitoken()->default_value({"127.0.0.1:9443:0"}, "127.0.0.1:9443:0"),
+            "listener as ip:port[:delay_us], IPv6 in brackets, can be repeated, e.g. 127.0.0.1:9443:0 [::1]:9443:500")
+        ("rate", po::value<double>(&config.rate)->default_value(1000), "messages per second")
+        ("burst-size", po::value<size_t>(&config.burst_size)->default_value(1), "messages sent back-to-back, bursts are spaced to keep the rate")
+        ("ticker", po::value<std::vector<std::string>>(&config.symbols)->multitoken()->default_value({"BTCUSDT"}, "BTCUSDT"),
+            "set tickers, messages cycle through them")
+        ("stream", po::value<std::string>(&stream)->default_value("depth"), "set stream to emulate: depth, depth<5|10|20>, bookTicker, trade or aggTrade")
+        ("depth", po::value<size_t>(&config.generator.book_depth)->default_value(1000), "levels per side of generated book")
+        ("levels-per-update", po::value<size_t>(&config.generator.levels_per_update)->default_value(10), "levels in each depthUpdate")
+        ("threads", po::value<size_t>(&config.threads)->default_value(1), "number of io threads")
+        ("compression", po::value<bool>(&config.compression)->default_value(false), "accept permessage-deflate offered by clients")
+        ("report-period", po::value<int64_t>(&report_period_ms)->default_value(5000), "set period between statistics output")
+        ;
+
+    po::variables_map vm;
+
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help")) {
+        ALWAYS_LOG(desc);
+        return 1;
+    }
+
+    for (const auto & l : listeners) {
+        config.listeners.push_back(parse_listener(l));
+    }
+    try {
+        const auto variant = binance::parse_stream_variant(stream);
+        config.generator.stream = variant.type;
+        config.generator.partial_levels = variant.levels;
+    } catch (const std::invalid_argument & e) {
+        ALWAYS_LOG(e.what());
+        return 1;
+    }
+
+    binance::DepthStubServer server(config);
+    server.start();
+
+    // a signal handler may not take locks, the flag is polled instead
+    static std::atomic<bool> run = true;
+    static_assert(std::atomic<bool>::is_always_lock_free);
+    std::signal(SIGINT, [] ([[maybe_unused]] const int signal) {
+        run.store(false, std::memory_order_relaxed);
+    });
+    constexpr auto poll_period = std::chrono::milliseconds(50);
+
+    size_t prev_sent = 0;
+    auto prev_ts = std::chrono::steady_clock::now();
+    while (run) {
+        const auto deadline = prev_ts + std::chrono::milliseconds(report_period_ms);
+        for (auto now = prev_ts; run && now < deadline; now = std::chrono::steady_clock::now()) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(poll_period, deadline - now));
+        }
+        const auto sent = server.get_sent_messages();
+        const auto now = std::chrono::steady_clock::now();
+        const auto seconds = std::chrono::duration<double>(now - prev_ts).count();
+        ALWAYS_LOG("Connections: " << server.get_connections() << ", sent: " << sent << ", rate: " << static_cast<size_t>((sent - prev_sent) / seconds) << " msg/s");
+        prev_sent = sent;
+        prev_ts = now;
+    }
+    ALWAYS_LOG("Stopping stub server");
+    server.stop();
+    return 0;
+}
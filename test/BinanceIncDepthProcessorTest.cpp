@@ -0,0 +1,139 @@
+#include "../src/BinanceIncDepthProcessor.h"
+#include "../src/DepthUpdateGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+thread_local bool count_allocations = false;
+thread_local size_t allocations = 0;
+
+// Counts heap allocations of the current thread between start() and stop()
+struct AllocationCounter
+{
+    void start()
+    {
+        allocations = 0;
+        count_allocations = true;
+    }
+
+    size_t stop()
+    {
+        count_allocations = false;
+        return allocations;
+    }
+};
+
+std::chrono::milliseconds now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+}
+
+}
+
+void * operator new(const std::size_t size)
+{
+    if (count_allocations) {
+        ++allocations;
+    }
+    if (void * p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(BinanceIncDepthProcessorTest, steady_state_processing_does_not_allocate) {
+    binance::DepthUpdateGenerator::Config config;
+    config.book_depth = 1000;
+    config.levels_per_update = 20;
+    binance::DepthUpdateGenerator generator(config);
+
+    std::string snapshot;
+    generator.snapshot(snapshot, now_ms());
+    std::vector<std::string> updates(4000);
+    for (auto & u : updates) {
+        generator.next(u, now_ms());
+    }
+    ASSERT_NE(updates.back().find(",\"u\":" + std::to_string(generator.last_update_id()) + ','), std::string::npos);
+
+    binance::BinanceIncDepthProcessor processor(true);
+    ASSERT_TRUE(processor.process(snapshot));
+    // warm up: the book and the statistics reach their working sizes
+    const size_t warm_up = updates.size() / 2;
+    for (size_t i = 0; i < warm_up; ++i) {
+        ASSERT_TRUE(processor.process(updates[i]));
+    }
+
+    AllocationCounter counter;
+    counter.start();
+    bool processed = true;
+    for (size_t i = warm_up; i < updates.size(); ++i) {
+        processed = processor.process(updates[i]) && processed;
+    }
+    const auto allocated = counter.stop();
+    ASSERT_TRUE(processed);
+    ASSERT_EQ(0u, allocated);
+    ASSERT_FALSE(processor.get_order_book().empty());
+}
+
+TEST(BinanceIncDepthProcessorTest, malformed_price_disables_order_book) {
+    binance::BinanceIncDepthProcessor processor(true);
+    processor.process(R"({"e":"depthUpdate","E":1,"s":"BTCUSDT","U":1,"u":1,"b":[["100.5","1"]],"a":[]})");
+    ASSERT_EQ(1u, processor.get_order_book().get_bids().size());
+    ASSERT_DOUBLE_EQ(100.5, processor.get_order_book().get_bids()[0].price);
+
+    processor.process(R"({"e":"depthUpdate","E":2,"s":"BTCUSDT","U":2,"u":2,"b":[["abc","1"]],"a":[]})");
+    ASSERT_TRUE(processor.get_order_book().empty());
+    ASSERT_EQ(1u, processor.get_metrics().snapshot().failures);
+}
+
+TEST(BinanceIncDepthProcessorTest, routes_updates_by_symbol) {
+    binance::BinanceIncDepthProcessor processor(true, {}, {"BTCUSDT", "ETHUSDT"});
+    processor.process(R"({"e":"depthUpdate","E":1,"s":"ETHUSDT","U":1,"u":1,"b":[["3000","1"]],"a":[]})");
+    processor.process(R"({"stream":"btcusdt@depth","data":{"e":"depthUpdate","E":1,"s":"BTCUSDT","U":7,"u":8,"b":[["60000","1"]],"a":[["60001","2"]]}})");
+    processor.process(R"({"e":"depthUpdate","E":1,"s":"XRPUSDT","U":1,"u":1,"b":[["1","1"]],"a":[]})");
+    // ids of different symbols are unrelated, no gap here
+    processor.process(R"({"e":"depthUpdate","E":2,"s":"ETHUSDT","U":2,"u":2,"b":[["3001","1"]],"a":[]})");
+
+    const auto & books = processor.get_books();
+    ASSERT_EQ(books.copy_top(1, -1).get_bids().size(), 2);
+    ASSERT_DOUBLE_EQ(books.copy_top(1, -1).get_bids()[0].price, 3001);
+    ASSERT_EQ(processor.get_order_book().get_bids().size(), 1);
+    ASSERT_DOUBLE_EQ(processor.get_order_book().get_asks()[0].price, 60001);
+    ASSERT_EQ(processor.get_metrics().snapshot().gaps, 0);
+    ASSERT_EQ(processor.get_metrics().snapshot().messages, 4);
+}
+
+TEST(BinanceIncDepthProcessorTest, batch_goes_on_after_failed_message) {
+    binance::BinanceIncDepthProcessor processor(true);
+    const std::vector<std::string_view> batch = {
+        R"({"e":"depthUpdate","E":1,"s":"BTCUSDT","U":1,"u":1,"b":[["100.5","1"]],"a":[]})",
+        R"({"e":"depthUpdate","E":2,"s":"BTCUSDT","U":2,"u":2,"b":[["abc","1"]],"a":[]})",
+        R"({"e":"depthUpdate","E":3,"s":"BTCUSDT","U":3,"u":3,"b":[["101","1"]],"a":[]})",
+    };
+    PipelineTrace trace;
+    ASSERT_TRUE(processor.process_batch(batch, trace));
+
+    const auto metrics = processor.get_metrics().snapshot();
+    ASSERT_EQ(metrics.messages, 3);
+    ASSERT_EQ(metrics.failures, 1);
+    ASSERT_EQ(metrics.gaps, 0);
+    // the failure disabled the book, latency is measured still
+    ASSERT_TRUE(processor.get_order_book().empty());
+    ASSERT_EQ(processor.get_window_summary(std::chrono::seconds(10)).count, 1);
+}
@@ -0,0 +1,101 @@
+#include "../src/ArrivalRace.h"
+#include "../src/BinanceTopOfBookProcessor.h"
+#include "../src/DepthUpdateGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace std::chrono_literals;
+
+TEST(BinanceTopOfBookProcessorTest, book_ticker_keeps_best_levels_only) {
+    binance::BinanceTopOfBookProcessor processor(binance::StreamType::BookTicker, true);
+    processor.process(R"({"u":1,"s":"BTCUSDT","b":"100.5","B":"1","a":"101","A":"2"})");
+    processor.process(R"({"u":5,"s":"BTCUSDT","b":"100.25","B":"3","a":"101.5","A":"4"})");
+
+    const auto book = processor.get_order_book();
+    ASSERT_EQ(book.get_bids().size(), 1);
+    ASSERT_EQ(book.get_asks().size(), 1);
+    ASSERT_DOUBLE_EQ(book.get_bids()[0].price, 100.25);
+    ASSERT_DOUBLE_EQ(book.get_bids()[0].volume, 3);
+    ASSERT_DOUBLE_EQ(book.get_asks()[0].price, 101.5);
+    ASSERT_EQ(processor.get_metrics().snapshot().gaps, 0);
+}
+
+TEST(BinanceTopOfBookProcessorTest, partial_depth_replaces_book) {
+    const auto log = std::make_shared<ArrivalLog>();
+    binance::BinanceTopOfBookProcessor processor(binance::StreamType::PartialDepth, true, {}, {"BTCUSDT", "ETHUSDT"});
+    processor.set_arrival_log(log);
+    processor.process(R"({"stream":"btcusdt@depth5@100ms","data":{"lastUpdateId":10,"bids":[["100","1"],["99","1"]],"asks":[["101","1"]]}})");
+    processor.process(R"({"stream":"ethusdt@depth5@100ms","data":{"lastUpdateId":3,"bids":[["10","1"]],"asks":[]}})");
+    processor.process(R"({"stream":"btcusdt@depth5@100ms","data":{"lastUpdateId":12,"bids":[["98","1"]],"asks":[["102","1"],["103","1"]]}})");
+
+    const auto book = processor.get_order_book();
+    ASSERT_EQ(book.get_bids().size(), 1);
+    ASSERT_DOUBLE_EQ(book.get_bids()[0].price, 98);
+    ASSERT_EQ(book.get_asks().size(), 2);
+    ASSERT_EQ(processor.get_books().copy_top(1, -1).get_bids().size(), 1);
+    // only ids of the primary symbol are logged
+    ASSERT_EQ(log->frontier(), 12);
+    ASSERT_EQ(log->covered_at(11), log->covered_at(12));
+}
+
+TEST(BinanceTopOfBookProcessorTest, book_ticker_without_event_time_counts_for_wins) {
+    const auto race = std::make_shared<ArrivalRace>();
+    binance::BinanceTopOfBookProcessor first(binance::StreamType::BookTicker, false);
+    binance::BinanceTopOfBookProcessor second(binance::StreamType::BookTicker, false);
+    first.set_arrival_race(race);
+    second.set_arrival_race(race);
+
+    const auto update = R"({"u":7,"s":"BTCUSDT","b":"1","B":"1","a":"2","A":"1"})";
+    first.process(update);
+    second.process(update);
+
+    const auto summary = first.get_window_summary(10s);
+    ASSERT_EQ(summary.count, 1);
+    ASSERT_EQ(summary.timed, 0);
+    ASSERT_EQ(summary.win_rate, 1);
+    ASSERT_EQ(second.get_window_summary(10s).win_rate, 0);
+    ASSERT_TRUE(first.get_statistics().empty());
+    ASSERT_EQ(first.get_metrics().snapshot().messages, 1);
+}
+
+TEST(BinanceTopOfBookProcessorTest, trades_are_timed_and_build_no_book) {
+    for (const auto stream : {binance::StreamType::Trade, binance::StreamType::AggTrade}) {
+        binance::DepthUpdateGenerator::Config config;
+        config.stream = stream;
+        binance::DepthUpdateGenerator generator(config);
+        binance::BinanceTopOfBookProcessor processor(stream, true);
+
+        const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+        for (int i = 0; i < 10; ++i) {
+            processor.process(generator.next(now));
+        }
+        ASSERT_EQ(processor.get_window_summary(10s).timed, 10) << stream;
+        ASSERT_FALSE(processor.get_statistics().empty()) << stream;
+        ASSERT_TRUE(processor.get_order_book().empty()) << stream;
+        ASSERT_EQ(processor.get_metrics().snapshot().failures, 0) << stream;
+    }
+}
+
+TEST(BinanceTopOfBookProcessorTest, skips_subscription_reply) {
+    binance::BinanceTopOfBookProcessor processor(binance::StreamType::Trade, false);
+    ASSERT_TRUE(processor.process(R"({"result":null,"id":1})"));
+    ASSERT_EQ(processor.get_metrics().snapshot().messages, 0);
+}
+
+TEST(BinanceTopOfBookProcessorTest, depth_stream_is_rejected) {
+    ASSERT_THROW(binance::BinanceTopOfBookProcessor(binance::StreamType::Depth, true), std::invalid_argument);
+    ASSERT_THROW(binance::parse_stream_type("ticker"), std::invalid_argument);
+    ASSERT_EQ(binance::parse_stream_type("bookTicker"), binance::StreamType::BookTicker);
+}
+
+TEST(BinanceTopOfBookProcessorTest, stream_variants_round_trip) {
+    for (const auto name : {"depth", "depth@100ms", "depth20@100ms", "depth5", "bookTicker", "aggTrade"}) {
+        ASSERT_EQ(binance::parse_stream_variant(name).name(), name);
+    }
+    ASSERT_EQ(binance::parse_stream_variant("depth10").type, binance::StreamType::PartialDepth);
+    ASSERT_EQ(binance::parse_stream_variant("depth@1000ms").name(), "depth");
+    ASSERT_THROW(binance::parse_stream_variant("bookTicker@100ms"), std::invalid_argument);
+    ASSERT_THROW(binance::parse_stream_variant("depth15"), std::invalid_argument);
+}
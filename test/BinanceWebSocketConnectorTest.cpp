@@ -0,0 +1,167 @@
+#include "../src/BinanceIncDepthProcessor.h"
+#include "../src/BinanceWebSocketConnector.h"
+#include "../src/BookDeltaPublisher.h"
+#include "../src/DepthStubServer.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace binance;
+using namespace std::chrono_literals;
+
+namespace {
+
+DepthStubServer::Config stub_config(const Port port = 0)
+{
+    DepthStubServer::Config config;
+    config.listeners.push_back({"127.0.0.1", port});
+    config.rate = 200;
+    return config;
+}
+
+// Polls the condition until it holds or the timeout runs out
+bool wait_for(const std::function<bool()> & condition, const std::chrono::milliseconds timeout = 10s)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    return true;
+}
+
+// Everything written to the pipe so far
+std::string read_available(const int fd)
+{
+    std::string ret;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        ret.append(buf, static_cast<size_t>(n));
+    }
+    return ret;
+}
+
+}
+
+TEST(BinanceWebSocketConnectorTest, deflate_is_negotiated_and_counted) {
+    auto config = stub_config();
+    config.compression = true;
+    DepthStubServer server(std::move(config));
+    server.start();
+
+    auto processor = std::make_shared<BinanceIncDepthProcessor>(true);
+    auto connector = BinanceWebSocketConnector::make_depth_connector("127.0.0.1", server.get_ports().front(), {"btcusdt"}, processor);
+    connector->set_compression(true);
+    connector->start();
+
+    ASSERT_TRUE(wait_for([&] { return connector->get_transport_statistics().messages >= 100; }));
+    const auto stat = connector->get_transport_statistics();
+    connector->stop();
+
+    EXPECT_TRUE(stat.compressed);
+    EXPECT_GT(stat.payload_bytes, 0u);
+    EXPECT_LT(stat.wire_bytes, stat.payload_bytes);
+    EXPECT_GT(processor->get_metrics().snapshot().messages, 0u);
+}
+
+TEST(BinanceWebSocketConnectorTest, uncompressed_frames_cost_more_than_payload) {
+    DepthStubServer server(stub_config());
+    server.start();
+
+    auto connector = BinanceWebSocketConnector::make_depth_connector("127.0.0.1", server.get_ports().front(), {"btcusdt"},
+                                                                     std::make_shared<BinanceIncDepthProcessor>(true));
+    connector->set_compression(true); // offered but not taken
+    connector->start();
+
+    ASSERT_TRUE(wait_for([&] { return connector->get_transport_statistics().messages >= 10; }));
+    const auto stat = connector->get_transport_statistics();
+    connector->stop();
+
+    EXPECT_FALSE(stat.compressed);
+    EXPECT_GT(stat.wire_bytes, stat.payload_bytes);
+}
+
+TEST(BinanceWebSocketConnectorTest, book_is_built_again_after_reconnect) {
+    auto server = std::make_unique<DepthStubServer>(stub_config());
+    server->start();
+    const auto port = server->get_ports().front();
+
+    auto processor = std::make_shared<BinanceIncDepthProcessor>(true);
+    // keyframes are not due by the interval during the test, only forced ones come
+    int fds[2];
+    ASSERT_EQ(pipe2(fds, O_NONBLOCK), 0);
+    fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+    auto publisher = std::make_shared<BookDeltaPublisher>(fds[1], book_delta::EncoderConfig{1e-2, 1e-8, 1000000});
+    publisher->set_source(processor.get(), "127.0.0.1");
+    processor->add_publisher(publisher);
+    auto connector = BinanceWebSocketConnector::make_depth_connector("127.0.0.1", port, {"btcusdt"}, processor);
+    connector->set_reconnect_attempts(3);
+    connector->start();
+
+    ASSERT_TRUE(wait_for([&] { return !processor->get_order_book().empty(); }));
+
+    // a new stub server starts its update ids over, as a new session may skip some
+    server.reset();
+    ASSERT_TRUE(wait_for([&] { return processor->get_metrics().snapshot().sessions_lost == 1; }));
+    read_available(fds[0]); // of the first session
+    const auto messages = processor->get_metrics().snapshot().messages;
+    server = std::make_unique<DepthStubServer>(stub_config(port));
+    server->start();
+
+    ASSERT_TRUE(wait_for([&] { return processor->get_metrics().snapshot().messages > messages + 10; }));
+    EXPECT_TRUE(connector->is_running());
+    connector->stop();
+    const auto metrics = processor->get_metrics().snapshot();
+    EXPECT_FALSE(processor->get_statistics().empty());
+    EXPECT_FALSE(metrics.stale);
+    EXPECT_EQ(metrics.gaps, 0u);
+    EXPECT_EQ(metrics.failures, 0u);
+    EXPECT_EQ(metrics.sessions_lost, 1u);
+
+    // a consumer joining after the drop is synced by the keyframe of the new session
+    book_delta::Decoder decoder;
+    decoder.feed(read_available(fds[0]));
+    ASSERT_TRUE(decoder.synced());
+    const auto book = processor->get_order_book();
+    ASSERT_FALSE(book.empty());
+    ASSERT_EQ(decoder.get_order_book().get_bids_depth(), book.get_bids_depth());
+    ASSERT_EQ(decoder.get_order_book().get_asks_depth(), book.get_asks_depth());
+    close(fds[0]);
+}
+
+TEST(BinanceWebSocketConnectorTest, kernel_tls_or_its_fallback_reads_the_stream) {
+    DepthStubServer server(stub_config());
+    server.start();
+
+    auto processor = std::make_shared<BinanceIncDepthProcessor>(true);
+    auto connector = BinanceWebSocketConnector::make_depth_connector("127.0.0.1", server.get_ports().front(), {"btcusdt"}, processor);
+    connector->set_kernel_tls(true);
+    connector->start();
+
+    ASSERT_TRUE(wait_for([&] { return processor->get_metrics().snapshot().messages >= 50; }));
+    const auto stat = connector->get_transport_statistics();
+    EXPECT_TRUE(connector->is_running());
+    connector->stop();
+
+    // the handshake loads the tls module where the kernel has it, OpenSSL decrypts otherwise
+    std::ifstream ulp("/proc/sys/net/ipv4/tcp_available_ulp");
+    const std::string available((std::istreambuf_iterator<char>(ulp)), std::istreambuf_iterator<char>());
+    const bool kernel_has_tls = available.find("tls") != std::string::npos;
+    RecordProperty("path", stat.kernel_tls ? "kTLS" : "OpenSSL fallback");
+    EXPECT_EQ(stat.kernel_tls, kernel_has_tls) << available;
+    EXPECT_EQ(processor->get_metrics().snapshot().failures, 0u);
+    EXPECT_FALSE(processor->get_order_book().empty());
+}
@@ -0,0 +1,175 @@
+#include "../src/BookDelta.h"
+#include "../src/BookDeltaPublisher.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <unistd.h>
+
+namespace {
+
+void expect_same_levels(const std::vector<std::pair<double, double>> & expected, const OrderBook & ob, const OrderBook::Side side)
+{
+    const auto & lvls = side == OrderBook::Side::Bid ? ob.get_bids() : ob.get_asks();
+    ASSERT_EQ(lvls.size(), expected.size());
+    for (size_t i = 0; i < lvls.size(); ++i) {
+        ASSERT_NEAR(lvls[i].price, expected[i].first, 1e-9);
+        ASSERT_NEAR(lvls[i].volume, expected[i].second, 1e-9);
+    }
+}
+
+void expect_same_book(const OrderBook & expected, const OrderBook & actual)
+{
+    std::vector<std::pair<double, double>> bids, asks;
+    for (const auto & l : expected.get_bids()) {
+        bids.emplace_back(l.price, l.volume);
+    }
+    for (const auto & l : expected.get_asks()) {
+        asks.emplace_back(l.price, l.volume);
+    }
+    expect_same_levels(bids, actual, OrderBook::Side::Bid);
+    expect_same_levels(asks, actual, OrderBook::Side::Ask);
+}
+
+// Random changes around 50000.00 with 0.01 ticks, about a fifth of them remove levels
+std::vector<LevelChange> random_changes(std::mt19937 & rng)
+{
+    std::uniform_int_distribution<int> levels_num(1, 10);
+    std::uniform_int_distribution<int> offset(1, 200);
+    std::uniform_int_distribution<int> qty(0, 50000);
+    std::vector<LevelChange> ret;
+    for (int i = levels_num(rng); i > 0; --i) {
+        const bool bid = rng() % 2;
+        const auto q = qty(rng);
+        const double price = 50000 + (bid ? -1 : 1) * offset(rng) * 0.01;
+        ret.push_back({bid ? OrderBook::Side::Bid : OrderBook::Side::Ask, price, q < 10000 ? 0 : q * 0.00001});
+    }
+    return ret;
+}
+
+}
+
+TEST(BookDeltaTest, roundtrip_with_keyframes_and_partial_reads) {
+    std::mt19937 rng(42);
+    book_delta::Encoder encoder({1e-2, 1e-5, 50});
+    book_delta::Decoder decoder;
+    OrderBook source;
+    std::string stream;
+
+    for (uint64_t id = 1; id <= 1000; ++id) {
+        const auto changes = random_changes(rng);
+        for (const auto & c : changes) {
+            source.insert_replace(c.price, c.volume, c.side);
+        }
+        if (encoder.keyframe_due()) {
+            encoder.encode_keyframe(source, id, 1000 + id, stream);
+        } else {
+            encoder.encode_delta(changes, id, 1000 + id, stream);
+        }
+        // feed in uneven pieces to exercise frames split between reads
+        const auto piece = std::min<size_t>(stream.size(), rng() % 16);
+        decoder.feed(std::string_view(stream).substr(0, piece));
+        stream.erase(0, piece);
+    }
+    decoder.feed(stream);
+
+    ASSERT_TRUE(decoder.synced());
+    ASSERT_EQ(decoder.get_update_id(), 1000);
+    ASSERT_EQ(decoder.get_event_time_ms(), 2000);
+    expect_same_book(source, decoder.get_order_book());
+}
+
+TEST(BookDeltaTest, decoding_starts_at_keyframe) {
+    book_delta::Encoder encoder({1e-2, 1e-5, 2});
+    OrderBook source;
+    std::string first, rest;
+    const std::vector<LevelChange> change{{OrderBook::Side::Bid, 100, 1}};
+    source.insert_replace(100, 1, OrderBook::Side::Bid);
+    encoder.encode_keyframe(source, 1, 1, first);
+    encoder.encode_delta(change, 2, 2, first);
+
+    book_delta::Decoder decoder;
+    // a consumer joining after the keyframe ignores deltas until the next one
+    ASSERT_EQ(decoder.feed(std::string_view(first).substr(first.size() - 4)), 0);
+    ASSERT_FALSE(decoder.synced());
+
+    book_delta::Decoder joined;
+    encoder.encode_delta(change, 3, 3, rest);
+    ASSERT_TRUE(encoder.keyframe_due());
+    encoder.encode_keyframe(source, 4, 4, rest);
+    ASSERT_EQ(joined.feed(rest), 1);
+    ASSERT_TRUE(joined.synced());
+    ASSERT_EQ(joined.get_update_id(), 4);
+    expect_same_book(source, joined.get_order_book());
+}
+
+TEST(BookDeltaTest, keyframe_carries_cold_levels) {
+    OrderBook source;
+    OrderBookConfig config;
+    config.max_depth = 2;
+    source.configure(config);
+    for (const double price : {100.0, 99.0, 98.0, 97.0}) {
+        source.insert_replace(price, 1, OrderBook::Side::Bid);
+        source.insert_replace(200 - price, 1, OrderBook::Side::Ask);
+    }
+    // 98 is promoted from the cold store
+    source.insert_replace(100, 0, OrderBook::Side::Bid);
+
+    book_delta::Encoder encoder({1e-2, 1e-5, 2});
+    std::string out;
+    encoder.encode_keyframe(source, 1, 1, out);
+    book_delta::Decoder decoder;
+    ASSERT_EQ(decoder.feed(out), 1);
+    const auto full = source.copy_top(-1);
+    ASSERT_EQ(full.get_bids().size(), 3);
+    ASSERT_EQ(full.get_asks().size(), 4);
+    expect_same_book(full, decoder.get_order_book());
+}
+
+TEST(BookDeltaTest, top_of_book_change_is_compact) {
+    book_delta::Encoder encoder;
+    OrderBook source;
+    source.insert_replace(50000.01, 1, OrderBook::Side::Ask);
+    source.insert_replace(49999.99, 1, OrderBook::Side::Bid);
+    std::string out;
+    encoder.encode_keyframe(source, 1000000, 1700000000000, out);
+    out.clear();
+    encoder.encode_delta({{OrderBook::Side::Bid, 49999.98, 0.5}}, 1000001, 1700000000001, out);
+    ASSERT_LE(out.size(), 16);
+}
+
+TEST(BookDeltaTest, publisher_follows_source_and_resyncs) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    BookDeltaPublisher publisher(fds[1], {1e-2, 1e-5, 1000});
+    const auto first = reinterpret_cast<const IJsonDataListener *>(uintptr_t(1));
+    const auto second = reinterpret_cast<const IJsonDataListener *>(uintptr_t(2));
+
+    OrderBook a, b;
+    b.insert_replace(10, 1, OrderBook::Side::Bid);
+    std::vector<LevelChange> changes{{OrderBook::Side::Bid, 100, 2}};
+    a.insert_replace(100, 2, OrderBook::Side::Bid);
+
+    publisher.set_source(first, "first");
+    ASSERT_TRUE(publisher.publish(first, {1, std::chrono::milliseconds(1), a, changes}));
+    ASSERT_FALSE(publisher.publish(second, {1, std::chrono::milliseconds(1), b, changes}));
+    changes = {{OrderBook::Side::Bid, 99, 3}};
+    a.insert_replace(99, 3, OrderBook::Side::Bid);
+    ASSERT_TRUE(publisher.publish(first, {2, std::chrono::milliseconds(2), a, changes}));
+
+    char buf[4096];
+    book_delta::Decoder decoder;
+    auto n = read(fds[0], buf, sizeof(buf));
+    ASSERT_EQ(decoder.feed({buf, static_cast<size_t>(n)}), 2);
+    expect_same_book(a, decoder.get_order_book());
+
+    // the other book replaces the first one entirely
+    publisher.set_source(second, "second");
+    ASSERT_TRUE(publisher.publish(second, {7, std::chrono::milliseconds(7), b, {}}));
+    n = read(fds[0], buf, sizeof(buf));
+    ASSERT_EQ(decoder.feed({buf, static_cast<size_t>(n)}), 1);
+    ASSERT_EQ(decoder.get_update_id(), 7);
+    expect_same_book(b, decoder.get_order_book());
+    close(fds[0]);
+}
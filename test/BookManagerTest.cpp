@@ -0,0 +1,77 @@
+#include "../src/BookManager.h"
+#include "../src/SymbolTable.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(SymbolTableTest, interns_dense_ids) {
+    SymbolTable table;
+    ASSERT_EQ(table.find("BTCUSDT"), SymbolTable::npos);
+    ASSERT_EQ(table.intern("BTCUSDT"), 0);
+    ASSERT_EQ(table.intern("ETHUSDT"), 1);
+    ASSERT_EQ(table.intern("BTCUSDT"), 0);
+    ASSERT_EQ(table.find("ETHUSDT"), 1);
+    ASSERT_EQ(table.find("ETHUSD"), SymbolTable::npos);
+    ASSERT_EQ(table.find("ETHUSDTT"), SymbolTable::npos);
+    ASSERT_EQ(table.name(1), "ETHUSDT");
+    ASSERT_EQ(table.size(), 2);
+}
+
+TEST(SymbolTableTest, keeps_ids_while_growing) {
+    SymbolTable table;
+    for (size_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(table.intern("SYM" + std::to_string(i) + "USDT"), i);
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(table.find("SYM" + std::to_string(i) + "USDT"), i);
+    }
+    // differs from an interned one after the first 8 bytes only
+    ASSERT_EQ(table.find("SYM1USDT1"), SymbolTable::npos);
+}
+
+TEST(SymbolTableTest, rejects_long_symbols) {
+    SymbolTable table;
+    ASSERT_THROW(table.intern("ABCDEFGHIJKLMNOPQ"), std::invalid_argument);
+    ASSERT_THROW(table.intern(""), std::invalid_argument);
+    ASSERT_EQ(table.intern("ABCDEFGHIJKLMNOP"), 0);
+    ASSERT_EQ(table.find("ABCDEFGHIJKLMNOPQ"), SymbolTable::npos);
+}
+
+TEST(BookManagerTest, books_are_separate_and_aligned) {
+    BookManager books({"BTCUSDT", "ETHUSDT"}, {16, 0, 5});
+    ASSERT_EQ(books.size(), 2);
+    ASSERT_EQ(books.route("ETHUSDT"), 1);
+    ASSERT_EQ(books.route("XRPUSDT"), BookManager::npos);
+    ASSERT_EQ(books.get_symbol(0), "BTCUSDT");
+
+    books[0].book.insert_replace<OrderBook::Side::Bid>(100, 1);
+    books[0].book.insert_replace<OrderBook::Side::Ask>(101, 1);
+    books[1].book.insert_replace<OrderBook::Side::Bid>(10, 1);
+    ASSERT_EQ(books.copy_top(0, -1).get_bids().size(), 1);
+    ASSERT_TRUE(books.copy_top(1, -1).get_asks().empty());
+    ASSERT_TRUE(books.get_analytics(0).valid);
+    ASSERT_FALSE(books.get_analytics(1).valid);
+
+    const auto distance = reinterpret_cast<const char *>(&books[1]) - reinterpret_cast<const char *>(&books[0]);
+    ASSERT_EQ(distance % 64, 0);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(&books[0]) % 64, 0);
+    // levels of the two books come from separate pools
+    const auto bids_line = [&] (const BookManager::Id id) { return reinterpret_cast<uintptr_t>(books[id].book.get_bids().data()) / 64; };
+    ASSERT_NE(bids_line(0), bids_line(1));
+
+    books[0].last_update_id = 42;
+    books[0].consistent = false;
+    books.clear();
+    ASSERT_TRUE(books.copy_top(0, -1).empty());
+    ASSERT_EQ(books[0].last_update_id, 0);
+    ASSERT_TRUE(books[0].consistent);
+}
+
+TEST(BookManagerTest, without_symbols_single_book_takes_all) {
+    BookManager books;
+    ASSERT_EQ(books.size(), 1);
+    ASSERT_EQ(books.route("BTCUSDT"), 0);
+    ASSERT_EQ(books.route(""), 0);
+    ASSERT_TRUE(books.get_symbol(0).empty());
+}
@@ -0,0 +1,45 @@
+#include "../src/CpuAffinity.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+TEST(CpuAffinityTest, parses_cpu_lists) {
+    ASSERT_EQ(affinity::parse_cpu_list("3"), std::vector<int>({3}));
+    ASSERT_EQ(affinity::parse_cpu_list("2-5,8"), std::vector<int>({2, 3, 4, 5, 8}));
+    ASSERT_EQ(affinity::parse_cpu_list("8,1-2,2"), std::vector<int>({1, 2, 8}));
+    ASSERT_TRUE(affinity::parse_cpu_list("").empty());
+    ASSERT_THROW(affinity::parse_cpu_list("5-2"), std::invalid_argument);
+    ASSERT_THROW(affinity::parse_cpu_list("1,,2"), std::invalid_argument);
+    ASSERT_THROW(affinity::parse_cpu_list("auto"), std::invalid_argument);
+}
+
+TEST(CpuAffinityTest, spreads_over_least_used) {
+    affinity::CpuPool pool({{2, 0}, {3, 0}, {4, 1}}, false);
+    ASSERT_EQ(pool.acquire().id, 2);
+    ASSERT_EQ(pool.acquire().id, 3);
+    ASSERT_EQ(pool.acquire().id, 4);
+    ASSERT_EQ(pool.acquire().id, 2);
+    pool.release({3, 0});
+    ASSERT_EQ(pool.acquire().id, 3);
+}
+
+TEST(CpuAffinityTest, moves_next_to_receiving_cpu) {
+    affinity::CpuPool pool({{2, 0}, {3, 0}, {4, 1}, {5, 1}}, true);
+    const auto cpu = pool.acquire();
+    ASSERT_EQ(cpu.id, 2);
+    // onto the receiving CPU itself when it is in the pool
+    ASSERT_EQ(pool.move_near(cpu, {5, 1}).id, 5);
+    // otherwise onto the least used CPU of its node
+    const auto other = pool.acquire();
+    ASSERT_EQ(other.id, 2);
+    ASSERT_EQ(pool.move_near(other, {7, 1}).id, 4);
+    // staying where it is on the node already
+    ASSERT_EQ(pool.move_near({3, 0}, {0, 0}).id, 3);
+    // and when the node has no CPU of the pool
+    ASSERT_EQ(pool.move_near({3, 0}, {9, 2}).id, 3);
+}
+
+TEST(CpuAffinityTest, no_pool_without_cpus) {
+    ASSERT_THROW(affinity::CpuPool({}, false), std::invalid_argument);
+}
@@ -0,0 +1,95 @@
+#include "../src/EndpointDiscovery.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+class FakeResolver
+    : public IDNSLookup
+{
+public:
+    explicit FakeResolver(std::map<std::string, std::vector<IPAddress>> records)
+        : m_records(std::move(records))
+    { }
+
+    std::vector<IPAddress> resolve(const std::string & domain) final
+    {
+        const auto it = m_records.find(domain);
+        return it == m_records.end() ? std::vector<IPAddress>{} : it->second;
+    }
+
+private:
+    std::map<std::string, std::vector<IPAddress>> m_records;
+};
+
+}
+
+TEST(EndpointDiscoveryTest, parses_host_port) {
+    const auto h = parse_host_port("stream.binance.com:9443");
+    ASSERT_EQ(h.host, "stream.binance.com");
+    ASSERT_EQ(h.port, 9443);
+    const auto v6 = parse_host_port("[::1]:443");
+    ASSERT_EQ(v6.host, "::1");
+    ASSERT_EQ(v6.port, 443);
+    ASSERT_THROW(parse_host_port("stream.binance.com"), std::invalid_argument);
+    ASSERT_THROW(parse_host_port("stream.binance.com:"), std::invalid_argument);
+    ASSERT_THROW(parse_host_port(":443"), std::invalid_argument);
+    ASSERT_THROW(parse_host_port("stream.binance.com:70000"), std::invalid_argument);
+    ASSERT_THROW(parse_host_port("[::1]443"), std::invalid_argument);
+}
+
+TEST(EndpointDiscoveryTest, merges_hosts_of_same_ip_and_port) {
+    FakeResolver resolver({
+        {"stream.binance.com", {"1.1.1.1", "2.2.2.2", "2001:db8::1"}},
+        {"data-stream.binance.vision", {"2.2.2.2", "3.3.3.3"}},
+    });
+    const auto endpoints = discover_endpoints(resolver, {
+        {"stream.binance.com", 9443}, {"stream.binance.com", 443}, {"data-stream.binance.vision", 443}, {"unknown.host", 443}}, IpFamily::Any);
+    ASSERT_EQ(endpoints.size(), 7u);
+    // the same IP on another port is another path
+    ASSERT_EQ(endpoints[1].name(), "2.2.2.2:9443");
+    ASSERT_EQ(endpoints[4].name(), "2.2.2.2:443");
+    ASSERT_EQ(endpoints[4].joined_hosts(), "stream.binance.com,data-stream.binance.vision");
+    ASSERT_EQ(endpoints[2].name(), "[2001:db8::1]:9443");
+    ASSERT_EQ(endpoints[6].label(), "3.3.3.3:443 (data-stream.binance.vision)");
+}
+
+TEST(EndpointDiscoveryTest, keeps_given_family) {
+    FakeResolver resolver({{"stream.binance.com", {"1.1.1.1", "2001:db8::1"}}});
+    const auto v6 = discover_endpoints(resolver, {{"stream.binance.com", 9443}}, IpFamily::V6);
+    ASSERT_EQ(v6.size(), 1u);
+    ASSERT_EQ(v6.front().ip, "2001:db8::1");
+    const auto v4 = discover_endpoints(resolver, {{"stream.binance.com", 9443}}, IpFamily::V4);
+    ASSERT_EQ(v4.size(), 1u);
+    ASSERT_EQ(v4.front().ip, "1.1.1.1");
+}
+
+TEST(EndpointDiscoveryTest, parses_ip_family) {
+    ASSERT_EQ(parse_ip_family("any"), IpFamily::Any);
+    ASSERT_EQ(parse_ip_family("v4"), IpFamily::V4);
+    ASSERT_EQ(parse_ip_family("v6"), IpFamily::V6);
+    for (const auto f : {IpFamily::Any, IpFamily::V4, IpFamily::V6}) {
+        ASSERT_EQ(parse_ip_family(to_string(f)), f);
+    }
+    ASSERT_THROW(parse_ip_family(""), std::invalid_argument);
+    ASSERT_THROW(parse_ip_family("V4"), std::invalid_argument);
+    ASSERT_THROW(parse_ip_family("ipv6"), std::invalid_argument);
+}
+
+TEST(EndpointDiscoveryTest, tells_family_of_ip) {
+    ASSERT_EQ(family_of("1.1.1.1"), IpFamily::V4);
+    ASSERT_EQ(family_of("127.0.0.1"), IpFamily::V4);
+    ASSERT_EQ(family_of("2001:db8::1"), IpFamily::V6);
+    ASSERT_EQ(family_of("::1"), IpFamily::V6);
+    ASSERT_EQ(family_of("::ffff:1.1.1.1"), IpFamily::V6);
+
+    ASSERT_TRUE(matches(IpFamily::Any, "1.1.1.1"));
+    ASSERT_TRUE(matches(IpFamily::Any, "::1"));
+    ASSERT_TRUE(matches(IpFamily::V4, "1.1.1.1"));
+    ASSERT_FALSE(matches(IpFamily::V4, "::1"));
+    ASSERT_TRUE(matches(IpFamily::V6, "2001:db8::1"));
+    ASSERT_FALSE(matches(IpFamily::V6, "1.1.1.1"));
+}
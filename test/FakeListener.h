@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../src/IJsonDataListener.h"
+
+// Counts messages in metrics and nothing else
+class FakeListener
+    : public IDepthDataListener
+{
+public:
+    using IJsonDataListener::process;
+
+    bool process(std::string_view data, PipelineTrace &) override
+    {
+        m_metrics.on_message(data.size(), std::chrono::microseconds(1));
+        return true;
+    }
+    void failure(std::string_view) override { }
+    void session_lost(std::string_view) override { m_metrics.on_session_lost(); }
+
+    Statistics get_statistics() const override { return {}; }
+    WindowSummary get_window_summary(std::chrono::seconds) const override { return {}; }
+    PipelineStatistics get_pipeline_statistics() const override { return {}; }
+    const ListenerMetrics & get_metrics() const override { return m_metrics; }
+    void set_silent(const bool silent) override { m_metrics.set_silent(silent); }
+    const BookManager & get_books() const override { return m_books; }
+
+private:
+    ListenerMetrics m_metrics;
+    BookManager m_books;
+};
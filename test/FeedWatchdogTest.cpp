@@ -0,0 +1,39 @@
+#include "../src/FeedWatchdog.h"
+#include "FakeListener.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(FeedWatchdogTest, quiet_feed_becomes_stale_and_recovers) {
+    auto quiet = std::make_shared<FakeListener>();
+    auto busy = std::make_shared<FakeListener>();
+    std::atomic<int> stale = 0;
+    std::atomic<int> recovered = 0;
+    const auto handler = [&] (const IJsonDataListener &, const FeedEvent e) {
+        (e == FeedEvent::Stale ? stale : recovered)++;
+    };
+
+    FeedWatchdog watchdog(50ms, 5ms);
+    watchdog.add_listener(quiet, handler);
+    watchdog.add_listener(busy, handler);
+    watchdog.start();
+
+    for (int i = 0; i < 30; ++i) {
+        busy->process("{}");
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_TRUE(quiet->get_metrics().is_silent());
+    ASSERT_FALSE(busy->get_metrics().is_silent());
+    ASSERT_EQ(stale, 1);
+    ASSERT_EQ(recovered, 0);
+
+    quiet->process("{}");
+    std::this_thread::sleep_for(30ms);
+    ASSERT_FALSE(quiet->get_metrics().is_silent());
+    ASSERT_EQ(recovered, 1);
+    watchdog.stop();
+}
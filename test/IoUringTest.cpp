@@ -0,0 +1,119 @@
+#include "../src/IoUring.h"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/error.hpp>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace {
+
+class IoUringTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, m_fds), 0);
+        try {
+            m_receiver = std::make_unique<uring::Receiver>(4, 8);
+        } catch (const std::system_error & e) {
+            GTEST_SKIP() << "io_uring is not available: " << e.what();
+        }
+    }
+
+    void TearDown() override
+    {
+        m_receiver.reset();
+        close(m_fds[0]);
+        if (m_fds[1] >= 0) {
+            close(m_fds[1]);
+        }
+    }
+
+    void send(const std::string & data)
+    {
+        ASSERT_EQ(write(m_fds[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    }
+
+    // Waits for completions the way the io_context does, by a poll of the ring fd
+    bool wait()
+    {
+        pollfd p{m_receiver->fd(), POLLIN, 0};
+        return poll(&p, 1, 1000) == 1;
+    }
+
+    std::string receive_all(boost::system::error_code & ec)
+    {
+        std::string ret;
+        char buffer[5];
+        while (const auto size = m_receiver->receive(buffer, sizeof(buffer), ec)) {
+            ret.append(buffer, size);
+        }
+        return ret;
+    }
+
+    int m_fds[2] = {-1, -1};
+    std::unique_ptr<uring::Receiver> m_receiver;
+};
+
+}
+
+TEST_F(IoUringTest, receives_through_ring) {
+    boost::system::error_code ec;
+    m_receiver->start(m_fds[0], ec);
+    ASSERT_FALSE(ec) << ec.message();
+    char buffer[16];
+    ASSERT_EQ(m_receiver->receive(buffer, sizeof(buffer), ec), 0u);
+    ASSERT_EQ(ec, boost::asio::error::would_block);
+    ASSERT_FALSE(m_receiver->ready());
+
+    send("hello world");
+    ASSERT_TRUE(wait());
+    ASSERT_TRUE(m_receiver->ready());
+    // smaller reads than buffers take the rest of a buffer later
+    ASSERT_EQ(receive_all(ec), "hello world");
+    ASSERT_EQ(ec, boost::asio::error::would_block);
+}
+
+TEST_F(IoUringTest, goes_on_after_buffers_ran_out) {
+    boost::system::error_code ec;
+    m_receiver->start(m_fds[0], ec);
+    ASSERT_FALSE(ec) << ec.message();
+    // 4 buffers of 8 bytes are not enough, the receive stops and is armed again
+    std::string data;
+    for (int i = 0; i < 100; ++i) {
+        data += std::to_string(i) + ',';
+    }
+    send(data);
+    std::string received;
+    while (received.size() < data.size() && wait()) {
+        received += receive_all(ec);
+        ASSERT_EQ(ec, boost::asio::error::would_block);
+    }
+    ASSERT_EQ(received, data);
+}
+
+TEST_F(IoUringTest, eof_after_data) {
+    boost::system::error_code ec;
+    m_receiver->start(m_fds[0], ec);
+    ASSERT_FALSE(ec) << ec.message();
+    send("bye");
+    close(m_fds[1]);
+    m_fds[1] = -1;
+    ASSERT_TRUE(wait());
+    std::string received;
+    while (!ec || ec == boost::asio::error::would_block) {
+        received += receive_all(ec);
+        if (ec == boost::asio::error::would_block) {
+            ASSERT_TRUE(wait());
+        }
+    }
+    ASSERT_EQ(received, "bye");
+    ASSERT_EQ(ec, boost::asio::error::eof);
+}
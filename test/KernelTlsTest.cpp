@@ -0,0 +1,112 @@
+#include "../src/KernelTls.h"
+
+#include <gtest/gtest.h>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using SslCtxPtr = std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)>;
+using SslPtr = std::unique_ptr<SSL, decltype(&SSL_free)>;
+
+void use_self_signed_certificate(SSL_CTX * ctx)
+{
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> pctx(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free);
+    EVP_PKEY * raw_key = nullptr;
+    ASSERT_GT(EVP_PKEY_keygen_init(pctx.get()), 0);
+    ASSERT_GT(EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx.get(), NID_X9_62_prime256v1), 0);
+    ASSERT_GT(EVP_PKEY_keygen(pctx.get(), &raw_key), 0);
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(raw_key, EVP_PKEY_free);
+
+    std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+    X509_set_version(cert.get(), 2);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 3600L);
+    X509_set_pubkey(cert.get(), key.get());
+    ASSERT_TRUE(X509_sign(cert.get(), key.get(), EVP_sha256()));
+    ASSERT_EQ(SSL_CTX_use_certificate(ctx, cert.get()), 1);
+    ASSERT_EQ(SSL_CTX_use_PrivateKey(ctx, key.get()), 1);
+}
+
+// Moves what one side has written to the other one
+void transfer(SSL * from, SSL * to)
+{
+    char buffer[16 * 1024];
+    int size = 0;
+    while ((size = BIO_read(SSL_get_wbio(from), buffer, sizeof(buffer))) > 0) {
+        BIO_write(SSL_get_rbio(to), buffer, size);
+    }
+}
+
+// Decrypts the first record sent with keys as the kernel would, returns its content type and plain text
+std::string open_record(const ktls::TrafficKeys & keys, const std::vector<uint8_t> & record)
+{
+    const auto * cipher = keys.cipher_suite == 0x1301 ? EVP_aes_128_gcm() : keys.cipher_suite == 0x1302 ? EVP_aes_256_gcm() : EVP_chacha20_poly1305();
+    constexpr size_t header_size = 5;
+    constexpr size_t tag_size = 16;
+    std::vector<uint8_t> tag(record.end() - tag_size, record.end());
+    std::string plain(record.size() - header_size - tag_size, '\0');
+
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    int size = 0;
+    // the nonce of the first record is the iv itself, the sequence number is zero
+    EVP_DecryptInit_ex(ctx.get(), cipher, nullptr, keys.key.data(), keys.iv.data());
+    EVP_DecryptUpdate(ctx.get(), nullptr, &size, record.data(), header_size);
+    EVP_DecryptUpdate(ctx.get(), reinterpret_cast<unsigned char *>(plain.data()), &size, record.data() + header_size, plain.size());
+    EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, tag_size, tag.data());
+    if (EVP_DecryptFinal_ex(ctx.get(), nullptr, &size) <= 0) {
+        return {};
+    }
+    return plain;
+}
+
+}
+
+TEST(KernelTlsTest, derives_keys_of_server_records) {
+    for (const auto suite : {"TLS_AES_128_GCM_SHA256", "TLS_AES_256_GCM_SHA384", "TLS_CHACHA20_POLY1305_SHA256"}) {
+        SslCtxPtr server_ctx(SSL_CTX_new(TLS_server_method()), SSL_CTX_free);
+        SslCtxPtr client_ctx(SSL_CTX_new(TLS_client_method()), SSL_CTX_free);
+        use_self_signed_certificate(server_ctx.get());
+        SSL_CTX_set_ciphersuites(server_ctx.get(), suite);
+        SSL_CTX_set_ciphersuites(client_ctx.get(), suite);
+        SSL_CTX_set_num_tickets(server_ctx.get(), 0);
+        ktls::capture_secrets(client_ctx.get());
+
+        SslPtr server(SSL_new(server_ctx.get()), SSL_free);
+        SslPtr client(SSL_new(client_ctx.get()), SSL_free);
+        SSL_set_bio(server.get(), BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+        SSL_set_bio(client.get(), BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+        SSL_set_accept_state(server.get());
+        SSL_set_connect_state(client.get());
+        for (int i = 0; i < 10 && (!SSL_is_init_finished(client.get()) || !SSL_is_init_finished(server.get())); ++i) {
+            SSL_do_handshake(client.get());
+            transfer(client.get(), server.get());
+            SSL_do_handshake(server.get());
+            transfer(server.get(), client.get());
+        }
+        ASSERT_TRUE(SSL_is_init_finished(client.get())) << suite;
+
+        ktls::TrafficKeys keys;
+        ASSERT_TRUE(ktls::server_keys(client.get(), keys)) << suite;
+        ASSERT_EQ(SSL_write(server.get(), "hello", 5), 5);
+        std::vector<uint8_t> record(1024);
+        record.resize(std::max(BIO_read(SSL_get_wbio(server.get()), record.data(), record.size()), 0));
+        ASSERT_GT(record.size(), 5u);
+        // TLS 1.3 inner plain text ends with the real content type, application data
+        ASSERT_EQ(open_record(keys, record), std::string("hello\x17")) << suite;
+    }
+}
+
+TEST(KernelTlsTest, no_keys_without_captured_secret) {
+    SslCtxPtr ctx(SSL_CTX_new(TLS_client_method()), SSL_CTX_free);
+    SslPtr ssl(SSL_new(ctx.get()), SSL_free);
+    ktls::TrafficKeys keys;
+    ASSERT_FALSE(ktls::server_keys(ssl.get(), keys));
+}
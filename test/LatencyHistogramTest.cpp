@@ -0,0 +1,60 @@
+#include "../src/LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+TEST(LatencyHistogramTest, empty_histogram) {
+    LatencyHistogram h;
+    ASSERT_TRUE(h.empty());
+    ASSERT_EQ(h.count(), 0);
+    ASSERT_EQ(h.percentile(0.5), 0);
+    ASSERT_EQ(h.min(), 0);
+}
+
+TEST(LatencyHistogramTest, bucket_bounds_are_contiguous) {
+    for (size_t idx = 1; idx < LatencyHistogram::buckets_num - 1; ++idx) {
+        const auto upper = LatencyHistogram::bucket_upper_bound(idx);
+        ASSERT_EQ(LatencyHistogram::bucket_index(upper), idx);
+        ASSERT_EQ(LatencyHistogram::bucket_index(upper + 1), idx + 1);
+    }
+}
+
+TEST(LatencyHistogramTest, small_values_are_exact) {
+    LatencyHistogram h;
+    for (uint64_t v = 0; v < LatencyHistogram::sub_buckets; ++v) {
+        h.add(v);
+    }
+    ASSERT_EQ(h.min(), 0);
+    ASSERT_EQ(h.max(), LatencyHistogram::sub_buckets - 1);
+    ASSERT_EQ(h.percentile(0.5), LatencyHistogram::sub_buckets / 2 - 1);
+}
+
+TEST(LatencyHistogramTest, percentile_relative_error) {
+    LatencyHistogram h;
+    for (uint64_t v = 1; v <= 100000; ++v) {
+        h.add(v);
+    }
+    ASSERT_EQ(h.count(), 100000);
+    ASSERT_EQ(h.avg(), 50000);
+    ASSERT_NEAR(h.percentile(0.5), 50000, 50000 * 0.125);
+    ASSERT_NEAR(h.percentile(0.99), 99000, 99000 * 0.125);
+    ASSERT_EQ(h.percentile(1), 100000);
+}
+
+TEST(LatencyHistogramTest, huge_values_are_clamped) {
+    LatencyHistogram h;
+    h.add(std::numeric_limits<uint64_t>::max());
+    ASSERT_EQ(LatencyHistogram::bucket_index(std::numeric_limits<uint64_t>::max()), LatencyHistogram::buckets_num - 1);
+    ASSERT_EQ(h.percentile(0.5), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(LatencyHistogramTest, merge) {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    a.add(10);
+    b.add(1000);
+    a.merge(b);
+    ASSERT_EQ(a.count(), 2);
+    ASSERT_EQ(a.min(), 10);
+    ASSERT_EQ(a.max(), 1000);
+    ASSERT_EQ(a.percentile(0.5), 10);
+}
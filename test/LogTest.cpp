@@ -0,0 +1,173 @@
+#include "../src/AsyncLogger.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using logging::AsyncLogger;
+
+namespace {
+
+// Output file of a logger, read back once the logger is flushed or destroyed
+class LogFile
+{
+public:
+    LogFile()
+        : m_file(std::tmpfile(), &std::fclose)
+    { }
+
+    std::FILE * get() const { return m_file.get(); }
+
+    // Messages without the timestamp, file and line prefix
+    std::vector<std::string> messages() const
+    {
+        std::fflush(get());
+        std::rewind(get());
+        std::string content;
+        char buf[4096];
+        while (const auto n = std::fread(buf, 1, sizeof(buf), get())) {
+            content.append(buf, n);
+        }
+        std::vector<std::string> ret;
+        std::istringstream strm(content);
+        for (std::string line; std::getline(strm, line);) {
+            const auto prefix_end = line.find("): ");
+            ret.push_back(prefix_end == std::string::npos ? line : line.substr(prefix_end + 3));
+        }
+        std::fseek(get(), 0, SEEK_END);
+        return ret;
+    }
+
+private:
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> m_file;
+};
+
+void push(AsyncLogger & logger, const std::string & message)
+{
+    logger.push(__FILE__, __LINE__, message.data(), message.size());
+}
+
+// Distinct content of the given length, so a misplaced chunk shows up
+std::string make_message(const size_t n, const size_t length)
+{
+    std::string ret = std::to_string(n) + ':';
+    while (ret.size() < length) {
+        ret += static_cast<char>('a' + (n + ret.size()) % 26);
+    }
+    return ret;
+}
+
+}
+
+TEST(LogTest, records_wrap_around_the_ring) {
+    LogFile file;
+    std::vector<std::string> expected;
+    {
+        AsyncLogger logger(16, file.get());
+        // single slot records go around the ring many times
+        for (size_t i = 0; i < 100; ++i) {
+            expected.push_back(make_message(i, 10));
+            push(logger, expected.back());
+            logger.flush();
+        }
+    }
+    ASSERT_EQ(file.messages(), expected);
+}
+
+TEST(LogTest, multi_slot_records_are_reassembled) {
+    LogFile file;
+    std::vector<std::string> expected;
+    {
+        AsyncLogger logger(64, file.get());
+        // up to 8 slots per record, at every offset of the ring
+        for (size_t i = 0; i < 200; ++i) {
+            expected.push_back(make_message(i, (i * 37) % (8 * AsyncLogger::payload_size - 24)));
+            push(logger, expected.back());
+            logger.flush();
+        }
+    }
+    ASSERT_EQ(file.messages(), expected);
+}
+
+TEST(LogTest, records_are_dropped_and_counted_when_ring_is_full) {
+    LogFile file;
+    constexpr size_t pushed = 10000;
+    {
+        AsyncLogger logger(16, file.get());
+        for (size_t i = 0; i < pushed; ++i) {
+            push(logger, make_message(i, 10));
+        }
+    }
+    const auto messages = file.messages();
+    size_t written = 0;
+    size_t dropped = 0;
+    const std::string dropped_prefix = "log ring is full, dropped records: ";
+    for (const auto & m : messages) {
+        if (m.rfind(dropped_prefix, 0) == 0) {
+            dropped += std::stoul(m.substr(dropped_prefix.size()));
+        } else {
+            ++written;
+        }
+    }
+    EXPECT_GT(dropped, 0u);
+    EXPECT_EQ(written + dropped, pushed);
+}
+
+TEST(LogTest, oversized_record_is_written_in_order) {
+    LogFile file;
+    const auto oversized = make_message(1, 2 * 8 * AsyncLogger::payload_size);
+    {
+        AsyncLogger logger(64, file.get());
+        push(logger, "before");
+        push(logger, oversized);
+        push(logger, "after");
+        logger.flush();
+        ASSERT_EQ(file.messages(), (std::vector<std::string>{"before", oversized, "after"}));
+    }
+}
+
+TEST(LogTest, pending_records_are_written_at_shutdown) {
+    LogFile file;
+    std::vector<std::string> expected;
+    {
+        AsyncLogger logger(1024, file.get());
+        for (size_t i = 0; i < 100; ++i) {
+            expected.push_back(make_message(i, 50));
+            push(logger, expected.back());
+        }
+    }
+    ASSERT_EQ(file.messages(), expected);
+}
+
+TEST(LogTest, concurrent_producers_keep_their_order) {
+    LogFile file;
+    constexpr size_t threads_num = 4;
+    constexpr size_t per_thread = 1000;
+    {
+        AsyncLogger logger(AsyncLogger::default_slots_num, file.get());
+        std::vector<std::thread> producers;
+        for (size_t t = 0; t < threads_num; ++t) {
+            producers.emplace_back([&logger, t] {
+                for (size_t i = 0; i < per_thread; ++i) {
+                    push(logger, std::to_string(t) + ' ' + make_message(i, 1 + i % 300));
+                }
+            });
+        }
+        for (auto & p : producers) {
+            p.join();
+        }
+    }
+    std::vector<size_t> next(threads_num, 0);
+    for (const auto & m : file.messages()) {
+        const auto t = std::stoul(m);
+        ASSERT_LT(t, threads_num) << m;
+        ASSERT_EQ(m, std::to_string(t) + ' ' + make_message(next[t], 1 + next[t] % 300));
+        ++next[t];
+    }
+    ASSERT_EQ(next, std::vector<size_t>(threads_num, per_thread));
+}
@@ -0,0 +1,67 @@
+#include "../src/OrderBookRenderer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace {
+
+size_t count_rows(const std::string_view out)
+{
+    // header and column titles come first
+    return std::count(out.begin(), out.end(), '\n') - 1;
+}
+
+}
+
+TEST(OrderBookRendererTest, first_render_is_full) {
+    OrderBook ob;
+    ob.insert_replace(100, 1.5, OrderBook::Side::Bid);
+    ob.insert_replace(99, 2, OrderBook::Side::Bid);
+    ob.insert_replace(101, 3, OrderBook::Side::Ask);
+
+    OrderBookRenderer renderer(5);
+    const std::string out(renderer.render(ob));
+    ASSERT_EQ(count_rows(out), 2);
+    ASSERT_NE(out.find("1.5@100 "), std::string::npos);
+    ASSERT_NE(out.find("<empty>"), std::string::npos);
+}
+
+TEST(OrderBookRendererTest, only_changed_rows_are_rendered) {
+    OrderBook ob;
+    for (int i = 0; i < 10; ++i) {
+        ob.insert_replace(100 - i, 1, OrderBook::Side::Bid);
+        ob.insert_replace(101 + i, 1, OrderBook::Side::Ask);
+    }
+    OrderBookRenderer renderer(5);
+    renderer.render(ob);
+    ASSERT_EQ(count_rows(renderer.render(ob)), 0);
+
+    ob.insert_replace(98, 7, OrderBook::Side::Bid);
+    std::string out(renderer.render(ob));
+    ASSERT_EQ(count_rows(out), 1);
+    ASSERT_NE(out.find("    2 ||"), std::string::npos);
+    ASSERT_NE(out.find("7@98 "), std::string::npos);
+
+    // changes below the rendered levels are not shown
+    ob.insert_replace(90, 7, OrderBook::Side::Bid);
+    ASSERT_EQ(count_rows(renderer.render(ob)), 0);
+
+    // removing the best bid shifts every bid row
+    ob.insert_replace(100, 0, OrderBook::Side::Bid);
+    ASSERT_EQ(count_rows(renderer.render(ob)), 5);
+    ASSERT_EQ(count_rows(renderer.render_full(ob)), 5);
+}
+
+TEST(OrderBookRendererTest, shrinking_book_renders_empty_rows) {
+    OrderBook ob;
+    ob.insert_replace(100, 1, OrderBook::Side::Bid);
+    ob.insert_replace(99, 1, OrderBook::Side::Bid);
+    OrderBookRenderer renderer(5);
+    renderer.render(ob);
+
+    ob.insert_replace(99, 0, OrderBook::Side::Bid);
+    const std::string out(renderer.render(ob));
+    ASSERT_EQ(count_rows(out), 1);
+    ASSERT_NE(out.find("<empty>"), std::string::npos);
+}
@@ -2,6 +2,9 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <sstream>
+
 #define ENABLE_DEBUG_PRINT
 
 #ifdef ENABLE_DEBUG_PRINT
@@ -318,4 +321,129 @@ TEST(OrderBookTest, remove_last_ask_lvl) {
     ASSERT_EQ(asks.size(), 2);
     ASSERT_DOUBLE_EQ(asks[0].price, 0.1);
     ASSERT_DOUBLE_EQ(asks[1].price, 0.15);
-}
\ No newline at end of file
+}
+
+TEST(OrderBookTest, reserved_depth_avoids_reallocations) {
+    OrderBook grown;
+    OrderBook reserved;
+    reserved.configure({100, 0});
+    for (int i = 0; i < 100; ++i) {
+        grown.insert_replace(100 - i, 1, OrderBook::Side::Bid);
+        reserved.insert_replace(100 - i, 1, OrderBook::Side::Bid);
+    }
+    ASSERT_GT(grown.get_reallocations(), 0);
+    ASSERT_EQ(reserved.get_reallocations(), 0);
+}
+
+TEST(OrderBookTest, max_depth_moves_deep_levels_to_cold_store) {
+    OrderBook ob;
+    ob.configure({10, 3});
+    for (int i = 1; i <= 5; ++i) {
+        ob.insert_replace(i, 1, OrderBook::Side::Bid);
+        ob.insert_replace(10 + i, 1, OrderBook::Side::Ask);
+    }
+    DEBUG_PRINT(ob);
+    ASSERT_EQ(ob.get_bids().size(), 3);
+    ASSERT_EQ(ob.get_bids_depth(), 5);
+    ASSERT_DOUBLE_EQ(ob.get_bids()[2].price, 3);
+    ASSERT_EQ(ob.get_asks().size(), 3);
+    ASSERT_DOUBLE_EQ(ob.get_asks()[2].price, 13);
+
+    // a level deep in the cold store changes without touching the hot levels
+    ob.insert_replace(1, 7, OrderBook::Side::Bid);
+    ASSERT_DOUBLE_EQ(ob.get_bids()[2].price, 3);
+
+    // removing a hot level promotes the best cold one
+    ob.insert_replace(4, 0, OrderBook::Side::Bid);
+    ASSERT_EQ(ob.get_bids().size(), 3);
+    ASSERT_DOUBLE_EQ(ob.get_bids()[2].price, 2);
+    ASSERT_EQ(ob.get_bids_depth(), 4);
+
+    const auto full = ob.copy_top(-1);
+    ASSERT_EQ(full.get_bids().size(), 4);
+    ASSERT_DOUBLE_EQ(full.get_bids()[3].price, 1);
+    ASSERT_DOUBLE_EQ(full.get_bids()[3].volume, 7);
+    ASSERT_EQ(full.get_asks().size(), 5);
+    ASSERT_DOUBLE_EQ(full.get_asks()[4].price, 15);
+    ASSERT_EQ(ob.get_reallocations(), 0);
+}
+
+TEST(OrderBookTest, print_shows_cold_levels) {
+    OrderBook ob;
+    ob.configure({10, 1});
+    for (int i = 1; i <= 3; ++i) {
+        ob.insert_replace(i, 1, OrderBook::Side::Bid);
+    }
+    ASSERT_EQ(ob.get_bids().size(), 1);
+    ASSERT_FALSE(ob.empty());
+
+    std::ostringstream oss;
+    ob.print(oss);
+    const auto out = oss.str();
+    ASSERT_NE(out.find("BIDS: 3"), std::string::npos) << out;
+    ASSERT_NE(out.find("1@1 "), std::string::npos) << out;
+}
+
+TEST(OrderBookTest, printing_keeps_stream_format) {
+    OrderBook ob;
+    ob.configure({10, 0, 1});
+    ob.insert_replace(100.125, 1, OrderBook::Side::Bid);
+    ob.insert_replace(100.5, 2, OrderBook::Side::Ask);
+
+    std::ostringstream oss;
+    oss.precision(2);
+    oss << ob << ob.get_analytics();
+    ASSERT_EQ(oss.precision(), 2);
+    ASSERT_FALSE(oss.flags() & std::ios_base::left);
+}
+
+TEST(OrderBookTest, analytics_need_both_sides) {
+    OrderBook ob;
+    ob.configure({0, 0, 5});
+    ob.insert_replace(1, 1, OrderBook::Side::Bid);
+    ASSERT_FALSE(ob.get_analytics().valid);
+    ob.insert_replace(3, 3, OrderBook::Side::Ask);
+    const auto a = ob.get_analytics();
+    ASSERT_TRUE(a.valid);
+    ASSERT_DOUBLE_EQ(a.mid, 2);
+    ASSERT_DOUBLE_EQ(a.spread, 2);
+    ASSERT_DOUBLE_EQ(a.microprice, 1.5); // (1 * 3 + 3 * 1) / 4, pulled to the bid by the bigger ask
+    ASSERT_DOUBLE_EQ(a.imbalance, -0.5);
+}
+
+TEST(OrderBookTest, incremental_analytics_match_full_recomputation) {
+    for (const size_t max_depth : {0, 5, 8}) {
+        OrderBook ob;
+        ob.configure({0, max_depth, 5});
+        std::mt19937 rng(max_depth);
+        std::uniform_int_distribution<int> level(1, 30);
+        std::uniform_int_distribution<int> volume(0, 3); // a quarter of updates remove levels
+        for (int i = 0; i < 5000; ++i) {
+            const auto lvl = level(rng);
+            ob.insert_replace(100 - lvl, volume(rng), OrderBook::Side::Bid);
+            ob.insert_replace(100 + lvl, volume(rng), OrderBook::Side::Ask);
+
+            const auto a = ob.get_analytics();
+            const auto top = ob.copy_top(5);
+            if (top.get_bids().empty() || top.get_asks().empty()) {
+                ASSERT_FALSE(a.valid);
+                continue;
+            }
+            double bid_volume = 0, bid_notional = 0, ask_volume = 0, ask_notional = 0;
+            for (const auto & l : top.get_bids()) {
+                bid_volume += l.volume;
+                bid_notional += l.price * l.volume;
+            }
+            for (const auto & l : top.get_asks()) {
+                ask_volume += l.volume;
+                ask_notional += l.price * l.volume;
+            }
+            ASSERT_TRUE(a.valid);
+            ASSERT_NEAR(a.bid_volume, bid_volume, 1e-9) << "update " << i << ", max depth " << max_depth;
+            ASSERT_NEAR(a.ask_volume, ask_volume, 1e-9) << "update " << i << ", max depth " << max_depth;
+            ASSERT_NEAR(a.bid_vwap, bid_notional / bid_volume, 1e-9);
+            ASSERT_NEAR(a.ask_vwap, ask_notional / ask_volume, 1e-9);
+            ASSERT_NEAR(a.imbalance, (bid_volume - ask_volume) / (bid_volume + ask_volume), 1e-9);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "../src/ArrivalLog.h"
+#include "../src/ArrivalRace.h"
+#include "../src/RankingPolicy.h"
+#include "FakeListener.h"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+WindowSummary summary(const uint64_t p99_us)
+{
+    WindowSummary s;
+    s.count = s.timed = 100;
+    s.p50_us = s.avg_us = s.p99_us = p99_us;
+    return s;
+}
+
+EndpointRanker::Candidate candidate(const std::string & host, const WindowSummary & s)
+{
+    return {host, {}, s, std::make_shared<FakeListener>(), {}};
+}
+
+}
+
+TEST(WindowedStatisticsTest, old_values_leave_window) {
+    WindowedStatistics w;
+    const WindowedStatistics::Clock::time_point t0(1000000s);
+    w.add(t0, 100us, true);
+    w.add(t0 + 5s, 200us, false);
+
+    ASSERT_EQ(w.summary(10s, t0 + 5s).count, 2);
+    ASSERT_EQ(w.summary(10s, t0 + 5s).win_rate, 0.5);
+    ASSERT_EQ(w.summary(10s, t0 + 12s).count, 1);
+    ASSERT_EQ(w.summary(10s, t0 + 20s).count, 0);
+    // longer windows are served by coarser slots
+    ASSERT_EQ(w.summary(300s, t0 + 200s).count, 2);
+    ASSERT_EQ(w.summary(300s, t0 + 400s).count, 0);
+}
+
+TEST(WindowedStatisticsTest, updates_without_event_time_count_for_wins_only) {
+    WindowedStatistics w;
+    const WindowedStatistics::Clock::time_point t0(1000000s);
+    w.add(t0, true);
+    w.add(t0, false);
+
+    const auto s = w.summary(10s, t0);
+    ASSERT_EQ(s.count, 2);
+    ASSERT_EQ(s.timed, 0);
+    ASSERT_EQ(s.win_rate, 0.5);
+    // latency policies put such windows after measured ones
+    ASSERT_GT(make_ranking_policy("p99")->score(s), make_ranking_policy("p99")->score(summary(1000000)));
+    ASSERT_EQ(make_ranking_policy("win-rate")->score(s), -0.5);
+}
+
+TEST(ArrivalRaceTest, first_arrival_wins) {
+    ArrivalRace race;
+    ASSERT_TRUE(race.arrive(10));
+    ASSERT_FALSE(race.arrive(10));
+    ASSERT_TRUE(race.arrive(11));
+    ASSERT_FALSE(race.arrive(11));
+    // a listener lagging by a whole ring loses the slot to newer ids
+    ASSERT_TRUE(race.arrive(12 + ArrivalRace::slots_num));
+    ASSERT_FALSE(race.arrive(12));
+}
+
+TEST(ArrivalLogTest, finds_first_message_covering_id) {
+    ArrivalLog log;
+    log.add(10, 100);
+    log.add(20, 200);
+    log.add(15, 250); // not above the last id
+    log.add(30, 300);
+
+    ASSERT_EQ(log.frontier(), 30);
+    ASSERT_EQ(log.covered_at(10), 0); // the first message covers all before the log started
+    ASSERT_EQ(log.covered_at(11), 200);
+    ASSERT_EQ(log.covered_at(20), 200);
+    ASSERT_EQ(log.covered_at(21), 300);
+    ASSERT_EQ(log.covered_at(31), 0);
+
+    std::vector<uint64_t> ids;
+    log.collect_ids(10, 20, ids);
+    ASSERT_EQ(ids, std::vector<uint64_t>{20});
+}
+
+TEST(EndpointRankerTest, empty_windows_are_last) {
+    EndpointRanker ranker(make_ranking_policy("p99"), 60s, 0);
+    std::vector<EndpointRanker::Candidate> c{candidate("a", {}), candidate("b", summary(300)), candidate("c", {}), candidate("d", summary(100))};
+    ASSERT_EQ(ranker.rank(c), 0);
+    ASSERT_EQ(c[0].host, "d");
+    ASSERT_EQ(c[1].host, "b");
+    ASSERT_TRUE(c[2].window.empty());
+    ASSERT_TRUE(c[3].window.empty());
+
+    std::vector<EndpointRanker::Candidate> all_empty{candidate("a", {}), candidate("b", {})};
+    ASSERT_EQ(ranker.rank(all_empty), all_empty.size());
+}
+
+TEST(EndpointRankerTest, hysteresis_keeps_current_best) {
+    EndpointRanker ranker(make_ranking_policy("p99"), 60s, 0.1);
+    std::vector<EndpointRanker::Candidate> c{candidate("a", summary(100)), candidate("b", summary(105))};
+    const auto a = c[0].listener;
+    const auto b = c[1].listener;
+    ASSERT_EQ(ranker.rank(c), 0);
+
+    // b is better, but not by 10%
+    c = {{"a", {}, summary(100), a, {}}, {"b", {}, summary(95), b, {}}};
+    const auto best = ranker.rank(c);
+    ASSERT_EQ(c[best].host, "a");
+    ASSERT_EQ(c[0].host, "b");
+
+    c = {{"a", {}, summary(100), a, {}}, {"b", {}, summary(80), b, {}}};
+    ASSERT_EQ(c[ranker.rank(c)].host, "b");
+}
+
+TEST(EndpointRankerTest, win_rate_prefers_more_wins) {
+    EndpointRanker ranker(make_ranking_policy("win-rate"), 60s, 0.1);
+    auto fast = summary(500);
+    fast.win_rate = 0.9;
+    auto slow = summary(100);
+    slow.win_rate = 0.1;
+    std::vector<EndpointRanker::Candidate> c{candidate("slow", slow), candidate("fast", fast)};
+    ASSERT_EQ(c[ranker.rank(c)].host, "fast");
+    ASSERT_THROW(make_ranking_policy("fastest"), std::invalid_argument);
+}
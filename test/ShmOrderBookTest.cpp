@@ -0,0 +1,95 @@
+#include "../src/ShmOrderBookPublisher.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+std::string unique_name(const char * suffix)
+{
+    return "/binance_ip_lookup_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+// publisher only compares source identity, never dereferences it
+const IJsonDataListener * fake_source(const uintptr_t id)
+{
+    return reinterpret_cast<const IJsonDataListener *>(id);
+}
+
+}
+
+TEST(ShmOrderBookTest, nothing_published_yet) {
+    const auto name = unique_name("empty");
+    ShmOrderBookPublisher publisher(name, 5);
+    shm_book::Reader reader(name);
+    shm_book::Snapshot s;
+    ASSERT_FALSE(reader.read(s));
+    ASSERT_EQ(reader.depth(), 5);
+}
+
+TEST(ShmOrderBookTest, only_source_publishes) {
+    const auto name = unique_name("source");
+    ShmOrderBookPublisher publisher(name, 2);
+    shm_book::Reader reader(name);
+
+    OrderBook ob;
+    ob.insert_replace(100, 1, OrderBook::Side::Bid);
+    ob.insert_replace(99, 2, OrderBook::Side::Bid);
+    ob.insert_replace(98, 3, OrderBook::Side::Bid);
+    ob.insert_replace(101, 4, OrderBook::Side::Ask);
+
+    const std::vector<LevelChange> changes;
+    ASSERT_FALSE(publisher.publish(fake_source(1), {10, std::chrono::milliseconds(1000), ob, changes}));
+    publisher.set_source(fake_source(1), "127.0.0.1");
+    ASSERT_FALSE(publisher.publish(fake_source(2), {10, std::chrono::milliseconds(1000), ob, changes}));
+    ASSERT_TRUE(publisher.publish(fake_source(1), {11, std::chrono::milliseconds(1001), ob, changes}));
+
+    shm_book::Snapshot s;
+    ASSERT_TRUE(reader.read(s));
+    ASSERT_EQ(s.update_id, 11);
+    ASSERT_EQ(s.event_time_ms, 1001);
+    ASSERT_STREQ(s.source, "127.0.0.1");
+    ASSERT_EQ(s.bids_num, 2);
+    ASSERT_EQ(s.asks_num, 1);
+    ASSERT_EQ(s.bids[0].price, 100);
+    ASSERT_EQ(s.bids[1].price, 99);
+    ASSERT_EQ(s.asks[0].volume, 4);
+}
+
+TEST(ShmOrderBookTest, reader_never_sees_torn_snapshot) {
+    const auto name = unique_name("torn");
+    ShmOrderBookPublisher publisher(name, shm_book::max_depth);
+    publisher.set_source(fake_source(1), "writer");
+    shm_book::Reader reader(name);
+
+    std::atomic<bool> done = false;
+    std::thread writer([&] {
+        OrderBook ob;
+        const std::vector<LevelChange> changes;
+        for (uint64_t id = 1; id <= 20000; ++id) {
+            for (size_t lvl = 0; lvl < shm_book::max_depth; ++lvl) {
+                ob.insert_replace(1000.0 - lvl, static_cast<double>(id), OrderBook::Side::Bid);
+            }
+            publisher.publish(fake_source(1), {id, std::chrono::milliseconds(id), ob, changes});
+        }
+        done = true;
+    });
+
+    shm_book::Snapshot s;
+    while (!done) {
+        if (!reader.read(s)) {
+            continue;
+        }
+        ASSERT_EQ(s.bids_num, shm_book::max_depth);
+        for (size_t lvl = 0; lvl < s.bids_num; ++lvl) {
+            ASSERT_EQ(s.bids[lvl].volume, static_cast<double>(s.update_id));
+        }
+    }
+    writer.join();
+    ASSERT_TRUE(reader.read(s));
+    ASSERT_EQ(s.update_id, 20000);
+}